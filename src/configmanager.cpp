@@ -217,6 +217,8 @@ bool ConfigManager::load()
 		integer[HTTP_WORKERS] = getGlobalNumber(L, "httpWorkers", 1);
 
 		integer[MARKET_OFFER_DURATION] = getGlobalNumber(L, "marketOfferDuration", 30 * 24 * 60 * 60);
+		integer[DISPATCHER_WORKERS] = getGlobalNumber(L, "dispatcherWorkers", 0);
+		integer[NETWORK_THREADS] = getGlobalNumber(L, "networkThreads", 1);
 	}
 
 	boolean[ALLOW_CHANGEOUTFIT] = getGlobalBoolean(L, "allowChangeOutfit", true);
@@ -256,6 +258,8 @@ bool ConfigManager::load()
 	boolean[TWO_FACTOR_AUTH] = getGlobalBoolean(L, "enableTwoFactorAuth", true);
 	boolean[CHECK_DUPLICATE_STORAGE_KEYS] = getGlobalBoolean(L, "checkDuplicateStorageKeys", false);
 	boolean[MONSTER_OVERSPAWN] = getGlobalBoolean(L, "monsterOverspawn", false);
+	boolean[PACKET_RATE_LIMIT] = getGlobalBoolean(L, "packetRateLimit", true);
+	boolean[INCREMENTAL_SERVER_SAVE] = getGlobalBoolean(L, "incrementalServerSave", true);
 
 	string[DEFAULT_PRIORITY] = getGlobalString(L, "defaultPriority", "high");
 	string[SERVER_NAME] = getGlobalString(L, "serverName", "");
@@ -306,6 +310,10 @@ bool ConfigManager::load()
 	integer[STAMINA_REGEN_PREMIUM] = getGlobalNumber(L, "timeToRegenMinutePremiumStamina", 6 * 60);
 	integer[PATHFINDING_INTERVAL] = getGlobalNumber(L, "pathfindingInterval", 200);
 	integer[PATHFINDING_DELAY] = getGlobalNumber(L, "pathfindingDelay", 300);
+	integer[COMPRESSION_LEVEL] = getGlobalNumber(L, "compressionLevel", 6);
+	integer[COMPRESSION_TIME_PER_KB] = getGlobalNumber(L, "compressionTimePerKB", 40);
+	integer[SERVER_SAVE_TICK_BUDGET] = getGlobalNumber(L, "serverSaveTickBudget", 10);
+	integer[DATABASE_WORKERS] = getGlobalNumber(L, "databaseWorkers", 4);
 
 	expStages = loadXMLStages();
 	if (expStages.empty()) {
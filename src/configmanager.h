@@ -47,6 +47,8 @@ enum boolean_config_t
 	MANASHIELD_BREAKABLE,
 	CHECK_DUPLICATE_STORAGE_KEYS,
 	MONSTER_OVERSPAWN,
+	PACKET_RATE_LIMIT,
+	INCREMENTAL_SERVER_SAVE,
 
 	LAST_BOOLEAN_CONFIG /* this must be the last one */
 };
@@ -124,6 +126,12 @@ enum integer_config_t
 	STAMINA_REGEN_PREMIUM,
 	PATHFINDING_INTERVAL,
 	PATHFINDING_DELAY,
+	DISPATCHER_WORKERS,
+	NETWORK_THREADS,
+	COMPRESSION_LEVEL,
+	COMPRESSION_TIME_PER_KB,
+	SERVER_SAVE_TICK_BUDGET,
+	DATABASE_WORKERS,
 
 	LAST_INTEGER_CONFIG /* this must be the last one */
 };
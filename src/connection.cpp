@@ -6,11 +6,50 @@
 #include "connection.h"
 
 #include "configmanager.h"
+#include "messagepool.h"
 #include "outputmessage.h"
 #include "protocol.h"
 #include "server.h"
 #include "tasks.h"
 
+namespace {
+
+// pings, stats and most game updates fit the smaller pool classes, anything above this stays in its OutputMessage
+constexpr size_t WRITE_BLOCK_MAX_SIZE = 8192;
+
+} // namespace
+
+// WriteBuffer
+
+WriteBuffer::~WriteBuffer()
+{
+	if (block) {
+		tfs::net::release_message_block(block, length);
+	}
+}
+
+void WriteBuffer::compact()
+{
+	if (message->getLength() > WRITE_BLOCK_MAX_SIZE) {
+		return;
+	}
+
+	length = message->getLength();
+	block = static_cast<uint8_t*>(tfs::net::allocate_message_block(length));
+	std::memcpy(block, message->getOutputBuffer(), length);
+	message.reset();
+}
+
+boost::asio::const_buffer WriteBuffer::getBuffer() const
+{
+	if (block) {
+		return boost::asio::buffer(block, length);
+	}
+	return boost::asio::buffer(message->getOutputBuffer(), message->getLength());
+}
+
+// ConnectionManager
+
 Connection_ptr ConnectionManager::createConnection(boost::asio::io_context& io_context,
                                                    ConstServicePort_ptr servicePort)
 {
@@ -46,10 +85,11 @@ void ConnectionManager::closeAll()
 // Connection
 
 Connection::Connection(boost::asio::io_context& io_context, ConstServicePort_ptr service_port) :
-    readTimer(io_context),
-    writeTimer(io_context),
+    strand(boost::asio::make_strand(io_context)),
+    readTimer(strand),
+    writeTimer(strand),
     service_port(std::move(service_port)),
-    socket(io_context),
+    socket(strand),
     timeConnected(time(nullptr))
 {}
 
@@ -122,7 +162,7 @@ void Connection::accept()
 		                        ? 1
 		                        : NetworkMessage::HEADER_LENGTH;
 		boost::asio::async_read(
-		    socket, boost::asio::buffer(msg.getBuffer(), bufferLength),
+		    socket, boost::asio::buffer(header.data(), bufferLength),
 		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
 			    thisPtr->parseHeader(error);
 		    });
@@ -152,9 +192,7 @@ void Connection::parseHeader(const boost::system::error_code& error)
 	}
 
 	if (!receivedLastChar && connectionState == CONNECTION_STATE_GAMEWORLD_AUTH) {
-		uint8_t* msgBuffer = msg.getBuffer();
-
-		if (!receivedName && msgBuffer[1] == 0x00) {
+		if (!receivedName && header[1] == 0x00) {
 			receivedLastChar = true;
 		} else {
 			if (!receivedName) {
@@ -164,7 +202,7 @@ void Connection::parseHeader(const boost::system::error_code& error)
 				return;
 			}
 
-			if (msgBuffer[0] == 0x0A) {
+			if (header[0] == 0x0A) {
 				receivedLastChar = true;
 			}
 
@@ -182,7 +220,7 @@ void Connection::parseHeader(const boost::system::error_code& error)
 		packetsSent = 0;
 	}
 
-	uint16_t size = msg.getLengthHeader();
+	uint16_t size = static_cast<uint16_t>(header[0] | header[1] << 8);
 	if (size == 0 || size >= NETWORKMESSAGE_MAXSIZE - 16) {
 		close(FORCE_CLOSE);
 		return;
@@ -196,9 +234,11 @@ void Connection::parseHeader(const boost::system::error_code& error)
 		    });
 
 		// Read packet content
-		msg.setLength(size + NetworkMessage::HEADER_LENGTH);
+		msg.reset(new NetworkMessage);
+		std::memcpy(msg->getBuffer(), header.data(), NetworkMessage::HEADER_LENGTH);
+		msg->setLength(size + NetworkMessage::HEADER_LENGTH);
 		boost::asio::async_read(
-		    socket, boost::asio::buffer(msg.getBodyBuffer(), size),
+		    socket, boost::asio::buffer(msg->getBodyBuffer(), size),
 		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
 			    thisPtr->parsePacket(error);
 		    });
@@ -221,33 +261,36 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	}
 
 	// Read potential checksum bytes
-	msg.get<uint32_t>();
+	msg->get<uint32_t>();
 
 	if (!receivedFirst) {
 		receivedFirst = true;
 
 		if (!protocol) {
 			// Skip deprecated checksum bytes (with clients that aren't using it in mind)
-			uint16_t len = msg.getLength();
+			uint16_t len = msg->getLength();
 			if (len < 280 && len != 151) {
-				msg.skipBytes(-NetworkMessage::CHECKSUM_LENGTH);
+				msg->skipBytes(-NetworkMessage::CHECKSUM_LENGTH);
 			}
 
 			// Game protocol has already been created at this point
-			protocol = service_port->make_protocol(msg, shared_from_this());
+			protocol = service_port->make_protocol(*msg, shared_from_this());
 			if (!protocol) {
 				close(FORCE_CLOSE);
 				return;
 			}
 		} else {
-			msg.skipBytes(1); // Skip protocol ID
+			msg->skipBytes(1); // Skip protocol ID
 		}
 
-		protocol->onRecvFirstMessage(msg);
+		protocol->onRecvFirstMessage(*msg);
 	} else {
-		protocol->onRecvMessage(msg); // Send the packet to the current protocol
+		protocol->onRecvMessage(*msg); // Send the packet to the current protocol
 	}
 
+	// the buffer goes back to the pool while waiting for the next packet
+	msg.reset();
+
 	try {
 		readTimer.expires_after(std::chrono::seconds(CONNECTION_READ_TIMEOUT));
 		readTimer.async_wait(
@@ -257,7 +300,7 @@ void Connection::parsePacket(const boost::system::error_code& error)
 
 		// Wait to the next packet
 		boost::asio::async_read(
-		    socket, boost::asio::buffer(msg.getBuffer(), NetworkMessage::HEADER_LENGTH),
+		    socket, boost::asio::buffer(header.data(), NetworkMessage::HEADER_LENGTH),
 		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
 			    thisPtr->parseHeader(error);
 		    });
@@ -274,23 +317,47 @@ void Connection::send(const OutputMessage_ptr& msg)
 		return;
 	}
 
-	bool noPendingWrite = messageQueue.empty();
+	// the message is encoded on the strand right away, without waiting for the writes queued before it
 	messageQueue.emplace_back(msg);
-	if (noPendingWrite) {
-		try {
-			boost::asio::post(socket.get_executor(),
-			                  [thisPtr = shared_from_this(), msg] { thisPtr->internalSend(msg); });
-		} catch (const boost::system::system_error& e) {
-			std::cout << "[Network error - Connection::send] " << e.what() << std::endl;
-			messageQueue.clear();
-			close(FORCE_CLOSE);
+	try {
+		boost::asio::post(strand, [thisPtr = shared_from_this(), msg] { thisPtr->encodeMessage(msg); });
+	} catch (const boost::system::system_error& e) {
+		std::cout << "[Network error - Connection::send] " << e.what() << std::endl;
+		// the messages of a pending write must outlive it
+		while (messageQueue.size() > writingMessages) {
+			messageQueue.pop_back();
 		}
+		encodedMessages = writingMessages;
+		close(FORCE_CLOSE);
 	}
 }
 
-void Connection::internalSend(const OutputMessage_ptr& msg)
+void Connection::encodeMessage(const OutputMessage_ptr& msg)
 {
+	// compression, sequencing and encryption only touch the protocol, which is owned by the strand
 	protocol->onSendMessage(msg);
+
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	if (encodedMessages == messageQueue.size()) {
+		// dropped by an error in the meantime
+		return;
+	}
+
+	messageQueue[encodedMessages++].compact();
+	if (writingMessages == 0) {
+		internalSend();
+	}
+}
+
+void Connection::internalSend()
+{
+	// everything encoded so far leaves in a single gathered write
+	writingMessages = encodedMessages;
+	writeBuffers.clear();
+	for (size_t i = 0; i < writingMessages; ++i) {
+		writeBuffers.push_back(messageQueue[i].getBuffer());
+	}
+
 	try {
 		writeTimer.expires_after(std::chrono::seconds(CONNECTION_WRITE_TIMEOUT));
 		writeTimer.async_wait(
@@ -299,7 +366,7 @@ void Connection::internalSend(const OutputMessage_ptr& msg)
 		    });
 
 		boost::asio::async_write(
-		    socket, boost::asio::buffer(msg->getOutputBuffer(), msg->getLength()),
+		    socket, writeBuffers,
 		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
 			    thisPtr->onWriteOperation(error);
 		    });
@@ -313,17 +380,20 @@ void Connection::onWriteOperation(const boost::system::error_code& error)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
 	writeTimer.cancel();
-	messageQueue.pop_front();
+	for (; writingMessages != 0; --writingMessages, --encodedMessages) {
+		messageQueue.pop_front();
+	}
 
 	if (error) {
 		messageQueue.clear();
+		encodedMessages = 0;
 		close(FORCE_CLOSE);
 		return;
 	}
 
-	if (!messageQueue.empty()) {
-		internalSend(messageQueue.front());
-	} else if (connectionState == CONNECTION_STATE_DISCONNECTED) {
+	if (encodedMessages != 0) {
+		internalSend();
+	} else if (messageQueue.empty() && connectionState == CONNECTION_STATE_DISCONNECTED) {
 		closeSocket();
 	}
 }
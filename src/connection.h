@@ -38,6 +38,33 @@ class ServicePort;
 using ServicePort_ptr = std::shared_ptr<ServicePort>;
 using ConstServicePort_ptr = std::shared_ptr<const ServicePort>;
 
+/**
+ * An outgoing message in the write queue of a connection.
+ *
+ * Once the message is encoded, small ones are copied into a pooled block of the smallest size class that fits, so
+ * the full size OutputMessage goes back to its pool instead of being pinned until the client reads it. Larger
+ * messages are written straight from the OutputMessage.
+ */
+class WriteBuffer
+{
+public:
+	explicit WriteBuffer(OutputMessage_ptr message) : message(std::move(message)) {}
+	~WriteBuffer();
+
+	// non-copyable
+	WriteBuffer(const WriteBuffer&) = delete;
+	WriteBuffer& operator=(const WriteBuffer&) = delete;
+
+	void compact();
+
+	boost::asio::const_buffer getBuffer() const;
+
+private:
+	OutputMessage_ptr message;
+	uint8_t* block = nullptr;
+	uint16_t length = 0;
+};
+
 class ConnectionManager
 {
 public:
@@ -94,19 +121,31 @@ private:
 	static void handleTimeout(ConnectionWeak_ptr connectionWeak, const boost::system::error_code& error);
 
 	void closeSocket();
-	void internalSend(const OutputMessage_ptr& msg);
+	void encodeMessage(const OutputMessage_ptr& msg);
+	void internalSend();
 
 	boost::asio::ip::tcp::socket& getSocket() { return socket; }
 	friend class ServicePort;
 
-	NetworkMessage msg;
+	// the body buffer is only taken from the message pool while a packet is read and parsed
+	std::array<uint8_t, NetworkMessage::HEADER_LENGTH> header;
+	NetworkMessage_ptr msg;
+
+	// every handler of the socket and timers runs on this strand, whichever network thread picks it up
+	boost::asio::strand<boost::asio::io_context::executor_type> strand;
 
 	boost::asio::steady_timer readTimer;
 	boost::asio::steady_timer writeTimer;
 
+	// guards the state shared with the dispatcher, which sends and closes from outside the strand
 	std::recursive_mutex connectionLock;
 
-	std::list<OutputMessage_ptr> messageQueue;
+	// messages waiting to be written, the first encodedMessages of them are ready for the socket and the first
+	// writingMessages are being written together
+	std::deque<WriteBuffer> messageQueue;
+	std::vector<boost::asio::const_buffer> writeBuffers;
+	size_t encodedMessages = 0;
+	size_t writingMessages = 0;
 
 	ConstServicePort_ptr service_port;
 	Protocol_ptr protocol;
@@ -149,7 +149,7 @@ void Creature::forceUpdatePath()
 	}
 
 	lastPathUpdate = OTSYS_TIME() + getNumber(ConfigManager::PATHFINDING_DELAY);
-	g_dispatcher.addTask(createTask([id = getID()]() { g_game.updateCreatureWalk(id); }));
+	g_dispatcher.addTask([id = getID()]() { g_game.updateCreatureWalk(id); });
 }
 
 void Creature::onAttacking(uint32_t interval)
@@ -212,7 +212,7 @@ void Creature::onWalk()
 
 	if (attackedCreature || followCreature) {
 		if (lastPathUpdate < OTSYS_TIME()) {
-			g_dispatcher.addTask(createTask([id = getID()]() { g_game.updateCreatureWalk(id); }));
+			g_dispatcher.addTask([id = getID()]() { g_game.updateCreatureWalk(id); });
 			lastPathUpdate = OTSYS_TIME() + getNumber(ConfigManager::PATHFINDING_DELAY);
 		}
 	}
@@ -885,7 +885,7 @@ void Creature::updateFollowersPaths()
 				continue;
 			}
 
-			g_dispatcher.addTask(createTask([id = follower->getID()]() { g_game.updateCreatureWalk(id); }));
+			g_dispatcher.addTask([id = follower->getID()]() { g_game.updateCreatureWalk(id); });
 			follower->lastPathUpdate = OTSYS_TIME() + getNumber(ConfigManager::PATHFINDING_DELAY);
 		}
 	}
@@ -51,6 +51,8 @@ struct FindPathParams
 	int32_t maxSearchDist = 0;
 	int32_t minTargetDist = -1;
 	int32_t maxTargetDist = -1;
+
+	bool operator==(const FindPathParams&) const = default;
 };
 
 static constexpr int32_t EVENT_CREATURECOUNT = 10;
@@ -377,7 +379,7 @@ public:
 
 	virtual void setStorageValue(uint32_t key, std::optional<int32_t> value, bool isSpawn = false);
 	virtual std::optional<int32_t> getStorageValue(uint32_t key) const;
-	decltype(auto) getStorageMap() const { return storageMap; }
+	const auto& getStorageMap() const { return storageMap; }
 
 protected:
 	struct CountBlock_t
@@ -416,10 +418,13 @@ protected:
 	uint32_t blockTicks = 0;
 	uint32_t lastStepCost = 1;
 	uint32_t baseSpeed = 220;
+	uint32_t creatureCheckIndex = 0;
 	int32_t varSpeed = 0;
 	int32_t health = 1000;
 	int32_t healthMax = 1000;
 	uint8_t drunkenness = 0;
+	uint8_t creatureCheckBucket = 0;
+	uint8_t creatureCheckGroup = 0;
 
 	Outfit_t currentOutfit;
 	Outfit_t defaultOutfit;
@@ -432,7 +437,6 @@ protected:
 	Skulls_t skull = SKULL_NONE;
 
 	bool isInternalRemoved = false;
-	bool creatureCheck = false;
 	bool inCheckCreaturesVector = false;
 	bool skillLoss = true;
 	bool lootDrop = true;
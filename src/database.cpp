@@ -64,7 +64,15 @@ static bool isLostConnectionError(const unsigned error)
 	       error == 1053 /*ER_SERVER_SHUTDOWN*/ || error == CR_CONNECTION_ERROR;
 }
 
-static bool executeQuery(tfs::detail::Mysql_ptr& handle, std::string_view query, const bool retryIfLostConnection)
+static void reconnect(tfs::detail::Mysql_ptr& handle, tfs::detail::MysqlStatements& statements)
+{
+	handle = connectToDatabase(true);
+	// statements were prepared on the lost connection
+	statements.clear();
+}
+
+static bool executeQuery(tfs::detail::Mysql_ptr& handle, tfs::detail::MysqlStatements& statements,
+                         std::string_view query, const bool retryIfLostConnection)
 {
 	while (mysql_real_query(handle.get(), query.data(), query.length()) != 0) {
 		std::cout << "[Error - mysql_real_query] Query: " << query.substr(0, 256) << std::endl
@@ -73,8 +81,27 @@ static bool executeQuery(tfs::detail::Mysql_ptr& handle, std::string_view query,
 		if (!isLostConnectionError(error) || !retryIfLostConnection) {
 			return false;
 		}
-		handle = connectToDatabase(true);
+		reconnect(handle, statements);
+	}
+	return true;
+}
+
+namespace {
+
+thread_local std::unique_ptr<Database> threadInstance;
+
+} // namespace
+
+Database& Database::getThreadInstance() { return threadInstance ? *threadInstance : getInstance(); }
+
+bool Database::connectThreadInstance()
+{
+	auto db = std::make_unique<Database>();
+	if (!db->connect()) {
+		return false;
 	}
+
+	threadInstance = std::move(db);
 	return true;
 }
 
@@ -86,6 +113,7 @@ bool Database::connect()
 	}
 
 	handle = std::move(newHandle);
+	statements.clear();
 	DBResult_ptr result = storeQuery("SHOW VARIABLES LIKE 'max_allowed_packet'");
 	if (result) {
 		maxPacketSize = result->getNumber<uint64_t>("Value");
@@ -123,7 +151,7 @@ bool Database::commit()
 bool Database::executeQuery(const std::string& query)
 {
 	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
-	auto success = ::executeQuery(handle, query, retryQueries);
+	auto success = ::executeQuery(handle, statements, query, retryQueries);
 
 	// executeQuery can be called with command that produces result (e.g. SELECT)
 	// we have to store that result, even though we do not need it, otherwise handle will get blocked
@@ -138,7 +166,7 @@ DBResult_ptr Database::storeQuery(std::string_view query)
 	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
 
 retry:
-	if (!::executeQuery(handle, query, retryQueries) && !retryQueries) {
+	if (!::executeQuery(handle, statements, query, retryQueries) && !retryQueries) {
 		return nullptr;
 	}
 
@@ -163,6 +191,102 @@ retry:
 	return result;
 }
 
+MYSQL_STMT* Database::runStatement(std::string_view query, MYSQL_BIND* params, size_t count)
+{
+retry:
+	MYSQL_STMT* statement;
+	auto it = statements.find(query);
+	if (it != statements.end()) {
+		statement = it->second.get();
+	} else {
+		tfs::detail::MysqlStatement_ptr newStatement{mysql_stmt_init(handle.get())};
+		if (!newStatement) {
+			std::cout << "[Error - mysql_stmt_init] Message: " << mysql_error(handle.get()) << std::endl;
+			return nullptr;
+		}
+
+		if (mysql_stmt_prepare(newStatement.get(), query.data(), query.length()) != 0) {
+			std::cout << "[Error - mysql_stmt_prepare] Query: " << query.substr(0, 256) << std::endl
+			          << "Message: " << mysql_stmt_error(newStatement.get()) << std::endl;
+			const unsigned error = mysql_stmt_errno(newStatement.get());
+			if (!isLostConnectionError(error) || !retryQueries) {
+				return nullptr;
+			}
+			reconnect(handle, statements);
+			goto retry;
+		}
+
+		if (mysql_stmt_param_count(newStatement.get()) != count) {
+			std::cout << "[Error - Database::runStatement] Query: " << query.substr(0, 256) << std::endl
+			          << "Message: expected " << mysql_stmt_param_count(newStatement.get()) << " parameters, got "
+			          << count << std::endl;
+			return nullptr;
+		}
+
+		statement = newStatement.get();
+		statements.emplace(query, std::move(newStatement));
+	}
+
+	if ((count != 0 && mysql_stmt_bind_param(statement, params)) || mysql_stmt_execute(statement) != 0) {
+		std::cout << "[Error - mysql_stmt_execute] Query: " << query.substr(0, 256) << std::endl
+		          << "Message: " << mysql_stmt_error(statement) << std::endl;
+		const unsigned error = mysql_stmt_errno(statement);
+		if (!isLostConnectionError(error) || !retryQueries) {
+			return nullptr;
+		}
+		reconnect(handle, statements);
+		goto retry;
+	}
+	return statement;
+}
+
+bool Database::executeStatement(std::string_view query, MYSQL_BIND* params, size_t count)
+{
+	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
+	MYSQL_STMT* statement = runStatement(query, params, count);
+	if (!statement) {
+		return false;
+	}
+
+	// like executeQuery, a result nobody reads would block the statement
+	mysql_stmt_free_result(statement);
+	return true;
+}
+
+DBResult_ptr Database::storeStatement(std::string_view query, MYSQL_BIND* params, size_t count)
+{
+	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
+	MYSQL_STMT* statement = runStatement(query, params, count);
+	if (!statement) {
+		return nullptr;
+	}
+
+	// the longest value of every column is known after storing the rows, so one buffer per column holds any of them
+	const bool updateMaxLength = true;
+	mysql_stmt_attr_set(statement, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+
+	if (mysql_stmt_store_result(statement) != 0) {
+		std::cout << "[Error - mysql_stmt_store_result] Query: " << query.substr(0, 256) << std::endl
+		          << "Message: " << mysql_stmt_error(statement) << std::endl;
+		mysql_stmt_free_result(statement);
+		return nullptr;
+	}
+
+	// statements without a result set, like an UPDATE, have no metadata
+	tfs::detail::MysqlResult_ptr metadata{mysql_stmt_result_metadata(statement)};
+	if (!metadata) {
+		mysql_stmt_free_result(statement);
+		return nullptr;
+	}
+
+	DBResult_ptr result = std::make_shared<DBResult>(std::move(metadata), statement);
+	mysql_stmt_free_result(statement);
+	if (!result->hasNext()) {
+		return nullptr;
+	}
+	return result;
+}
+
 std::string Database::escapeBlob(const char* s, uint32_t length) const
 {
 	// the worst case is 2n + 1
@@ -192,43 +316,170 @@ DBResult::DBResult(tfs::detail::MysqlResult_ptr&& res) : handle{std::move(res)}
 		listNames[field->name] = i++;
 		field = mysql_fetch_field(handle.get());
 	}
+	columnCount = i;
 
 	row = mysql_fetch_row(handle.get());
 }
 
-std::string_view DBResult::getString(std::string_view column) const
+DBResult::DBResult(tfs::detail::MysqlResult_ptr&& res, MYSQL_STMT* statement) : handle{std::move(res)}, binary{true}
+{
+	using NullFlag = std::remove_pointer_t<decltype(MYSQL_BIND::is_null)>;
+
+	columnCount = mysql_num_fields(handle.get());
+	MYSQL_FIELD* fields = mysql_fetch_fields(handle.get());
+
+	std::vector<MYSQL_BIND> binds(columnCount);
+	std::vector<int64_t> integers(columnCount);
+	std::vector<double> reals(columnCount);
+	std::vector<std::string> strings(columnCount);
+	std::vector<unsigned long> lengths(columnCount);
+	auto nulls = std::make_unique<NullFlag[]>(columnCount);
+
+	columnTypes.reserve(columnCount);
+	for (size_t i = 0; i < columnCount; ++i) {
+		const MYSQL_FIELD& field = fields[i];
+		listNames[field.name] = i;
+
+		MYSQL_BIND& bind = binds[i];
+		bind.is_null = &nulls[i];
+		bind.length = &lengths[i];
+		switch (field.type) {
+			case MYSQL_TYPE_TINY:
+			case MYSQL_TYPE_SHORT:
+			case MYSQL_TYPE_INT24:
+			case MYSQL_TYPE_LONG:
+			case MYSQL_TYPE_LONGLONG:
+			case MYSQL_TYPE_YEAR:
+				columnTypes.push_back((field.flags & UNSIGNED_FLAG) != 0 ? COLUMN_UNSIGNED : COLUMN_SIGNED);
+				bind.buffer_type = MYSQL_TYPE_LONGLONG;
+				bind.buffer = &integers[i];
+				bind.is_unsigned = (field.flags & UNSIGNED_FLAG) != 0;
+				break;
+
+			case MYSQL_TYPE_FLOAT:
+			case MYSQL_TYPE_DOUBLE:
+				columnTypes.push_back(COLUMN_REAL);
+				bind.buffer_type = MYSQL_TYPE_DOUBLE;
+				bind.buffer = &reals[i];
+				break;
+
+			// strings, blobs, decimals and dates are read as text
+			default:
+				columnTypes.push_back(COLUMN_STRING);
+				strings[i].resize(std::max<unsigned long>(field.max_length, 1));
+				bind.buffer_type = MYSQL_TYPE_STRING;
+				bind.buffer = strings[i].data();
+				bind.buffer_length = strings[i].size();
+				break;
+		}
+	}
+
+	if (mysql_stmt_bind_result(statement, binds.data())) {
+		std::cout << "[Error - mysql_stmt_bind_result] Message: " << mysql_stmt_error(statement) << std::endl;
+		return;
+	}
+
+	values.reserve(mysql_stmt_num_rows(statement) * columnCount);
+	while (true) {
+		int status = mysql_stmt_fetch(statement);
+		if (status == MYSQL_NO_DATA) {
+			break;
+		} else if (status == 1) {
+			std::cout << "[Error - mysql_stmt_fetch] Message: " << mysql_stmt_error(statement) << std::endl;
+			break;
+		}
+
+		for (size_t i = 0; i < columnCount; ++i) {
+			Value& value = values.emplace_back();
+			value.isNull = nulls[i];
+			if (value.isNull) {
+				continue;
+			}
+
+			switch (columnTypes[i]) {
+				case COLUMN_SIGNED:
+				case COLUMN_UNSIGNED:
+					value.integer = integers[i];
+					break;
+
+				case COLUMN_REAL:
+					value.real = reals[i];
+					break;
+
+				default:
+					value.offset = data.size();
+					value.length = std::min<size_t>(lengths[i], strings[i].size());
+					data.append(strings[i].data(), value.length);
+					data.push_back('\0');
+					break;
+			}
+		}
+		++rowCount;
+	}
+}
+
+size_t DBResult::getColumnIndex(std::string_view column) const
 {
 	auto it = listNames.find(column);
 	if (it == listNames.end()) {
-		std::cout << "[Error - DBResult::getString] Column '" << column << "' does not exist in result set."
+		std::cout << "[Error - DBResult::getColumnIndex] Column '" << column << "' doesn't exist in the result set"
 		          << std::endl;
+		return columnCount;
+	}
+	return it->second;
+}
+
+std::string_view DBResult::getString(size_t column) const
+{
+	if (column >= columnCount) {
 		return {};
 	}
 
-	if (!row[it->second]) {
+	if (binary) {
+		const Value& value = values[currentRow * columnCount + column];
+		if (columnTypes[column] != COLUMN_STRING) {
+			std::cout << "[Error - DBResult::getString] Column " << column << " of a prepared statement is a number."
+			          << std::endl;
+			return {};
+		}
+
+		if (value.isNull) {
+			return {};
+		}
+		return {data.data() + value.offset, value.length};
+	}
+
+	if (!row[column]) {
 		return {};
 	}
 
-	auto size = mysql_fetch_lengths(handle.get())[it->second];
-	return {row[it->second], size};
+	auto size = mysql_fetch_lengths(handle.get())[column];
+	return {row[column], size};
 }
 
-bool DBResult::hasNext() const { return row; }
+bool DBResult::hasNext() const { return binary ? currentRow < rowCount : row != nullptr; }
 
 bool DBResult::next()
 {
+	if (binary) {
+		return ++currentRow < rowCount;
+	}
+
 	row = mysql_fetch_row(handle.get());
 	return row;
 }
 
-DBInsert::DBInsert(std::string query) : query(std::move(query)) { this->length = this->query.length(); }
+DBInsert::DBInsert(std::string query, Database& db) : db(db), query(std::move(query))
+{
+	this->length = this->query.length();
+}
 
 bool DBInsert::addRow(const std::string& row)
 {
 	// adds new row to buffer
 	const size_t rowLength = row.length();
 	length += rowLength;
-	if (length > Database::getInstance().getMaxPacketSize() && !execute()) {
+	if (length > db.getMaxPacketSize() && !execute()) {
 		return false;
 	}
 
@@ -261,7 +512,7 @@ bool DBInsert::execute()
 	}
 
 	// executes buffer
-	bool res = Database::getInstance().executeQuery(query + values);
+	bool res = db.executeQuery(query + values);
 	values.clear();
 	length = query.length();
 	return res;
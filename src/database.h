@@ -15,10 +15,73 @@ struct MysqlDeleter
 {
 	void operator()(MYSQL* handle) const { mysql_close(handle); }
 	void operator()(MYSQL_RES* handle) const { mysql_free_result(handle); }
+	void operator()(MYSQL_STMT* handle) const { mysql_stmt_close(handle); }
 };
 
 using Mysql_ptr = std::unique_ptr<MYSQL, MysqlDeleter>;
 using MysqlResult_ptr = std::unique_ptr<MYSQL_RES, MysqlDeleter>;
+using MysqlStatement_ptr = std::unique_ptr<MYSQL_STMT, MysqlDeleter>;
+
+// prepared statements of a connection by their query
+using MysqlStatements = std::map<std::string, MysqlStatement_ptr, std::less<>>;
+
+template <typename T>
+struct is_optional : std::false_type
+{};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type
+{};
+
+template <size_t Size>
+constexpr enum_field_types getIntegerType()
+{
+	if constexpr (Size == 1) {
+		return MYSQL_TYPE_TINY;
+	} else if constexpr (Size == 2) {
+		return MYSQL_TYPE_SHORT;
+	} else if constexpr (Size == 4) {
+		return MYSQL_TYPE_LONG;
+	} else {
+		return MYSQL_TYPE_LONGLONG;
+	}
+}
+
+/**
+ * Points bind at value, which has to outlive the execution of the statement. Empty optionals and nullptr are bound
+ * as NULL.
+ */
+template <typename T>
+void bindParam(MYSQL_BIND& bind, const T& value)
+{
+	if constexpr (std::is_same_v<T, std::nullptr_t>) {
+		bind.buffer_type = MYSQL_TYPE_NULL;
+	} else if constexpr (is_optional<T>::value) {
+		if (value) {
+			bindParam(bind, *value);
+		} else {
+			bind.buffer_type = MYSQL_TYPE_NULL;
+		}
+	} else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+		using Integer = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+		                                            std::type_identity<T>>::type;
+		bind.buffer_type = getIntegerType<sizeof(Integer)>();
+		bind.buffer = const_cast<T*>(&value);
+		bind.is_unsigned = std::is_unsigned_v<Integer>;
+	} else if constexpr (std::is_same_v<T, float>) {
+		bind.buffer_type = MYSQL_TYPE_FLOAT;
+		bind.buffer = const_cast<float*>(&value);
+	} else if constexpr (std::is_same_v<T, double>) {
+		bind.buffer_type = MYSQL_TYPE_DOUBLE;
+		bind.buffer = const_cast<double*>(&value);
+	} else {
+		// sent as is, like a quoted literal in the character set of the connection
+		std::string_view string = value;
+		bind.buffer_type = MYSQL_TYPE_STRING;
+		bind.buffer = const_cast<char*>(string.data());
+		bind.buffer_length = string.size();
+	}
+}
 
 } // namespace tfs::detail
 
@@ -36,6 +99,13 @@ public:
 		return instance;
 	}
 
+	/**
+	 * Connection of the calling thread, opened by connectThreadInstance, or the singleton when the thread has none.
+	 * Lets threads querying the database on their own, like the HTTP workers, stay off the game's connection.
+	 */
+	static Database& getThreadInstance();
+	static bool connectThreadInstance();
+
 	/**
 	 * Connects to the database
 	 *
@@ -63,6 +133,42 @@ public:
 	 */
 	DBResult_ptr storeQuery(std::string_view query);
 
+	/**
+	 * Executes a prepared statement.
+	 *
+	 * The query is prepared on first use and kept by the connection, its ?
+	 * placeholders are bound to params in order. Nothing is escaped or
+	 * formatted, numbers and blobs are sent in binary.
+	 *
+	 * @param query command with placeholders
+	 * @return true on success, false on error
+	 */
+	template <typename... Params>
+	bool executeStatement(std::string_view query, const Params&... params)
+	{
+		std::array<MYSQL_BIND, sizeof...(Params)> binds{};
+		size_t index = 0;
+		(tfs::detail::bindParam(binds[index++], params), ...);
+		return executeStatement(query, binds.data(), binds.size());
+	}
+
+	/**
+	 * Queries database with a prepared statement.
+	 *
+	 * Like executeStatement, the rows are read in binary and held by the
+	 * result, numeric columns have to be read with getNumber.
+	 *
+	 * @return results object (nullptr on error or when there are no rows)
+	 */
+	template <typename... Params>
+	DBResult_ptr storeStatement(std::string_view query, const Params&... params)
+	{
+		std::array<MYSQL_BIND, sizeof...(Params)> binds{};
+		size_t index = 0;
+		(tfs::detail::bindParam(binds[index++], params), ...);
+		return storeStatement(query, binds.data(), binds.size());
+	}
+
 	/**
 	 * Escapes string for query.
 	 *
@@ -114,7 +220,12 @@ private:
 	bool rollback();
 	bool commit();
 
+	bool executeStatement(std::string_view query, MYSQL_BIND* params, size_t count);
+	DBResult_ptr storeStatement(std::string_view query, MYSQL_BIND* params, size_t count);
+	MYSQL_STMT* runStatement(std::string_view query, MYSQL_BIND* params, size_t count);
+
 	tfs::detail::Mysql_ptr handle = nullptr;
+	tfs::detail::MysqlStatements statements;
 	std::recursive_mutex databaseLock;
 	uint64_t maxPacketSize = 1048576;
 	// Do not retry queries if we are in the middle of a transaction
@@ -128,53 +239,114 @@ class DBResult
 public:
 	explicit DBResult(tfs::detail::MysqlResult_ptr&& res);
 
+	/**
+	 * Reads every row of an executed statement, res holds its metadata.
+	 */
+	DBResult(tfs::detail::MysqlResult_ptr&& res, MYSQL_STMT* statement);
+
 	// non-copyable
 	DBResult(const DBResult&) = delete;
 	DBResult& operator=(const DBResult&) = delete;
 
+	/**
+	 * Index of a column, for reading many rows without looking it up by name every time. The column count is
+	 * returned when it does not exist, getNumber and getString return nothing for it then.
+	 */
+	size_t getColumnIndex(std::string_view column) const;
+
 	template <typename T>
-	T getNumber(std::string_view column) const
+	T getNumber(size_t column) const
 	{
-		auto it = listNames.find(column);
-		if (it == listNames.end()) {
-			std::cout << "[Error - DBResult::getNumber] Column '" << column << "' doesn't exist in the result set"
-			          << std::endl;
+		if (column >= columnCount) {
 			return {};
 		}
 
-		if (!row[it->second]) {
+		if (binary) {
+			const Value& value = values[currentRow * columnCount + column];
+			if (value.isNull) {
+				return {};
+			}
+
+			switch (columnTypes[column]) {
+				case COLUMN_SIGNED:
+					return static_cast<T>(value.integer);
+				case COLUMN_UNSIGNED:
+					return static_cast<T>(static_cast<uint64_t>(value.integer));
+				case COLUMN_REAL:
+					return static_cast<T>(value.real);
+				default:
+					return pugi::cast<T>(data.data() + value.offset);
+			}
+		}
+
+		if (!row[column]) {
 			return {};
 		}
 
-		return pugi::cast<T>(row[it->second]);
+		return pugi::cast<T>(row[column]);
 	}
 
-	std::string_view getString(std::string_view column) const;
+	template <typename T>
+	T getNumber(std::string_view column) const
+	{
+		return getNumber<T>(getColumnIndex(column));
+	}
+
+	std::string_view getString(size_t column) const;
+	std::string_view getString(std::string_view column) const { return getString(getColumnIndex(column)); }
 
 	bool hasNext() const;
 	bool next();
 
 private:
+	enum ColumnType_t : uint8_t
+	{
+		COLUMN_SIGNED,
+		COLUMN_UNSIGNED,
+		COLUMN_REAL,
+		COLUMN_STRING,
+	};
+
+	struct Value
+	{
+		int64_t integer = 0;
+		double real = 0;
+		// strings are kept in data, followed by a null character
+		size_t offset = 0;
+		size_t length = 0;
+		bool isNull = false;
+	};
+
 	tfs::detail::MysqlResult_ptr handle;
-	MYSQL_ROW row;
+	MYSQL_ROW row = nullptr;
 
 	std::map<std::string_view, size_t> listNames;
+	size_t columnCount = 0;
+
+	// rows of a prepared statement
+	bool binary = false;
+	std::vector<ColumnType_t> columnTypes;
+	std::vector<Value> values;
+	std::string data;
+	size_t rowCount = 0;
+	size_t currentRow = 0;
 
 	friend class Database;
 };
 
 /**
- * INSERT statement.
+ * INSERT statement, executed on the given connection.
  */
 class DBInsert
 {
 public:
-	explicit DBInsert(std::string query);
+	explicit DBInsert(std::string query, Database& db = Database::getInstance());
 	bool addRow(const std::string& row);
 	bool addRow(std::ostringstream& row);
 	bool execute();
 
 private:
+	Database& db;
 	std::string query;
 	std::string values;
 	size_t length;
@@ -183,12 +355,12 @@ private:
 class DBTransaction
 {
 public:
-	constexpr DBTransaction() = default;
+	explicit DBTransaction(Database& db = Database::getInstance()) : db(db) {}
 
 	~DBTransaction()
 	{
 		if (state == STATE_START) {
-			Database::getInstance().rollback();
+			db.rollback();
 		}
 	}
 
@@ -199,7 +371,7 @@ public:
 	bool begin()
 	{
 		state = STATE_START;
-		return Database::getInstance().beginTransaction();
+		return db.beginTransaction();
 	}
 
 	bool commit()
@@ -209,7 +381,7 @@ public:
 		}
 
 		state = STATE_COMMIT;
-		return Database::getInstance().commit();
+		return db.commit();
 	}
 
 private:
@@ -220,6 +392,7 @@ private:
 		STATE_COMMIT,
 	};
 
+	Database& db;
 	TransactionStates_t state = STATE_NO_START;
 };
 
@@ -5,86 +5,172 @@
 
 #include "databasetasks.h"
 
+#include "configmanager.h"
 #include "tasks.h"
 
 extern Dispatcher g_dispatcher;
 
 void DatabaseTasks::start()
 {
-	db.connect();
-	ThreadHolder::start();
+	size_t count = std::max<int32_t>(getNumber(ConfigManager::DATABASE_WORKERS), 1);
+	workers.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		auto& worker = workers.emplace_back(std::make_unique<Worker>());
+		worker->db.connect();
+	}
+
+	threadState.store(THREAD_STATE_RUNNING, std::memory_order_relaxed);
+	for (auto& worker : workers) {
+		worker->thread = std::thread(&DatabaseTasks::workerMain, this, std::ref(*worker));
+	}
 }
 
-void DatabaseTasks::threadMain()
+void DatabaseTasks::stop() { threadState.store(THREAD_STATE_CLOSING, std::memory_order_relaxed); }
+
+void DatabaseTasks::shutdown()
 {
-	std::unique_lock<std::mutex> taskLockUnique(taskLock, std::defer_lock);
-	while (getState() != THREAD_STATE_TERMINATED) {
-		taskLockUnique.lock();
-		if (tasks.empty()) {
-			taskSignal.wait(taskLockUnique);
+	// the workers run what is still queued before leaving
+	threadState.store(THREAD_STATE_TERMINATED, std::memory_order_relaxed);
+	for (auto& worker : workers) {
+		// a worker checking the state right before waiting has to be waited for
+		{
+			std::lock_guard<std::mutex> lockGuard(worker->taskLock);
 		}
+		worker->taskSignal.notify_one();
+	}
+}
 
-		if (!tasks.empty()) {
-			DatabaseTask task = std::move(tasks.front());
-			tasks.pop_front();
-			taskLockUnique.unlock();
-			runTask(task);
-		} else {
-			taskLockUnique.unlock();
+void DatabaseTasks::join()
+{
+	for (auto& worker : workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
 		}
 	}
 }
 
+void DatabaseTasks::workerMain(Worker& worker)
+{
+	std::unique_lock<std::mutex> taskLockUnique(worker.taskLock);
+	while (true) {
+		worker.taskSignal.wait(taskLockUnique, [this, &worker]() {
+			return !worker.tasks.empty() || threadState.load(std::memory_order_relaxed) == THREAD_STATE_TERMINATED;
+		});
+
+		if (worker.tasks.empty()) {
+			break;
+		}
+
+		DatabaseTask task = std::move(worker.tasks.front());
+		worker.tasks.pop_front();
+		taskLockUnique.unlock();
+		runTask(worker, task);
+		taskLockUnique.lock();
+	}
+}
+
 void DatabaseTasks::addTask(std::string query, std::function<void(DBResult_ptr, bool)> callback /* = nullptr*/,
                             bool store /* = false*/)
 {
-	bool signal = false;
-	taskLock.lock();
-	if (getState() == THREAD_STATE_RUNNING) {
-		signal = tasks.empty();
-		tasks.emplace_back(std::move(query), std::move(callback), store);
+	if (threadState.load(std::memory_order_relaxed) == THREAD_STATE_RUNNING) {
+		pushTask(*workers.front(), {std::move(query), std::move(callback), store});
 	}
-	taskLock.unlock();
+}
 
-	if (signal) {
-		taskSignal.notify_one();
+bool DatabaseTasks::addJob(uint64_t key, std::function<void(Database&)> job)
+{
+	if (threadState.load(std::memory_order_relaxed) != THREAD_STATE_RUNNING) {
+		return false;
 	}
+
+	pushTask(*workers[key % workers.size()], DatabaseTask{std::move(job)});
+	return true;
 }
 
-void DatabaseTasks::runTask(const DatabaseTask& task)
+bool DatabaseTasks::addJobAfterAll(std::function<void(Database&)> job)
 {
-	bool success;
-	DBResult_ptr result;
-	if (task.store) {
-		result = db.storeQuery(task.query);
-		success = true;
-	} else {
-		result = nullptr;
-		success = db.executeQuery(task.query);
+	if (threadState.load(std::memory_order_relaxed) != THREAD_STATE_RUNNING) {
+		return false;
 	}
 
-	if (task.callback) {
-		g_dispatcher.addTask([=, callback = task.callback]() { callback(result, success); });
+	// the last worker reaching its part runs the job
+	auto remaining = std::make_shared<std::atomic<size_t>>(workers.size());
+	auto sharedJob = std::make_shared<std::function<void(Database&)>>(std::move(job));
+	auto part = [remaining, sharedJob](Database& db) {
+		if (remaining->fetch_sub(1) == 1) {
+			(*sharedJob)(db);
+		}
+	};
+
+	for (auto& worker : workers) {
+		pushTask(*worker, DatabaseTask{part});
 	}
+	return true;
 }
 
-void DatabaseTasks::flush()
+void DatabaseTasks::pushTask(Worker& worker, DatabaseTask&& task)
 {
-	std::unique_lock<std::mutex> guard{taskLock};
-	while (!tasks.empty()) {
-		auto task = std::move(tasks.front());
-		tasks.pop_front();
-		guard.unlock();
-		runTask(task);
-		guard.lock();
+	task.queuedAt = std::chrono::steady_clock::now();
+
+	bool signal;
+	{
+		std::lock_guard<std::mutex> lockGuard(worker.taskLock);
+		signal = worker.tasks.empty();
+		worker.tasks.push_back(std::move(task));
+		worker.maxQueued = std::max(worker.maxQueued, worker.tasks.size());
+	}
+
+	if (signal) {
+		worker.taskSignal.notify_one();
 	}
 }
 
-void DatabaseTasks::shutdown()
+void DatabaseTasks::runTask(Worker& worker, const DatabaseTask& task)
+{
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+
+	auto start = std::chrono::steady_clock::now();
+	worker.waitTime.fetch_add(duration_cast<microseconds>(start - task.queuedAt).count(), std::memory_order_relaxed);
+
+	if (task.job) {
+		task.job(worker.db);
+	} else {
+		bool success;
+		DBResult_ptr result;
+		if (task.store) {
+			result = worker.db.storeQuery(task.query);
+			success = true;
+		} else {
+			result = nullptr;
+			success = worker.db.executeQuery(task.query);
+		}
+
+		if (task.callback) {
+			g_dispatcher.addTask([=, callback = task.callback]() { callback(result, success); });
+		}
+	}
+
+	auto runTime = std::chrono::steady_clock::now() - start;
+	worker.runTime.fetch_add(duration_cast<microseconds>(runTime).count(), std::memory_order_relaxed);
+	worker.executed.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<DatabaseWorkerStats> DatabaseTasks::getStats()
 {
-	taskLock.lock();
-	setState(THREAD_STATE_TERMINATED);
-	taskLock.unlock();
-	flush();
-	taskSignal.notify_one();
+	std::vector<DatabaseWorkerStats> stats;
+	stats.reserve(workers.size());
+	for (auto& worker : workers) {
+		size_t queued, maxQueued;
+		{
+			std::lock_guard<std::mutex> lockGuard(worker->taskLock);
+			queued = worker->tasks.size();
+			maxQueued = worker->maxQueued;
+		}
+
+		stats.push_back({queued, maxQueued, worker->executed.load(std::memory_order_relaxed),
+		                 worker->waitTime.load(std::memory_order_relaxed),
+		                 worker->runTime.load(std::memory_order_relaxed)});
+	}
+	return stats;
 }
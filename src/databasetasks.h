@@ -5,39 +5,88 @@
 #define FS_DATABASETASKS_H
 
 #include "database.h"
-#include "thread_holder_base.h"
+#include "enums.h"
 
 struct DatabaseTask
 {
 	DatabaseTask(std::string&& query, std::function<void(DBResult_ptr, bool)>&& callback, bool store) :
 	    query(std::move(query)), callback(std::move(callback)), store(store)
 	{}
+	explicit DatabaseTask(std::function<void(Database&)>&& job) : job(std::move(job)), store(false) {}
 
 	std::string query;
 	std::function<void(DBResult_ptr, bool)> callback;
+	std::function<void(Database&)> job;
 	bool store;
+	std::chrono::steady_clock::time_point queuedAt;
 };
 
-class DatabaseTasks : public ThreadHolder<DatabaseTasks>
+struct DatabaseWorkerStats
+{
+	size_t queued;
+	size_t maxQueued;
+	uint64_t executed;
+	// microseconds spent by the executed tasks waiting in the queue and running
+	uint64_t waitTime;
+	uint64_t runTime;
+};
+
+/**
+ * Worker threads running queries and jobs, each on its own connection. Tasks with the same key run in the order they
+ * were added on the same worker, tasks without a key all run on the first one. There is no order between different
+ * keys: player saves are keyed by guid, so a query added with addTask (db.asyncQuery in Lua included) may run before
+ * or after a save of the player queued earlier. Anything writing player rows that a save also writes has to go through
+ * addJob with the guid of the player, as IOLoginData::increaseBankBalance does.
+ */
+class DatabaseTasks
 {
 public:
 	DatabaseTasks() = default;
 	void start();
-	void flush();
+	void stop();
 	void shutdown();
+	void join();
 
+	/**
+	 * Runs query on the first worker, in order with the other queries and the jobs of key 0 only.
+	 */
 	void addTask(std::string query, std::function<void(DBResult_ptr, bool)> callback = nullptr, bool store = false);
 
-	void threadMain();
+	/**
+	 * Runs job on the connection of a worker, after the tasks added before with the same key (0 is the key of the
+	 * queries). Returns false when the workers are not running, the job is dropped then and the caller has to run it
+	 * itself.
+	 */
+	bool addJob(uint64_t key, std::function<void(Database&)> job);
+
+	/**
+	 * Runs job once every task added before it is done, whatever its key.
+	 */
+	bool addJobAfterAll(std::function<void(Database&)> job);
+
+	std::vector<DatabaseWorkerStats> getStats();
 
 private:
-	void runTask(const DatabaseTask& task);
+	struct Worker
+	{
+		Database db;
+		std::thread thread;
+		std::list<DatabaseTask> tasks;
+		std::mutex taskLock;
+		std::condition_variable taskSignal;
+		size_t maxQueued = 0;
+
+		std::atomic<uint64_t> executed{0};
+		std::atomic<uint64_t> waitTime{0};
+		std::atomic<uint64_t> runTime{0};
+	};
+
+	void pushTask(Worker& worker, DatabaseTask&& task);
+	void runTask(Worker& worker, const DatabaseTask& task);
+	void workerMain(Worker& worker);
 
-	Database db;
-	std::thread thread;
-	std::list<DatabaseTask> tasks;
-	std::mutex taskLock;
-	std::condition_variable taskSignal;
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::atomic<ThreadState> threadState{THREAD_STATE_TERMINATED};
 };
 
 extern DatabaseTasks g_databaseTasks;
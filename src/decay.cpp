@@ -0,0 +1,70 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "decay.h"
+
+uint32_t DecayWheel::add(Item* item, uint64_t expiryTick)
+{
+	uint32_t slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		slot = entries.size();
+		entries.emplace_back();
+	}
+
+	Entry& entry = entries[slot];
+	entry.item = item;
+	entry.expiryTick = std::max(expiryTick, currentTick + 1);
+
+	auto& bucket = buckets[entry.expiryTick % WHEEL_SIZE];
+	entry.bucketIndex = bucket.size();
+	bucket.push_back(slot);
+
+	++itemCount;
+	return slot;
+}
+
+void DecayWheel::remove(uint32_t slot)
+{
+	Entry& entry = entries[slot];
+	removeFromBucket(buckets[entry.expiryTick % WHEEL_SIZE], entry.bucketIndex);
+
+	entry.item = nullptr;
+	freeSlots.push_back(slot);
+	--itemCount;
+}
+
+void DecayWheel::removeFromBucket(std::vector<uint32_t>& bucket, uint32_t bucketIndex)
+{
+	uint32_t lastSlot = bucket.back();
+	bucket[bucketIndex] = lastSlot;
+	entries[lastSlot].bucketIndex = bucketIndex;
+	bucket.pop_back();
+}
+
+void DecayWheel::advance(std::vector<Item*>& expired)
+{
+	++currentTick;
+
+	auto& bucket = buckets[currentTick % WHEEL_SIZE];
+	for (uint32_t i = 0; i < bucket.size();) {
+		uint32_t slot = bucket[i];
+		Entry& entry = entries[slot];
+		if (entry.expiryTick > currentTick) {
+			// expires on a later turn of the wheel
+			++i;
+			continue;
+		}
+
+		expired.push_back(entry.item);
+		removeFromBucket(bucket, i);
+
+		entry.item = nullptr;
+		freeSlots.push_back(slot);
+		--itemCount;
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_DECAY_H
+#define FS_DECAY_H
+
+class Item;
+
+/**
+ * Timing wheel holding the decaying items, advanced once per decay interval.
+ *
+ * Items live in a flat slot table and the bucket of their expiry tick only stores their slot, so adding an item,
+ * removing it and finding it again from its slot are O(1) and, once the tables have grown to the peak number of
+ * decaying items, never allocate. Advancing only visits the bucket of the new tick: items expiring within
+ * WHEEL_SIZE ticks are never looked at before they expire, longer ones are skipped once per turn of the wheel.
+ */
+class DecayWheel
+{
+public:
+	static constexpr uint32_t WHEEL_SIZE = 4096;
+
+	DecayWheel() = default;
+
+	// non-copyable
+	DecayWheel(const DecayWheel&) = delete;
+	DecayWheel& operator=(const DecayWheel&) = delete;
+
+	/**
+	 * Adds an item expiring at the given tick (at the earliest on the next one), returns its slot which is never 0.
+	 */
+	uint32_t add(Item* item, uint64_t expiryTick);
+	void remove(uint32_t slot);
+
+	/**
+	 * Moves the wheel to the next tick and appends the items that expired, their slots are released.
+	 */
+	void advance(std::vector<Item*>& expired);
+
+	Item* getItem(uint32_t slot) const { return entries[slot].item; }
+	uint64_t getExpiryTick(uint32_t slot) const { return entries[slot].expiryTick; }
+	uint64_t getCurrentTick() const { return currentTick; }
+	size_t size() const { return itemCount; }
+
+private:
+	struct Entry
+	{
+		Item* item = nullptr;
+		uint64_t expiryTick = 0;
+		uint32_t bucketIndex = 0;
+	};
+
+	void removeFromBucket(std::vector<uint32_t>& bucket, uint32_t bucketIndex);
+
+	// slot 0 is never used so it can mean "not decaying"
+	std::vector<Entry> entries{1};
+	std::vector<uint32_t> freeSlots;
+	std::array<std::vector<uint32_t>, WHEEL_SIZE> buckets;
+	uint64_t currentTick = 0;
+	size_t itemCount = 0;
+};
+
+#endif // FS_DECAY_H
@@ -18,6 +18,7 @@
 #include "http/http.h"
 #include "inbox.h"
 #include "iologindata.h"
+#include "iomapserialize.h"
 #include "iomarket.h"
 #include "items.h"
 #include "monster.h"
@@ -150,26 +151,143 @@ void Game::setGameState(GameState_t newState)
 
 void Game::saveGameState()
 {
+	if (gameState == GAME_STATE_NORMAL && getBoolean(ConfigManager::INCREMENTAL_SERVER_SAVE)) {
+		if (serverSaveStart != 0) {
+			return;
+		}
+
+		std::cout << "Saving server..." << std::endl;
+
+		serverSaveStart = OTSYS_TIME();
+		for (const auto& it : players) {
+			serverSavePlayers.insert(it.first);
+		}
+		for (const auto& it : map.houses.getHouses()) {
+			serverSaveHouses.insert(it.first);
+		}
+		continueServerSave();
+		return;
+	}
+
 	if (gameState == GAME_STATE_NORMAL) {
 		setGameState(GAME_STATE_MAINTAIN);
 	}
 
 	std::cout << "Saving server..." << std::endl;
 
+	// everything is saved right away, including what an incremental save did not reach yet
+	serverSavePlayers.clear();
+	serverSaveHouses.clear();
+	serverSaveStart = 0;
+
 	for (const auto& it : players) {
 		it.second->loginPosition = it.second->getPosition();
-		IOLoginData::savePlayer(it.second);
+		IOLoginData::savePlayerAsync(it.second);
 	}
 
-	Map::save();
-
-	g_databaseTasks.flush();
+	// on the lanes of the houses, so the snapshots an incremental save queued before cannot be written after these
+	for (const auto& it : map.houses.getHouses()) {
+		IOMapSerialize::saveHouseAsync(it.second);
+	}
 
 	if (gameState == GAME_STATE_MAINTAIN) {
 		setGameState(GAME_STATE_NORMAL);
 	}
 }
 
+void Game::continueServerSave()
+{
+	if (serverSaveStart == 0) {
+		return;
+	}
+
+	const int64_t deadline = OTSYS_TIME() + getNumber(ConfigManager::SERVER_SAVE_TICK_BUDGET);
+	do {
+		if (!serverSavePlayers.empty()) {
+			if (Player* player = getPlayerByID(*serverSavePlayers.begin())) {
+				serverSavePlayer(player);
+			} else {
+				// logged out, which saved the player already
+				serverSavePlayers.erase(serverSavePlayers.begin());
+			}
+		} else if (!serverSaveHouses.empty()) {
+			if (House* house = map.houses.getHouse(*serverSaveHouses.begin())) {
+				serverSaveHouse(house);
+			} else {
+				serverSaveHouses.erase(serverSaveHouses.begin());
+			}
+		} else {
+			const int64_t start = serverSaveStart;
+			serverSaveStart = 0;
+
+			// reported once the database thread wrote everything captured
+			auto report = [start]() {
+				std::cout << "> Saved server in: " << (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
+			};
+			if (!g_databaseTasks.addJobAfterAll([report](Database&) { report(); })) {
+				report();
+			}
+			return;
+		}
+	} while (OTSYS_TIME() < deadline);
+
+	g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, [this]() { continueServerSave(); }));
+}
+
+void Game::captureBeforeMove(Cylinder* fromCylinder, Cylinder* toCylinder, Creature* actor)
+{
+	if (serverSaveStart == 0) {
+		return;
+	}
+
+	serverSaveCylinder(fromCylinder);
+	serverSaveCylinder(toCylinder);
+	if (Player* player = actor ? actor->getPlayer() : nullptr) {
+		// depot chests and inboxes are not linked to their owner
+		serverSavePlayer(player);
+	}
+}
+
+void Game::captureBeforeChange(Player* player)
+{
+	if (serverSaveStart != 0) {
+		serverSavePlayer(player);
+	}
+}
+
+void Game::serverSaveCylinder(Cylinder* cylinder)
+{
+	Cylinder* topParent = cylinder;
+	if (Item* item = cylinder->getItem()) {
+		topParent = item->getTopParent();
+	}
+
+	if (Creature* creature = topParent->getCreature()) {
+		if (Player* player = creature->getPlayer()) {
+			serverSavePlayer(player);
+		}
+	} else if (Tile* tile = topParent->getTile()) {
+		if (HouseTile* houseTile = tile->getHouseTile()) {
+			serverSaveHouse(houseTile->getHouse());
+		}
+	}
+}
+
+void Game::serverSavePlayer(Player* player)
+{
+	if (serverSavePlayers.erase(player->getID()) != 0) {
+		player->loginPosition = player->getPosition();
+		IOLoginData::savePlayerAsync(player);
+	}
+}
+
+void Game::serverSaveHouse(House* house)
+{
+	if (serverSaveHouses.erase(house->getId()) != 0) {
+		IOMapSerialize::saveHouseAsync(house);
+	}
+}
+
 bool Game::loadMainMap(const std::string& filename)
 {
 	return map.loadMap("data/world/" + filename + ".otbm", true, false);
@@ -1081,6 +1199,8 @@ ReturnValue Game::internalMoveItem(Cylinder* fromCylinder, Cylinder* toCylinder,
                                    Creature* actor /* = nullptr*/, Item* tradeItem /* = nullptr*/,
                                    const Position* fromPos /*= nullptr*/, const Position* toPos /*= nullptr*/)
 {
+	captureBeforeMove(fromCylinder, toCylinder, actor);
+
 	Player* actorPlayer = actor ? actor->getPlayer() : nullptr;
 	if (actorPlayer && fromPos && toPos) {
 		const ReturnValue ret =
@@ -1285,9 +1405,7 @@ ReturnValue Game::internalMoveItem(Cylinder* fromCylinder, Cylinder* toCylinder,
 
 	if (moveItem && moveItem->getDuration() > 0) {
 		if (moveItem->getDecaying() != DECAYING_TRUE) {
-			moveItem->incrementReferenceCounter();
-			moveItem->setDecaying(DECAYING_TRUE);
-			toDecayItems.push_front(moveItem);
+			scheduleDecay(moveItem);
 		}
 	}
 
@@ -1389,9 +1507,7 @@ ReturnValue Game::internalAddItem(Cylinder* toCylinder, Item* item, int32_t inde
 
 	if (item->getDuration() > 0) {
 		if (item->getDecaying() != DECAYING_TRUE) {
-			item->incrementReferenceCounter();
-			item->setDecaying(DECAYING_TRUE);
-			toDecayItems.push_front(item);
+			scheduleDecay(item);
 		}
 	}
 
@@ -1435,9 +1551,7 @@ ReturnValue Game::internalRemoveItem(Item* item, int32_t count /*= -1*/, bool te
 
 		if (item->isRemoved()) {
 			item->onRemoved();
-			if (item->canDecay()) {
-				decayItems->remove(item);
-			}
+			stopDecay(item);
 			ReleaseItem(item);
 		}
 
@@ -1708,6 +1822,7 @@ Item* Game::transformItem(Item* item, uint16_t newId, int32_t newCount /*= -1*/)
 
 					item->setParent(nullptr);
 					cylinder->postRemoveNotification(item, cylinder, itemIndex);
+					stopDecay(item);
 					ReleaseItem(item);
 					return newItem;
 				}
@@ -1753,13 +1868,12 @@ Item* Game::transformItem(Item* item, uint16_t newId, int32_t newCount /*= -1*/)
 
 	item->setParent(nullptr);
 	cylinder->postRemoveNotification(item, cylinder, itemIndex);
+	stopDecay(item);
 	ReleaseItem(item);
 
 	if (newItem->getDuration() > 0) {
 		if (newItem->getDecaying() != DECAYING_TRUE) {
-			newItem->incrementReferenceCounter();
-			newItem->setDecaying(DECAYING_TRUE);
-			toDecayItems.push_front(newItem);
+			scheduleDecay(newItem);
 		}
 	}
 
@@ -3808,10 +3922,12 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, const std:
 	}
 
 	// send to client
+	NetworkMessage msg;
+	ProtocolGame::AddCreatureSay(msg, creature, type, text, *pos);
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			if (!ghostMode || tmpPlayer->canSeeCreature(creature)) {
-				tmpPlayer->sendCreatureSay(creature, type, text, pos);
+				tmpPlayer->sendNetworkMessage(msg);
 			}
 		}
 	}
@@ -3854,22 +3970,74 @@ void Game::checkCreatureAttack(uint32_t creatureId)
 
 void Game::addCreatureCheck(Creature* creature)
 {
-	creature->creatureCheck = true;
-
 	if (creature->inCheckCreaturesVector) {
-		// already in a vector
+		// already in a list, only reactivate it
+		creatureChecks[creature->creatureCheckBucket][creature->creatureCheckGroup]
+		    .active[creature->creatureCheckIndex] = 1;
 		return;
 	}
 
+	uint8_t group;
+	if (creature->getPlayer()) {
+		group = CREATURE_CHECK_PLAYERS;
+	} else if (creature->getMonster()) {
+		group = CREATURE_CHECK_MONSTERS;
+	} else {
+		group = CREATURE_CHECK_NPCS;
+	}
+
+	uint8_t bucket = static_cast<uint8_t>(uniform_random(0, EVENT_CREATURECOUNT - 1));
+	CreatureCheckList& checkList = creatureChecks[bucket][group];
+
 	creature->inCheckCreaturesVector = true;
-	checkCreatureLists[uniform_random(0, EVENT_CREATURECOUNT - 1)].push_back(creature);
+	creature->creatureCheckBucket = bucket;
+	creature->creatureCheckGroup = group;
+	creature->creatureCheckIndex = static_cast<uint32_t>(checkList.creatures.size());
+	checkList.creatures.push_back(creature);
+	checkList.active.push_back(1);
 	creature->incrementReferenceCounter();
 }
 
 void Game::removeCreatureCheck(Creature* creature)
 {
 	if (creature->inCheckCreaturesVector) {
-		creature->creatureCheck = false;
+		creatureChecks[creature->creatureCheckBucket][creature->creatureCheckGroup]
+		    .active[creature->creatureCheckIndex] = 0;
+	}
+}
+
+void Game::eraseCreatureCheck(CreatureCheckList& checkList, size_t index)
+{
+	Creature* last = checkList.creatures.back();
+	last->creatureCheckIndex = static_cast<uint32_t>(index);
+	checkList.creatures[index] = last;
+	checkList.active[index] = checkList.active.back();
+
+	checkList.creatures.pop_back();
+	checkList.active.pop_back();
+}
+
+template <typename CreatureType>
+void Game::checkCreatureList(CreatureCheckList& checkList)
+{
+	// the lists may grow while iterating, creatures added during this pass are checked as well
+	for (size_t i = 0; i < checkList.creatures.size();) {
+		if (!checkList.active[i]) {
+			Creature* creature = checkList.creatures[i];
+			creature->inCheckCreaturesVector = false;
+			eraseCreatureCheck(checkList, i);
+			ReleaseCreature(creature);
+			continue;
+		}
+
+		// the concrete types are final, so these calls are resolved statically
+		auto creature = static_cast<CreatureType*>(checkList.creatures[i]);
+		if (!creature->isDead()) {
+			creature->onThink(EVENT_CREATURE_THINK_INTERVAL);
+			creature->onAttacking(EVENT_CREATURE_THINK_INTERVAL);
+			creature->executeConditions(EVENT_CREATURE_THINK_INTERVAL);
+		}
+		++i;
 	}
 }
 
@@ -3878,24 +4046,23 @@ void Game::checkCreatures(size_t index)
 	g_scheduler.addEvent(createSchedulerTask(EVENT_CHECK_CREATURE_INTERVAL,
 	                                         [=, this]() { checkCreatures((index + 1) % EVENT_CREATURECOUNT); }));
 
-	auto& checkCreatureList = checkCreatureLists[index];
-	auto it = checkCreatureList.begin(), end = checkCreatureList.end();
-	while (it != end) {
-		Creature* creature = *it;
-		if (creature->creatureCheck) {
-			if (!creature->isDead()) {
-				creature->onThink(EVENT_CREATURE_THINK_INTERVAL);
-				creature->onAttacking(EVENT_CREATURE_THINK_INTERVAL);
-				creature->executeConditions(EVENT_CREATURE_THINK_INTERVAL);
+	auto& checkLists = creatureChecks[index];
+	if (g_dispatcher.hasWorkers()) {
+		// the line of sight checks of the target search only read the map, so they run up front on all threads
+		CreatureCheckList& monsters = checkLists[CREATURE_CHECK_MONSTERS];
+		g_dispatcher.parallelFor(monsters.creatures.size(), [&monsters](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				if (monsters.active[i]) {
+					static_cast<Monster*>(monsters.creatures[i])->prepareTargetSearch();
+				}
 			}
-			++it;
-		} else {
-			creature->inCheckCreaturesVector = false;
-			it = checkCreatureList.erase(it);
-			ReleaseCreature(creature);
-		}
+		});
 	}
 
+	checkCreatureList<Player>(checkLists[CREATURE_CHECK_PLAYERS]);
+	checkCreatureList<Monster>(checkLists[CREATURE_CHECK_MONSTERS]);
+	checkCreatureList<Creature>(checkLists[CREATURE_CHECK_NPCS]);
+
 	cleanup();
 }
 
@@ -3904,10 +4071,12 @@ void Game::updateCreaturesPath(size_t index)
 	g_scheduler.addEvent(createSchedulerTask(getNumber(ConfigManager::PATHFINDING_INTERVAL),
 	                                         [=, this]() { updateCreaturesPath((index + 1) % EVENT_CREATURECOUNT); }));
 
-	auto& checkCreatureList = checkCreatureLists[index];
-	for (Creature* creature : checkCreatureList) {
-		if (!creature->isDead()) {
-			creature->forceUpdatePath();
+	for (const CreatureCheckList& checkList : creatureChecks[index]) {
+		for (size_t i = 0, size = checkList.creatures.size(); i < size; ++i) {
+			Creature* creature = checkList.creatures[i];
+			if (checkList.active[i] && !creature->isDead()) {
+				creature->forceUpdatePath();
+			}
 		}
 	}
 }
@@ -4696,9 +4865,11 @@ void Game::addCreatureHealth(const Creature* target)
 
 void Game::addCreatureHealth(const SpectatorVec& spectators, const Creature* target)
 {
+	NetworkMessage msg;
+	ProtocolGame::AddCreatureHealth(msg, target);
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
-			tmpPlayer->sendCreatureHealth(target);
+			tmpPlayer->sendNetworkMessage(msg);
 		}
 	}
 }
@@ -4712,9 +4883,13 @@ void Game::addMagicEffect(const Position& pos, uint8_t effect)
 
 void Game::addMagicEffect(const SpectatorVec& spectators, const Position& pos, uint8_t effect)
 {
+	NetworkMessage msg;
+	ProtocolGame::AddMagicEffect(msg, pos, effect);
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
-			tmpPlayer->sendMagicEffect(pos, effect);
+			if (tmpPlayer->canSee(pos)) {
+				tmpPlayer->sendNetworkMessage(msg);
+			}
 		}
 	}
 }
@@ -4732,9 +4907,11 @@ void Game::addDistanceEffect(const Position& fromPos, const Position& toPos, uin
 void Game::addDistanceEffect(const SpectatorVec& spectators, const Position& fromPos, const Position& toPos,
                              uint8_t effect)
 {
+	NetworkMessage msg;
+	ProtocolGame::AddDistanceShoot(msg, fromPos, toPos, effect);
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
-			tmpPlayer->sendDistanceShoot(fromPos, toPos, effect);
+			tmpPlayer->sendNetworkMessage(msg);
 		}
 	}
 }
@@ -4751,14 +4928,47 @@ void Game::startDecay(Item* item)
 	}
 
 	if (item->getDuration() > 0) {
-		item->incrementReferenceCounter();
-		item->setDecaying(DECAYING_TRUE);
-		toDecayItems.push_front(item);
+		scheduleDecay(item);
 	} else {
 		internalDecayItem(item);
 	}
 }
 
+void Game::scheduleDecay(Item* item)
+{
+	uint32_t duration = item->getDuration();
+	if (uint32_t slot = item->getDecaySlot()) {
+		decayWheel.remove(slot);
+	} else {
+		item->incrementReferenceCounter();
+	}
+
+	uint64_t ticks = (duration + EVENT_DECAYINTERVAL - 1) / EVENT_DECAYINTERVAL;
+	item->setDecaying(DECAYING_TRUE);
+	item->setDecaySlot(decayWheel.add(item, decayWheel.getCurrentTick() + ticks));
+}
+
+void Game::stopDecay(Item* item)
+{
+	uint32_t slot = item->getDecaySlot();
+	if (slot == 0) {
+		return;
+	}
+
+	// keep what is left of the duration, as if the item had been decaying up to now
+	item->setIntAttr(ITEM_ATTRIBUTE_DURATION, getDecayDuration(item));
+	decayWheel.remove(slot);
+	item->setDecaySlot(0);
+	item->setDecaying(DECAYING_FALSE);
+	ReleaseItem(item);
+}
+
+uint32_t Game::getDecayDuration(const Item* item) const
+{
+	uint64_t expiryTick = decayWheel.getExpiryTick(item->getDecaySlot());
+	return (expiryTick - decayWheel.getCurrentTick()) * EVENT_DECAYINTERVAL;
+}
+
 void Game::internalDecayItem(Item* item)
 {
 	const int32_t decayTo = item->getDecayTo();
@@ -4781,43 +4991,22 @@ void Game::internalDecayItem(Item* item)
 void Game::checkDecay()
 {
 	g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL, [this]() { checkDecay(); }));
-	size_t bucket = (lastBucket + 1) % EVENT_DECAY_BUCKETS;
 
-	auto it = decayItems[bucket].begin(), end = decayItems[bucket].end();
-	while (it != end) {
-		Item* item = *it;
+	decayWheel.advance(expiredDecayItems);
+	for (Item* item : expiredDecayItems) {
+		item->setDecaySlot(0);
 		if (!item->canDecay()) {
 			item->setDecaying(DECAYING_FALSE);
 			ReleaseItem(item);
-			it = decayItems[bucket].erase(it);
 			continue;
 		}
 
-		int32_t duration = item->getDuration();
-		int32_t decreaseTime = std::min<int32_t>(EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS, duration);
-
-		duration -= decreaseTime;
-		item->decreaseDuration(decreaseTime);
-
-		if (duration <= 0) {
-			it = decayItems[bucket].erase(it);
-			internalDecayItem(item);
-			ReleaseItem(item);
-		} else if (duration < EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS) {
-			it = decayItems[bucket].erase(it);
-			size_t newBucket = (bucket + ((duration + EVENT_DECAYINTERVAL / 2) / 1000)) % EVENT_DECAY_BUCKETS;
-			if (newBucket == bucket) {
-				internalDecayItem(item);
-				ReleaseItem(item);
-			} else {
-				decayItems[newBucket].push_back(item);
-			}
-		} else {
-			++it;
-		}
+		item->setIntAttr(ITEM_ATTRIBUTE_DURATION, 0);
+		internalDecayItem(item);
+		ReleaseItem(item);
 	}
+	expiredDecayItems.clear();
 
-	lastBucket = bucket;
 	cleanup();
 }
 
@@ -4853,16 +5042,6 @@ void Game::cleanup()
 		item->decrementReferenceCounter();
 	}
 	ToReleaseItems.clear();
-
-	for (Item* item : toDecayItems) {
-		const uint32_t dur = item->getDuration();
-		if (dur >= EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS) {
-			decayItems[lastBucket].push_back(item);
-		} else {
-			decayItems[(lastBucket + 1 + dur / 1000) % EVENT_DECAY_BUCKETS].push_back(item);
-		}
-	}
-	toDecayItems.clear();
 }
 
 void Game::ReleaseCreature(Creature* creature) { ToReleaseCreatures.push_back(creature); }
@@ -5420,6 +5599,12 @@ void Game::playerAcceptMarketOffer(uint32_t playerId, uint32_t timestamp, uint16
 		return;
 	}
 
+	// money and items change hands between both players, the incremental server save may have written one of them
+	captureBeforeChange(player);
+	if (Player* offerPlayer = getPlayerByGUID(offer.playerId)) {
+		captureBeforeChange(offerPlayer);
+	}
+
 	uint64_t totalPrice = offer.price * amount;
 
 	if (offer.type == MARKETACTION_BUY) {
@@ -4,6 +4,7 @@
 #ifndef FS_GAME_H
 #define FS_GAME_H
 
+#include "decay.h"
 #include "groups.h"
 #include "map.h"
 #include "mounts.h"
@@ -45,7 +46,6 @@ enum GameState_t
 static constexpr int32_t PLAYER_NAME_LENGTH = 25;
 
 static constexpr int32_t EVENT_DECAYINTERVAL = 250;
-static constexpr int32_t EVENT_DECAY_BUCKETS = 4;
 
 static constexpr int32_t MOVE_CREATURE_INTERVAL = 1000;
 static constexpr int32_t RANGE_MOVE_CREATURE_INTERVAL = 1500;
@@ -203,7 +203,7 @@ public:
 	void executeDeath(uint32_t creatureId);
 
 	void addCreatureCheck(Creature* creature);
-	static void removeCreatureCheck(Creature* creature);
+	void removeCreatureCheck(Creature* creature);
 
 	size_t getPlayersOnline() const { return players.size(); }
 	size_t getMonstersOnline() const { return monsters.size(); }
@@ -417,8 +417,21 @@ public:
 
 	GameState_t getGameState() const;
 	void setGameState(GameState_t newState);
+
+	/**
+	 * Saves every player and house. While the game is running normally and incrementalServerSave is enabled, they are
+	 * captured a few at a time on the following scheduler ticks instead, for at most serverSaveTickBudget milliseconds
+	 * per tick, and written on the database thread.
+	 */
 	void saveGameState();
 
+	/**
+	 * Captures the players and houses holding the cylinders, and the acting player, before an item moves between
+	 * them if the incremental server save has not reached them yet, so that the save holds the item exactly once.
+	 */
+	void captureBeforeMove(Cylinder* fromCylinder, Cylinder* toCylinder, Creature* actor);
+	void captureBeforeChange(Player* player);
+
 	// Events
 	void checkCreatureWalk(uint32_t creatureId);
 	void updateCreatureWalk(uint32_t creatureId);
@@ -445,6 +458,14 @@ public:
 
 	void startDecay(Item* item);
 
+	/**
+	 * Makes the item decay once its current duration has elapsed, rescheduling it if it is decaying already. The item
+	 * is referenced until it decays or stopDecay is called.
+	 */
+	void scheduleDecay(Item* item);
+	void stopDecay(Item* item);
+	uint32_t getDecayDuration(const Item* item) const;
+
 	void sendOfflineTrainingDialog(Player* player);
 
 	const std::unordered_map<uint32_t, Player*>& getPlayers() const { return players; }
@@ -485,8 +506,6 @@ public:
 	Map map;
 	Mounts mounts;
 
-	std::forward_list<Item*> toDecayItems;
-
 	std::unordered_set<Tile*> getTilesToClean() const { return tilesToClean; }
 	bool isTileInCleanList(Tile* tile) { return tilesToClean.find(tile) != tilesToClean.end(); }
 	void addTileToClean(Tile* tile) { tilesToClean.emplace(tile); }
@@ -503,20 +522,48 @@ private:
 	void checkDecay();
 	void internalDecayItem(Item* item);
 
+	void continueServerSave();
+	void serverSaveCylinder(Cylinder* cylinder);
+	void serverSavePlayer(Player* player);
+	void serverSaveHouse(House* house);
+
+	/**
+	 * Creatures thinking on one of the EVENT_CREATURECOUNT buckets, stored per creature type. The active flags are
+	 * kept in their own array parallel to the creatures, so creatures that stopped thinking are skipped and dropped
+	 * without touching their objects.
+	 */
+	struct CreatureCheckList
+	{
+		std::vector<Creature*> creatures;
+		std::vector<uint8_t> active;
+	};
+
+	enum CreatureCheckGroup : uint8_t
+	{
+		CREATURE_CHECK_PLAYERS,
+		CREATURE_CHECK_MONSTERS,
+		CREATURE_CHECK_NPCS,
+
+		CREATURE_CHECK_GROUP_COUNT,
+	};
+
+	template <typename CreatureType>
+	void checkCreatureList(CreatureCheckList& checkList);
+	void eraseCreatureCheck(CreatureCheckList& checkList, size_t index);
+
 	std::unordered_map<uint32_t, Player*> players;
 	std::unordered_map<std::string, Player*> mappedPlayerNames;
 	std::unordered_map<uint32_t, Player*> mappedPlayerGuids;
 	std::unordered_map<uint32_t, Guild_ptr> guilds;
 	std::unordered_map<uint16_t, Item*> uniqueItems;
 
-	std::list<Item*> decayItems[EVENT_DECAY_BUCKETS];
-	std::list<Creature*> checkCreatureLists[EVENT_CREATURECOUNT];
+	DecayWheel decayWheel;
+	std::vector<Item*> expiredDecayItems;
+	std::array<std::array<CreatureCheckList, CREATURE_CHECK_GROUP_COUNT>, EVENT_CREATURECOUNT> creatureChecks;
 
 	std::vector<Creature*> ToReleaseCreatures;
 	std::vector<Item*> ToReleaseItems;
 
-	size_t lastBucket = 0;
-
 	WildcardTreeNode wildcardTree{false};
 
 	std::map<uint32_t, Npc*> npcs;
@@ -529,6 +576,11 @@ private:
 
 	std::unordered_set<Tile*> tilesToClean;
 
+	// players and houses the running incremental server save has not captured yet
+	std::set<uint32_t> serverSavePlayers;
+	std::set<uint32_t> serverSaveHouses;
+	int64_t serverSaveStart = 0;
+
 	ModalWindow offlineTrainingWindow{std::numeric_limits<uint32_t>::max(), "Choose a Skill", "Please choose a skill:"};
 
 	GameState_t gameState = GAME_STATE_NORMAL;
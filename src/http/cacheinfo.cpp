@@ -11,7 +11,7 @@ using boost::beast::http::status;
 
 std::pair<status, json::value> tfs::http::handle_cacheinfo(const json::object&, std::string_view)
 {
-	thread_local auto& db = Database::getInstance();
+	auto& db = Database::getThreadInstance();
 	auto result = db.storeQuery("SELECT COUNT(*) AS `count` FROM `players_online`");
 	if (!result) {
 		return make_error_response();
@@ -1,7 +1,10 @@
 #define BOOST_ASIO_NO_DEPRECATED
 
+#include "../otpch.h"
+
 #include "http.h"
 
+#include "../database.h"
 #include "listener.h"
 
 #include <fmt/core.h>
@@ -34,7 +37,14 @@ void tfs::http::start(bool bindOnlyOtsIP, std::string_view otsIP, unsigned short
 
 	workers.reserve(threads);
 	for (auto i = 0; i < threads; ++i) {
-		workers.emplace_back([] { ioc.run(); });
+		workers.emplace_back([] {
+			// requests are served on their own connection rather than the one of the game
+			if (!Database::connectThreadInstance()) {
+				fmt::print("[Warning - tfs::http::start] Could not connect to the database, using the connection of "
+				           "the game.\n");
+			}
+			ioc.run();
+		});
 	}
 }
 
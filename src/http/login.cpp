@@ -49,10 +49,10 @@ std::pair<status, json::value> tfs::http::handle_login(const json::object& body,
 		    {.code = 3, .message = "Tibia account email address or Tibia password is not correct."});
 	}
 
-	thread_local auto& db = Database::getInstance();
-	auto result = db.storeQuery(fmt::format(
-	    "SELECT `id`, UNHEX(`password`) AS `password`, `secret`, `premium_ends_at` FROM `accounts` WHERE `email` = {:s}",
-	    db.escapeString(emailField->get_string())));
+	auto& db = Database::getThreadInstance();
+	auto result = db.storeStatement(
+	    "SELECT `id`, UNHEX(`password`) AS `password`, `secret`, `premium_ends_at` FROM `accounts` WHERE `email` = ?",
+	    emailField->get_string());
 	if (!result) {
 		return make_error_response(
 		    {.code = 3, .message = "Tibia account email address or Tibia password is not correct."});
@@ -85,15 +85,14 @@ std::pair<status, json::value> tfs::http::handle_login(const json::object& body,
 	auto premiumEndsAt = result->getNumber<int64_t>("premium_ends_at");
 
 	std::string sessionKey = randomBytes(16);
-	if (!db.executeQuery(
-	        fmt::format("INSERT INTO `sessions` (`token`, `account_id`, `ip`) VALUES ({:s}, {:d}, INET6_ATON({:s}))",
-	                    db.escapeString(sessionKey), accountId, db.escapeString(ip)))) {
+	if (!db.executeStatement("INSERT INTO `sessions` (`token`, `account_id`, `ip`) VALUES (?, ?, INET6_ATON(?))",
+	                         sessionKey, accountId, ip)) {
 		return make_error_response();
 	}
 
-	result = db.storeQuery(fmt::format(
-	    "SELECT `id`, `name`, `level`, `vocation`, `lastlogin`, `sex`, `looktype`, `lookhead`, `lookbody`, `looklegs`, `lookfeet`, `lookaddons` FROM `players` WHERE `account_id` = {:d}",
-	    accountId));
+	result = db.storeStatement(
+	    "SELECT `id`, `name`, `level`, `vocation`, `lastlogin`, `sex`, `looktype`, `lookhead`, `lookbody`, `looklegs`, `lookfeet`, `lookaddons` FROM `players` WHERE `account_id` = ?",
+	    accountId);
 
 	json::array characters;
 	uint32_t lastLogin = 0;
@@ -166,6 +166,18 @@ BOOST_FIXTURE_TEST_CASE(test_login_account_does_not_exist, LoginFixture)
 	BOOST_TEST(body.at("errorCode").as_int64() == 3);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_login_email_is_not_sql, LoginFixture)
+{
+	BOOST_TEST(db.executeQuery(
+	    "INSERT INTO `accounts` (`name`, `email`, `password`) VALUES ('ijk', 'quote@example.com', SHA1('bar'))"));
+
+	auto&& [status, body] = tfs::http::handle_login(
+	    {{"type", "login"}, {"email", "' OR `email` = 'quote@example.com"}, {"password", "bar"}}, ip);
+
+	BOOST_TEST(status == status::ok);
+	BOOST_TEST(body.at("errorCode").as_int64() == 3);
+}
+
 BOOST_FIXTURE_TEST_CASE(test_login_missing_password, LoginFixture)
 {
 	auto&& [status, body] = tfs::http::handle_login({{"type", "login"}, {"email", "foo@example.com"}}, ip);
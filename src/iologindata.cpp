@@ -7,6 +7,7 @@
 
 #include "condition.h"
 #include "configmanager.h"
+#include "databasetasks.h"
 #include "depotchest.h"
 #include "game.h"
 #include "inbox.h"
@@ -14,6 +15,211 @@
 
 extern Game g_game;
 
+enum PlayerSaveSection_t : uint8_t
+{
+	PLAYER_SAVE_SPELLS,
+	PLAYER_SAVE_ITEMS,
+	PLAYER_SAVE_DEPOT_ITEMS,
+	PLAYER_SAVE_INBOX_ITEMS,
+	PLAYER_SAVE_STORE_INBOX_ITEMS,
+	PLAYER_SAVE_STORAGE,
+	PLAYER_SAVE_OUTFITS,
+	PLAYER_SAVE_MOUNTS,
+
+	PLAYER_SAVE_LAST
+};
+
+/**
+ * Fingerprints of the rows of each section of a player. A section is only written again when its fingerprint differs
+ * from the last one captured, or when that one is not committed yet, as a queued save may still fail.
+ */
+struct PlayerSaveState
+{
+	// captured on the dispatcher
+	std::array<uint64_t, PLAYER_SAVE_LAST> captured = {};
+	// loaded, or written by the database thread
+	std::array<std::atomic<uint64_t>, PLAYER_SAVE_LAST> committed = {};
+};
+
+struct PlayerItemRow
+{
+	int32_t pid;
+	int32_t sid;
+	uint16_t itemType;
+	uint16_t count;
+	std::string attributes;
+};
+
+/**
+ * Persistent state of a player at the time of the save, with the items already serialized so it can be written
+ * without touching the player again.
+ */
+struct PlayerSnapshot
+{
+	uint32_t guid = 0;
+	std::string name;
+	time_t lastLoginSaved = 0;
+	Connection::Address lastIP = {};
+
+	uint32_t level = 0;
+	uint16_t groupId = 0;
+	uint16_t vocationId = 0;
+	int32_t health = 0;
+	int32_t healthMax = 0;
+	uint64_t experience = 0;
+	Outfit_t outfit;
+	uint8_t currentMount = 0;
+	bool randomizeMount = false;
+	uint32_t magLevel = 0;
+	uint32_t mana = 0;
+	uint32_t manaMax = 0;
+	uint64_t manaSpent = 0;
+	uint8_t soul = 0;
+	uint32_t townId = 0;
+	Position loginPosition;
+	uint32_t capacity = 0;
+	PlayerSex_t sex = PLAYERSEX_FEMALE;
+	std::string conditions;
+
+	bool saveSkull = false;
+	int64_t skullTime = 0;
+	Skulls_t skull = SKULL_NONE;
+
+	time_t lastLogout = 0;
+	uint64_t bankBalance = 0;
+	int32_t offlineTrainingTime = 0;
+	int32_t offlineTrainingSkill = 0;
+	uint16_t staminaMinutes = 0;
+	std::array<std::pair<uint16_t, uint64_t>, SKILL_LAST + 1> skills = {};
+	Direction direction = DIRECTION_SOUTH;
+	time_t onlineTime = 0;
+	unsigned long blessings = 0;
+
+	std::vector<std::string> learnedSpells;
+	std::vector<PlayerItemRow> items;
+	std::vector<PlayerItemRow> depotItems;
+	std::vector<PlayerItemRow> inboxItems;
+	std::vector<PlayerItemRow> storeInboxItems;
+	std::map<uint32_t, int32_t> storage;
+	std::map<uint16_t, uint8_t> outfits;
+	std::vector<uint16_t> mounts;
+
+	std::shared_ptr<PlayerSaveState> saveState;
+	std::array<uint64_t, PLAYER_SAVE_LAST> hashes = {};
+	std::bitset<PLAYER_SAVE_LAST> changed;
+
+	bool setHash(PlayerSaveSection_t section, uint64_t hash)
+	{
+		hashes[section] = hash;
+		changed[section] = saveState->captured[section] != hash ||
+		                   saveState->committed[section].load(std::memory_order_relaxed) != hash;
+		saveState->captured[section] = hash;
+		return changed[section];
+	}
+};
+
+namespace {
+
+// fingerprint of a section without rows, a state that is not known yet (zero) never matches it
+constexpr uint64_t EMPTY_SECTION_HASH = 0x9E3779B97F4A7C15;
+
+uint64_t mixHash(uint64_t value)
+{
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+	return value ^ (value >> 31);
+}
+
+// rows are summed into the fingerprint of their section, so the order they are read or written in does not matter
+uint64_t hashRow(std::initializer_list<uint64_t> fields, std::string_view bytes = {})
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (uint64_t field : fields) {
+		hash = mixHash(hash ^ field);
+	}
+	for (char byte : bytes) {
+		hash = (hash ^ static_cast<uint8_t>(byte)) * 0x100000001B3;
+	}
+	return mixHash(hash);
+}
+
+uint64_t hashItemRows(const std::vector<PlayerItemRow>& rows)
+{
+	uint64_t hash = EMPTY_SECTION_HASH;
+	for (const PlayerItemRow& row : rows) {
+		hash += hashRow({static_cast<uint32_t>(row.pid), static_cast<uint32_t>(row.sid), row.itemType, row.count},
+		                row.attributes);
+	}
+	return hash;
+}
+
+struct PendingSave
+{
+	uint32_t count = 0;
+	// dispatcher tasks to add once the count drops to zero
+	std::vector<TaskFunc> waiting;
+};
+
+std::mutex pendingSaveLock;
+std::condition_variable pendingSaveSignal;
+std::unordered_map<uint32_t, PendingSave> pendingSaves;
+
+void beginPendingSave(uint32_t guid)
+{
+	std::lock_guard<std::mutex> lockGuard(pendingSaveLock);
+	++pendingSaves[guid].count;
+}
+
+void endPendingSave(uint32_t guid)
+{
+	std::vector<TaskFunc> waiting;
+	{
+		std::lock_guard<std::mutex> lockGuard(pendingSaveLock);
+		auto it = pendingSaves.find(guid);
+		if (--it->second.count == 0) {
+			waiting = std::move(it->second.waiting);
+			pendingSaves.erase(it);
+		}
+	}
+	pendingSaveSignal.notify_all();
+
+	for (TaskFunc& f : waiting) {
+		g_dispatcher.addTask(std::move(f));
+	}
+}
+
+// returns whether a save of the player was still running
+bool waitForPendingSave(uint32_t guid)
+{
+	std::unique_lock<std::mutex> lockUnique(pendingSaveLock);
+	if (!pendingSaves.contains(guid)) {
+		return false;
+	}
+
+	pendingSaveSignal.wait(lockUnique, [guid]() { return !pendingSaves.contains(guid); });
+	return true;
+}
+
+bool saveItemRows(Database& db, uint32_t guid, std::string_view table, const std::vector<PlayerItemRow>& rows)
+{
+	if (!db.executeStatement(fmt::format("DELETE FROM `{:s}` WHERE `player_id` = ?", table), guid)) {
+		return false;
+	}
+
+	DBInsert query(
+	    fmt::format("INSERT INTO `{:s}` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ", table),
+	    db);
+	for (const PlayerItemRow& row : rows) {
+		if (!query.addRow(fmt::format("{:d}, {:d}, {:d}, {:d}, {:d}, {:s}", guid, row.pid, row.sid, row.itemType,
+		                              row.count, db.escapeString(row.attributes)))) {
+			return false;
+		}
+	}
+	return query.execute();
+}
+
+} // namespace
+
 uint32_t IOLoginData::getAccountIdByPlayerName(const std::string& playerName)
 {
 	Database& db = Database::getInstance();
@@ -67,13 +273,25 @@ void IOLoginData::updateOnlineStatus(uint32_t guid, bool login)
 	}
 }
 
+bool IOLoginData::runAfterPendingSave(uint32_t guid, TaskFunc&& f)
+{
+	std::lock_guard<std::mutex> lockGuard(pendingSaveLock);
+	auto it = pendingSaves.find(guid);
+	if (it == pendingSaves.end()) {
+		return false;
+	}
+
+	it->second.waiting.push_back(std::move(f));
+	return true;
+}
+
 bool IOLoginData::preloadPlayer(Player* player)
 {
 	Database& db = Database::getInstance();
 
-	DBResult_ptr result = db.storeQuery(fmt::format(
-	    "SELECT `p`.`name`, `p`.`account_id`, `p`.`group_id`, `a`.`type`, `a`.`premium_ends_at` FROM `players` AS `p` JOIN `accounts` AS `a` ON `a`.`id` = `p`.`account_id` WHERE `p`.`id` = {:d} AND `p`.`deletion` = 0",
-	    player->getGUID()));
+	DBResult_ptr result = db.storeStatement(
+	    "SELECT `p`.`name`, `p`.`account_id`, `p`.`group_id`, `a`.`type`, `a`.`premium_ends_at` FROM `players` AS `p` JOIN `accounts` AS `a` ON `a`.`id` = `p`.`account_id` WHERE `p`.`id` = ? AND `p`.`deletion` = 0",
+	    player->getGUID());
 	if (!result) {
 		return false;
 	}
@@ -94,29 +312,36 @@ bool IOLoginData::preloadPlayer(Player* player)
 
 bool IOLoginData::loadPlayerById(Player* player, uint32_t id)
 {
+	// logins are deferred with runAfterPendingSave, this only blocks the loads of offline players
+	waitForPendingSave(id);
+
 	Database& db = Database::getInstance();
 	return loadPlayer(
 	    player,
-	    db.storeQuery(fmt::format(
-	        "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `lookmount`, `lookmounthead`, `lookmountbody`, `lookmountlegs`, `lookmountfeet`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `offlinetraining_time`, `offlinetraining_skill`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction` FROM `players` WHERE `id` = {:d}",
-	        id)));
+	    db.storeStatement(
+	        "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `lookmount`, `lookmounthead`, `lookmountbody`, `lookmountlegs`, `lookmountfeet`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `offlinetraining_time`, `offlinetraining_skill`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction` FROM `players` WHERE `id` = ?",
+	        id));
 }
 
 bool IOLoginData::loadPlayerByName(Player* player, const std::string& name)
 {
 	Database& db = Database::getInstance();
-	return loadPlayer(
-	    player,
-	    db.storeQuery(fmt::format(
-	        "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `lookmount`, `lookmounthead`, `lookmountbody`, `lookmountlegs`, `lookmountfeet`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `offlinetraining_time`, `offlinetraining_skill`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction` FROM `players` WHERE `name` = {:s}",
-	        db.escapeString(name))));
+	DBResult_ptr result = db.storeStatement(
+	    "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `lookmount`, `lookmounthead`, `lookmountbody`, `lookmountlegs`, `lookmountfeet`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `offlinetraining_time`, `offlinetraining_skill`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction` FROM `players` WHERE `name` = ?",
+	    name);
+
+	// the row was read before a save of the player finished
+	if (result && waitForPendingSave(result->getNumber<uint32_t>("id"))) {
+		return loadPlayerById(player, result->getNumber<uint32_t>("id"));
+	}
+	return loadPlayer(player, result);
 }
 
 static GuildWarVector getWarList(uint32_t guildId)
 {
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `guild1`, `guild2` FROM `guild_wars` WHERE (`guild1` = {:d} OR `guild2` = {:d}) AND `ended` = 0 AND `status` = 1",
-	    guildId, guildId));
+	DBResult_ptr result = Database::getInstance().storeStatement(
+	    "SELECT `guild1`, `guild2` FROM `guild_wars` WHERE (`guild1` = ? OR `guild2` = ?) AND `ended` = 0 AND `status` = 1",
+	    guildId, guildId);
 	if (!result) {
 		return {};
 	}
@@ -143,8 +368,7 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 
 	uint32_t accountId = result->getNumber<uint32_t>("account_id");
 
-	auto account =
-	    db.storeQuery(fmt::format("SELECT `type`, `premium_ends_at` FROM `accounts` WHERE `id` = {:d}", accountId));
+	auto account = db.storeStatement("SELECT `type`, `premium_ends_at` FROM `accounts` WHERE `id` = ?", accountId);
 	if (!account) {
 		return false;
 	}
@@ -302,9 +526,8 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		player->skills[i].percent = Player::getBasisPointLevel(skillTries, nextSkillTries);
 	}
 
-	if ((result = db.storeQuery(
-	         fmt::format("SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = {:d}",
-	                     player->getGUID())))) {
+	if ((result = db.storeStatement(
+	         "SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = ?", player->getGUID()))) {
 		uint32_t guildId = result->getNumber<uint32_t>("guild_id");
 		uint32_t playerRankId = result->getNumber<uint32_t>("rank_id");
 		player->guildNick = result->getString("nick");
@@ -324,8 +547,8 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 			player->guild = guild;
 			auto rank = guild->getRankById(playerRankId);
 			if (!rank) {
-				if ((result = db.storeQuery(fmt::format(
-				         "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `id` = {:d}", playerRankId)))) {
+				if ((result = db.storeStatement("SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `id` = ?",
+				                                playerRankId))) {
 					guild->addRank(result->getNumber<uint32_t>("id"), result->getString("name"),
 					               result->getNumber<uint16_t>("level"));
 				}
@@ -339,28 +562,36 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 			player->guildRank = rank;
 			player->guildWarVector = getWarList(guildId);
 
-			if ((result = db.storeQuery(fmt::format(
-			         "SELECT COUNT(*) AS `members` FROM `guild_membership` WHERE `guild_id` = {:d}", guildId)))) {
+			if ((result = db.storeStatement(
+			         "SELECT COUNT(*) AS `members` FROM `guild_membership` WHERE `guild_id` = ?", guildId))) {
 				guild->setMemberCount(result->getNumber<uint32_t>("members"));
 			}
 		}
 	}
 
-	if ((result = db.storeQuery(fmt::format("SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = {:d}",
-	                                        player->getGUID())))) {
+	player->saveState = std::make_shared<PlayerSaveState>();
+	std::array<uint64_t, PLAYER_SAVE_LAST> hashes;
+	hashes.fill(EMPTY_SECTION_HASH);
+
+	if ((result = db.storeStatement("SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = ?",
+	                                player->getGUID()))) {
+		uint64_t hash = EMPTY_SECTION_HASH;
 		do {
-			player->learnedInstantSpellList.emplace_front(result->getString("name"));
+			auto name = result->getString("name");
+			hash += hashRow({}, name);
+			player->learnedInstantSpellList.emplace_front(name);
 		} while (result->next());
+		hashes[PLAYER_SAVE_SPELLS] = hash;
 	}
 
 	// load inventory items
 	ItemMap itemMap;
 	std::map<uint8_t, Container*> openContainersList;
 
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
-		loadItems(itemMap, result);
+	if ((result = db.storeStatement(
+	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = ? ORDER BY `sid` DESC",
+	         player->getGUID()))) {
+		hashes[PLAYER_SAVE_ITEMS] = loadItems(itemMap, result);
 
 		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
 			const std::pair<Item*, int32_t>& pair = it->second;
@@ -399,10 +630,10 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	// load depot items
 	itemMap.clear();
 
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
-		loadItems(itemMap, result);
+	if ((result = db.storeStatement(
+	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = ? ORDER BY `sid` DESC",
+	         player->getGUID()))) {
+		hashes[PLAYER_SAVE_DEPOT_ITEMS] = loadItems(itemMap, result);
 
 		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
 			const std::pair<Item*, int32_t>& pair = it->second;
@@ -430,10 +661,10 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	// load inbox items
 	itemMap.clear();
 
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_inboxitems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
-		loadItems(itemMap, result);
+	if ((result = db.storeStatement(
+	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_inboxitems` WHERE `player_id` = ? ORDER BY `sid` DESC",
+	         player->getGUID()))) {
+		hashes[PLAYER_SAVE_INBOX_ITEMS] = loadItems(itemMap, result);
 
 		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
 			const std::pair<Item*, int32_t>& pair = it->second;
@@ -460,10 +691,10 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	// load store inbox items
 	itemMap.clear();
 
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_storeinboxitems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
-		loadItems(itemMap, result);
+	if ((result = db.storeStatement(
+	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_storeinboxitems` WHERE `player_id` = ? ORDER BY `sid` DESC",
+	         player->getGUID()))) {
+		hashes[PLAYER_SAVE_STORE_INBOX_ITEMS] = loadItems(itemMap, result);
 
 		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
 			const std::pair<Item*, int32_t>& pair = it->second;
@@ -488,35 +719,55 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	}
 
 	// load storage map
-	if ((result = db.storeQuery(
-	         fmt::format("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = {:d}", player->getGUID())))) {
+	if ((result =
+	         db.storeStatement("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = ?", player->getGUID()))) {
+		const size_t keyColumn = result->getColumnIndex("key");
+		const size_t valueColumn = result->getColumnIndex("value");
+		uint64_t hash = EMPTY_SECTION_HASH;
 		do {
-			player->setStorageValue(result->getNumber<uint32_t>("key"), result->getNumber<int32_t>("value"), true);
+			uint32_t key = result->getNumber<uint32_t>(keyColumn);
+			int32_t value = result->getNumber<int32_t>(valueColumn);
+			hash += hashRow({key, static_cast<uint32_t>(value)});
+			player->setStorageValue(key, value, true);
 		} while (result->next());
+		hashes[PLAYER_SAVE_STORAGE] = hash;
 	}
 
 	// load vip list
-	if ((result = db.storeQuery(fmt::format("SELECT `player_id` FROM `account_viplist` WHERE `account_id` = {:d}",
-	                                        player->getAccount())))) {
+	if ((result = db.storeStatement("SELECT `player_id` FROM `account_viplist` WHERE `account_id` = ?",
+	                                player->getAccount()))) {
 		do {
 			player->addVIPInternal(result->getNumber<uint32_t>("player_id"));
 		} while (result->next());
 	}
 
 	// load outfits & addons
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `outfit_id`, `addons` FROM `player_outfits` WHERE `player_id` = {:d}", player->getGUID())))) {
+	if ((result = db.storeStatement("SELECT `outfit_id`, `addons` FROM `player_outfits` WHERE `player_id` = ?",
+	                                player->getGUID()))) {
+		uint64_t hash = EMPTY_SECTION_HASH;
 		do {
-			player->addOutfit(result->getNumber<uint16_t>("outfit_id"), result->getNumber<uint8_t>("addons"));
+			uint16_t outfitId = result->getNumber<uint16_t>("outfit_id");
+			uint8_t addons = result->getNumber<uint8_t>("addons");
+			hash += hashRow({outfitId, addons});
+			player->addOutfit(outfitId, addons);
 		} while (result->next());
+		hashes[PLAYER_SAVE_OUTFITS] = hash;
 	}
 
 	// load mounts
-	if ((result = db.storeQuery(
-	         fmt::format("SELECT `mount_id` FROM `player_mounts` WHERE `player_id` = {:d}", player->getGUID())))) {
+	if ((result = db.storeStatement("SELECT `mount_id` FROM `player_mounts` WHERE `player_id` = ?", player->getGUID()))) {
+		uint64_t hash = EMPTY_SECTION_HASH;
 		do {
-			player->tameMount(result->getNumber<uint16_t>("mount_id"));
+			uint16_t mountId = result->getNumber<uint16_t>("mount_id");
+			hash += hashRow({mountId});
+			player->tameMount(mountId);
 		} while (result->next());
+		hashes[PLAYER_SAVE_MOUNTS] = hash;
+	}
+
+	for (size_t section = 0; section < PLAYER_SAVE_LAST; ++section) {
+		player->saveState->captured[section] = hashes[section];
+		player->saveState->committed[section] = hashes[section];
 	}
 
 	player->updateBaseSpeed();
@@ -525,8 +776,8 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	return true;
 }
 
-bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert,
-                            PropWriteStream& propWriteStream)
+void IOLoginData::captureItems(const Player* player, const ItemBlockList& itemList, std::vector<PlayerItemRow>& rows,
+                               PropWriteStream& propWriteStream)
 {
 	using ContainerBlock = std::pair<Container*, int32_t>;
 	std::vector<ContainerBlock> containers;
@@ -535,7 +786,6 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 	int32_t runningId = 100;
 	const auto& openContainers = player->getOpenContainers();
 
-	Database& db = Database::getInstance();
 	for (const auto& it : itemList) {
 		int32_t pid = it.first;
 		Item* item = it.second;
@@ -564,11 +814,8 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 		propWriteStream.clear();
 		item->serializeAttr(propWriteStream);
 
-		if (!query_insert.addRow(fmt::format("{:d}, {:d}, {:d}, {:d}, {:d}, {:s}", player->getGUID(), pid, runningId,
-		                                     item->getID(), item->getSubType(),
-		                                     db.escapeString(propWriteStream.getStream())))) {
-			return false;
-		}
+		auto attributes = propWriteStream.getStream();
+		rows.push_back({pid, runningId, item->getID(), item->getSubType(), {attributes.data(), attributes.size()}});
 	}
 
 	for (size_t i = 0; i < containers.size(); i++) {
@@ -603,35 +850,48 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 			propWriteStream.clear();
 			item->serializeAttr(propWriteStream);
 
-			if (!query_insert.addRow(fmt::format("{:d}, {:d}, {:d}, {:d}, {:d}, {:s}", player->getGUID(), parentId,
-			                                     runningId, item->getID(), item->getSubType(),
-			                                     db.escapeString(propWriteStream.getStream())))) {
-				return false;
-			}
+			auto attributes = propWriteStream.getStream();
+			rows.push_back(
+			    {parentId, runningId, item->getID(), item->getSubType(), {attributes.data(), attributes.size()}});
 		}
 	}
-	return query_insert.execute();
 }
 
-bool IOLoginData::savePlayer(Player* player)
+std::shared_ptr<PlayerSnapshot> IOLoginData::capturePlayer(Player* player)
 {
 	if (player->isDead()) {
 		player->changeHealth(1);
 	}
 
-	Database& db = Database::getInstance();
-
-	DBResult_ptr result =
-	    db.storeQuery(fmt::format("SELECT `save` FROM `players` WHERE `id` = {:d}", player->getGUID()));
-	if (!result) {
-		return false;
-	}
-
-	if (result->getNumber<uint16_t>("save") == 0) {
-		return db.executeQuery(
-		    fmt::format("UPDATE `players` SET `lastlogin` = {:d}, `lastip` = INET6_ATON('{:s}') WHERE `id` = {:d}",
-		                player->lastLoginSaved, player->lastIP.to_string(), player->getGUID()));
-	}
+	if (!player->saveState) {
+		player->saveState = std::make_shared<PlayerSaveState>();
+	}
+
+	auto snapshot = std::make_shared<PlayerSnapshot>();
+	snapshot->saveState = player->saveState;
+	snapshot->guid = player->getGUID();
+	snapshot->name = player->getName();
+	snapshot->lastLoginSaved = player->lastLoginSaved;
+	snapshot->lastIP = player->lastIP;
+
+	snapshot->level = player->level;
+	snapshot->groupId = player->group->id;
+	snapshot->vocationId = player->getVocationId();
+	snapshot->health = player->health;
+	snapshot->healthMax = player->healthMax;
+	snapshot->experience = player->experience;
+	snapshot->outfit = player->defaultOutfit;
+	snapshot->currentMount = player->currentMount;
+	snapshot->randomizeMount = player->randomizeMount;
+	snapshot->magLevel = player->magLevel;
+	snapshot->mana = player->mana;
+	snapshot->manaMax = player->manaMax;
+	snapshot->manaSpent = player->manaSpent;
+	snapshot->soul = player->soul;
+	snapshot->townId = player->town->id;
+	snapshot->loginPosition = player->getLoginPosition();
+	snapshot->capacity = player->capacity;
+	snapshot->sex = player->sex;
 
 	// serialize conditions
 	PropWriteStream propWriteStream;
@@ -641,132 +901,45 @@ bool IOLoginData::savePlayer(Player* player)
 			propWriteStream.write<uint8_t>(CONDITIONATTR_END);
 		}
 	}
-
-	// First, an UPDATE query to write the player itself
-	std::ostringstream query;
-	query << "UPDATE `players` SET ";
-	query << "`level` = " << player->level << ',';
-	query << "`group_id` = " << player->group->id << ',';
-	query << "`vocation` = " << player->getVocationId() << ',';
-	query << "`health` = " << player->health << ',';
-	query << "`healthmax` = " << player->healthMax << ',';
-	query << "`experience` = " << player->experience << ',';
-	query << "`lookbody` = " << static_cast<uint32_t>(player->defaultOutfit.lookBody) << ',';
-	query << "`lookfeet` = " << static_cast<uint32_t>(player->defaultOutfit.lookFeet) << ',';
-	query << "`lookhead` = " << static_cast<uint32_t>(player->defaultOutfit.lookHead) << ',';
-	query << "`looklegs` = " << static_cast<uint32_t>(player->defaultOutfit.lookLegs) << ',';
-	query << "`looktype` = " << player->defaultOutfit.lookType << ',';
-	query << "`lookaddons` = " << static_cast<uint32_t>(player->defaultOutfit.lookAddons) << ',';
-	query << "`lookmount` = " << player->defaultOutfit.lookMount << ',';
-	query << "`lookmounthead` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountHead) << ',';
-	query << "`lookmountbody` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountBody) << ',';
-	query << "`lookmountlegs` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountLegs) << ',';
-	query << "`lookmountfeet` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountFeet) << ',';
-	query << "`currentmount` = " << static_cast<uint16_t>(player->currentMount) << ',';
-	query << "`randomizemount` = " << player->randomizeMount << ",";
-	query << "`maglevel` = " << player->magLevel << ',';
-	query << "`mana` = " << player->mana << ',';
-	query << "`manamax` = " << player->manaMax << ',';
-	query << "`manaspent` = " << player->manaSpent << ',';
-	query << "`soul` = " << static_cast<uint16_t>(player->soul) << ',';
-	query << "`town_id` = " << player->town->id << ',';
-
-	const Position& loginPosition = player->getLoginPosition();
-	query << "`posx` = " << loginPosition.getX() << ',';
-	query << "`posy` = " << loginPosition.getY() << ',';
-	query << "`posz` = " << loginPosition.getZ() << ',';
-
-	query << "`cap` = " << (player->capacity / 100) << ',';
-	query << "`sex` = " << static_cast<uint16_t>(player->sex) << ',';
-
-	if (player->lastLoginSaved != 0) {
-		query << "`lastlogin` = " << player->lastLoginSaved << ',';
-	}
-
-	if (!player->lastIP.is_unspecified()) {
-		query << "`lastip` = INET6_ATON('" << player->lastIP.to_string() << "'),";
-	}
-
-	query << "`conditions` = " << db.escapeString(propWriteStream.getStream()) << ',';
+	auto conditions = propWriteStream.getStream();
+	snapshot->conditions.assign(conditions.data(), conditions.size());
 
 	if (g_game.getWorldType() != WORLD_TYPE_PVP_ENFORCED) {
-		int64_t skullTime = 0;
-
+		snapshot->saveSkull = true;
 		if (player->skullTicks > 0) {
-			skullTime = time(nullptr) + player->skullTicks;
+			snapshot->skullTime = time(nullptr) + player->skullTicks;
 		}
-		query << "`skulltime` = " << skullTime << ',';
 
-		Skulls_t skull = SKULL_NONE;
-		if (player->skull == SKULL_RED) {
-			skull = SKULL_RED;
-		} else if (player->skull == SKULL_BLACK) {
-			skull = SKULL_BLACK;
+		if (player->skull == SKULL_RED || player->skull == SKULL_BLACK) {
+			snapshot->skull = player->skull;
 		}
-		query << "`skull` = " << static_cast<int64_t>(skull) << ',';
-	}
-
-	query << "`lastlogout` = " << player->getLastLogout() << ',';
-	query << "`balance` = " << player->bankBalance << ',';
-	query << "`offlinetraining_time` = " << player->getOfflineTrainingTime() / 1000 << ',';
-	query << "`offlinetraining_skill` = " << player->getOfflineTrainingSkill() << ',';
-	query << "`stamina` = " << player->getStaminaMinutes() << ',';
-
-	query << "`skill_fist` = " << player->skills[SKILL_FIST].level << ',';
-	query << "`skill_fist_tries` = " << player->skills[SKILL_FIST].tries << ',';
-	query << "`skill_club` = " << player->skills[SKILL_CLUB].level << ',';
-	query << "`skill_club_tries` = " << player->skills[SKILL_CLUB].tries << ',';
-	query << "`skill_sword` = " << player->skills[SKILL_SWORD].level << ',';
-	query << "`skill_sword_tries` = " << player->skills[SKILL_SWORD].tries << ',';
-	query << "`skill_axe` = " << player->skills[SKILL_AXE].level << ',';
-	query << "`skill_axe_tries` = " << player->skills[SKILL_AXE].tries << ',';
-	query << "`skill_dist` = " << player->skills[SKILL_DISTANCE].level << ',';
-	query << "`skill_dist_tries` = " << player->skills[SKILL_DISTANCE].tries << ',';
-	query << "`skill_shielding` = " << player->skills[SKILL_SHIELD].level << ',';
-	query << "`skill_shielding_tries` = " << player->skills[SKILL_SHIELD].tries << ',';
-	query << "`skill_fishing` = " << player->skills[SKILL_FISHING].level << ',';
-	query << "`skill_fishing_tries` = " << player->skills[SKILL_FISHING].tries << ',';
-	query << "`direction` = " << static_cast<uint16_t>(player->getDirection()) << ',';
-
-	if (!player->isOffline()) {
-		query << "`onlinetime` = `onlinetime` + " << (time(nullptr) - player->lastLoginSaved) << ',';
 	}
-	query << "`blessings` = " << player->blessings.to_ulong();
-	query << " WHERE `id` = " << player->getGUID();
 
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
+	snapshot->lastLogout = player->getLastLogout();
+	snapshot->bankBalance = player->bankBalance;
+	snapshot->offlineTrainingTime = player->getOfflineTrainingTime() / 1000;
+	snapshot->offlineTrainingSkill = player->getOfflineTrainingSkill();
+	snapshot->staminaMinutes = player->getStaminaMinutes();
+	for (uint8_t skill = SKILL_FIRST; skill <= SKILL_LAST; ++skill) {
+		snapshot->skills[skill] = {player->skills[skill].level, player->skills[skill].tries};
 	}
+	snapshot->direction = player->getDirection();
 
-	if (!db.executeQuery(query.str())) {
-		return false;
-	}
-
-	// learned spells
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_spells` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
+	if (!player->isOffline()) {
+		snapshot->onlineTime = time(nullptr) - player->lastLoginSaved;
 	}
+	snapshot->blessings = player->blessings.to_ulong();
 
-	DBInsert spellsQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ");
+	// sections are only copied when their rows changed since they were loaded or last written
+	uint64_t hash = EMPTY_SECTION_HASH;
 	for (const std::string& spellName : player->learnedInstantSpellList) {
-		if (!spellsQuery.addRow(fmt::format("{:d}, {:s}", player->getGUID(), db.escapeString(spellName)))) {
-			return false;
-		}
+		hash += hashRow({}, spellName);
 	}
-
-	if (!spellsQuery.execute()) {
-		return false;
+	if (snapshot->setHash(PLAYER_SAVE_SPELLS, hash)) {
+		snapshot->learnedSpells.assign(player->learnedInstantSpellList.begin(),
+		                               player->learnedInstantSpellList.end());
 	}
 
-	// item saving
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_items` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
-	}
-
-	DBInsert itemsQuery(
-	    "INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-
 	ItemBlockList itemList;
 	for (int32_t slotId = CONST_SLOT_FIRST; slotId <= CONST_SLOT_LAST; ++slotId) {
 		Item* item = player->inventory[slotId];
@@ -774,117 +947,264 @@ bool IOLoginData::savePlayer(Player* player)
 			itemList.emplace_back(slotId, item);
 		}
 	}
-
-	if (!saveItems(player, itemList, itemsQuery, propWriteStream)) {
-		return false;
-	}
-
-	// save depot items
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_depotitems` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
+	captureItems(player, itemList, snapshot->items, propWriteStream);
+	if (!snapshot->setHash(PLAYER_SAVE_ITEMS, hashItemRows(snapshot->items))) {
+		snapshot->items.clear();
 	}
 
-	DBInsert depotQuery(
-	    "INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
 	itemList.clear();
-
 	for (const auto& it : player->depotChests) {
 		for (Item* item : it.second->getItemList()) {
 			itemList.emplace_back(it.first, item);
 		}
 	}
-
-	if (!saveItems(player, itemList, depotQuery, propWriteStream)) {
-		return false;
+	captureItems(player, itemList, snapshot->depotItems, propWriteStream);
+	if (!snapshot->setHash(PLAYER_SAVE_DEPOT_ITEMS, hashItemRows(snapshot->depotItems))) {
+		snapshot->depotItems.clear();
 	}
 
-	// save inbox items
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_inboxitems` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
+	itemList.clear();
+	for (Item* item : player->getInbox()->getItemList()) {
+		itemList.emplace_back(0, item);
+	}
+	captureItems(player, itemList, snapshot->inboxItems, propWriteStream);
+	if (!snapshot->setHash(PLAYER_SAVE_INBOX_ITEMS, hashItemRows(snapshot->inboxItems))) {
+		snapshot->inboxItems.clear();
 	}
 
-	DBInsert inboxQuery(
-	    "INSERT INTO `player_inboxitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
 	itemList.clear();
-
-	for (Item* item : player->getInbox()->getItemList()) {
+	for (Item* item : player->getStoreInbox()->getItemList()) {
 		itemList.emplace_back(0, item);
 	}
+	captureItems(player, itemList, snapshot->storeInboxItems, propWriteStream);
+	if (!snapshot->setHash(PLAYER_SAVE_STORE_INBOX_ITEMS, hashItemRows(snapshot->storeInboxItems))) {
+		snapshot->storeInboxItems.clear();
+	}
 
-	if (!saveItems(player, itemList, inboxQuery, propWriteStream)) {
-		return false;
+	hash = EMPTY_SECTION_HASH;
+	for (const auto& [key, value] : player->getStorageMap()) {
+		hash += hashRow({key, static_cast<uint32_t>(value)});
+	}
+	if (snapshot->setHash(PLAYER_SAVE_STORAGE, hash)) {
+		snapshot->storage = player->getStorageMap();
 	}
 
-	// save store inbox items
-	if (!db.executeQuery(
-	        fmt::format("DELETE FROM `player_storeinboxitems` WHERE `player_id` = {:d}", player->getGUID()))) {
+	hash = EMPTY_SECTION_HASH;
+	for (const auto& [outfitId, addons] : player->outfits) {
+		hash += hashRow({outfitId, addons});
+	}
+	if (snapshot->setHash(PLAYER_SAVE_OUTFITS, hash)) {
+		snapshot->outfits = player->outfits;
+	}
+
+	hash = EMPTY_SECTION_HASH;
+	for (uint16_t mountId : player->mounts) {
+		hash += hashRow({mountId});
+	}
+	if (snapshot->setHash(PLAYER_SAVE_MOUNTS, hash)) {
+		snapshot->mounts.assign(player->mounts.begin(), player->mounts.end());
+	}
+	return snapshot;
+}
+
+bool IOLoginData::saveSnapshot(Database& db, const PlayerSnapshot& snapshot)
+{
+	DBResult_ptr result = db.storeStatement("SELECT `save` FROM `players` WHERE `id` = ?", snapshot.guid);
+	if (!result) {
 		return false;
 	}
 
-	DBInsert storeInboxQuery(
-	    "INSERT INTO `player_storeinboxitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-	itemList.clear();
+	if (result->getNumber<uint16_t>("save") == 0) {
+		return db.executeStatement("UPDATE `players` SET `lastlogin` = ?, `lastip` = INET6_ATON(?) WHERE `id` = ?",
+		                           snapshot.lastLoginSaved, snapshot.lastIP.to_string(), snapshot.guid);
+	}
 
-	for (Item* item : player->getStoreInbox()->getItemList()) {
-		itemList.emplace_back(0, item);
+	// values left out of the save are bound as NULL and keep what the row has
+	std::optional<time_t> lastLogin;
+	if (snapshot.lastLoginSaved != 0) {
+		lastLogin = snapshot.lastLoginSaved;
+	}
+
+	std::optional<std::string> lastIP;
+	if (!snapshot.lastIP.is_unspecified()) {
+		lastIP = snapshot.lastIP.to_string();
+	}
+
+	std::optional<int64_t> skullTime;
+	std::optional<Skulls_t> skull;
+	if (snapshot.saveSkull) {
+		skullTime = snapshot.skullTime;
+		skull = snapshot.skull;
 	}
 
-	if (!saveItems(player, itemList, storeInboxQuery, propWriteStream)) {
+	const Outfit_t& outfit = snapshot.outfit;
+	const auto& skills = snapshot.skills;
+
+	DBTransaction transaction(db);
+	if (!transaction.begin()) {
 		return false;
 	}
 
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_storage` WHERE `player_id` = {:d}", player->getGUID()))) {
+	// First, an UPDATE query to write the player itself
+	if (!db.executeStatement(
+	        "UPDATE `players` SET `level` = ?, `group_id` = ?, `vocation` = ?, `health` = ?, `healthmax` = ?, `experience` = ?, `lookbody` = ?, `lookfeet` = ?, `lookhead` = ?, `looklegs` = ?, `looktype` = ?, `lookaddons` = ?, `lookmount` = ?, `lookmounthead` = ?, `lookmountbody` = ?, `lookmountlegs` = ?, `lookmountfeet` = ?, `currentmount` = ?, `randomizemount` = ?, `maglevel` = ?, `mana` = ?, `manamax` = ?, `manaspent` = ?, `soul` = ?, `town_id` = ?, `posx` = ?, `posy` = ?, `posz` = ?, `cap` = ?, `sex` = ?, `lastlogin` = COALESCE(?, `lastlogin`), `lastip` = COALESCE(INET6_ATON(?), `lastip`), `conditions` = ?, `skulltime` = COALESCE(?, `skulltime`), `skull` = COALESCE(?, `skull`), `lastlogout` = ?, `balance` = ?, `offlinetraining_time` = ?, `offlinetraining_skill` = ?, `stamina` = ?, `skill_fist` = ?, `skill_fist_tries` = ?, `skill_club` = ?, `skill_club_tries` = ?, `skill_sword` = ?, `skill_sword_tries` = ?, `skill_axe` = ?, `skill_axe_tries` = ?, `skill_dist` = ?, `skill_dist_tries` = ?, `skill_shielding` = ?, `skill_shielding_tries` = ?, `skill_fishing` = ?, `skill_fishing_tries` = ?, `direction` = ?, `onlinetime` = `onlinetime` + ?, `blessings` = ? WHERE `id` = ?",
+	        snapshot.level, snapshot.groupId, snapshot.vocationId, snapshot.health, snapshot.healthMax,
+	        snapshot.experience, outfit.lookBody, outfit.lookFeet, outfit.lookHead, outfit.lookLegs, outfit.lookType,
+	        outfit.lookAddons, outfit.lookMount, outfit.lookMountHead, outfit.lookMountBody, outfit.lookMountLegs,
+	        outfit.lookMountFeet, snapshot.currentMount, snapshot.randomizeMount, snapshot.magLevel, snapshot.mana,
+	        snapshot.manaMax, snapshot.manaSpent, snapshot.soul, snapshot.townId, snapshot.loginPosition.getX(),
+	        snapshot.loginPosition.getY(), snapshot.loginPosition.getZ(), snapshot.capacity / 100, snapshot.sex,
+	        lastLogin, lastIP, snapshot.conditions, skullTime, skull, snapshot.lastLogout, snapshot.bankBalance,
+	        snapshot.offlineTrainingTime, snapshot.offlineTrainingSkill, snapshot.staminaMinutes,
+	        skills[SKILL_FIST].first, skills[SKILL_FIST].second, skills[SKILL_CLUB].first, skills[SKILL_CLUB].second,
+	        skills[SKILL_SWORD].first, skills[SKILL_SWORD].second, skills[SKILL_AXE].first, skills[SKILL_AXE].second,
+	        skills[SKILL_DISTANCE].first, skills[SKILL_DISTANCE].second, skills[SKILL_SHIELD].first,
+	        skills[SKILL_SHIELD].second, skills[SKILL_FISHING].first, skills[SKILL_FISHING].second, snapshot.direction,
+	        snapshot.onlineTime, snapshot.blessings, snapshot.guid)) {
 		return false;
 	}
 
-	DBInsert storageQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
+	// learned spells
+	if (snapshot.changed[PLAYER_SAVE_SPELLS]) {
+		if (!db.executeStatement("DELETE FROM `player_spells` WHERE `player_id` = ?", snapshot.guid)) {
+			return false;
+		}
+
+		DBInsert spellsQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ", db);
+		for (const std::string& spellName : snapshot.learnedSpells) {
+			if (!spellsQuery.addRow(fmt::format("{:d}, {:s}", snapshot.guid, db.escapeString(spellName)))) {
+				return false;
+			}
+		}
 
-	for (const auto& [key, value] : player->getStorageMap()) {
-		if (!storageQuery.addRow(fmt::format("{:d}, {:d}, {:d}", player->getGUID(), key, value))) {
+		if (!spellsQuery.execute()) {
 			return false;
 		}
 	}
 
-	if (!storageQuery.execute()) {
+	// item saving
+	if (snapshot.changed[PLAYER_SAVE_ITEMS] && !saveItemRows(db, snapshot.guid, "player_items", snapshot.items)) {
 		return false;
 	}
 
-	// save outfits & addons
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_outfits` WHERE `player_id` = {:d}", player->getGUID()))) {
+	if (snapshot.changed[PLAYER_SAVE_DEPOT_ITEMS] &&
+	    !saveItemRows(db, snapshot.guid, "player_depotitems", snapshot.depotItems)) {
 		return false;
 	}
 
-	DBInsert outfitQuery("INSERT INTO `player_outfits` (`player_id`, `outfit_id`, `addons`) VALUES ");
+	if (snapshot.changed[PLAYER_SAVE_INBOX_ITEMS] &&
+	    !saveItemRows(db, snapshot.guid, "player_inboxitems", snapshot.inboxItems)) {
+		return false;
+	}
+
+	if (snapshot.changed[PLAYER_SAVE_STORE_INBOX_ITEMS] &&
+	    !saveItemRows(db, snapshot.guid, "player_storeinboxitems", snapshot.storeInboxItems)) {
+		return false;
+	}
 
-	for (const auto& it : player->outfits) {
-		if (!outfitQuery.addRow(fmt::format("{:d}, {:d}, {:d}", player->getGUID(), it.first, it.second))) {
+	if (snapshot.changed[PLAYER_SAVE_STORAGE]) {
+		if (!db.executeStatement("DELETE FROM `player_storage` WHERE `player_id` = ?", snapshot.guid)) {
+			return false;
+		}
+
+		DBInsert storageQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ", db);
+
+		for (const auto& [key, value] : snapshot.storage) {
+			if (!storageQuery.addRow(fmt::format("{:d}, {:d}, {:d}", snapshot.guid, key, value))) {
+				return false;
+			}
+		}
+
+		if (!storageQuery.execute()) {
 			return false;
 		}
 	}
 
-	if (!outfitQuery.execute()) {
-		return false;
+	// save outfits & addons
+	if (snapshot.changed[PLAYER_SAVE_OUTFITS]) {
+		if (!db.executeStatement("DELETE FROM `player_outfits` WHERE `player_id` = ?", snapshot.guid)) {
+			return false;
+		}
+
+		DBInsert outfitQuery("INSERT INTO `player_outfits` (`player_id`, `outfit_id`, `addons`) VALUES ", db);
+
+		for (const auto& it : snapshot.outfits) {
+			if (!outfitQuery.addRow(fmt::format("{:d}, {:d}, {:d}", snapshot.guid, it.first, it.second))) {
+				return false;
+			}
+		}
+
+		if (!outfitQuery.execute()) {
+			return false;
+		}
 	}
 
 	// save mounts
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_mounts` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
-	}
+	if (snapshot.changed[PLAYER_SAVE_MOUNTS]) {
+		if (!db.executeStatement("DELETE FROM `player_mounts` WHERE `player_id` = ?", snapshot.guid)) {
+			return false;
+		}
 
-	DBInsert mountQuery("INSERT INTO `player_mounts` (`player_id`, `mount_id`) VALUES ");
+		DBInsert mountQuery("INSERT INTO `player_mounts` (`player_id`, `mount_id`) VALUES ", db);
+
+		for (uint16_t mountId : snapshot.mounts) {
+			if (!mountQuery.addRow(fmt::format("{:d}, {:d}", snapshot.guid, mountId))) {
+				return false;
+			}
+		}
 
-	for (const auto& it : player->mounts) {
-		if (!mountQuery.addRow(fmt::format("{:d}, {:d}", player->getGUID(), it))) {
+		if (!mountQuery.execute()) {
 			return false;
 		}
 	}
 
-	if (!mountQuery.execute()) {
+	// End the transaction
+	if (!transaction.commit()) {
 		return false;
 	}
 
-	// End the transaction
-	return transaction.commit();
+	// the sections written are what the database holds from now on
+	for (size_t section = 0; section < PLAYER_SAVE_LAST; ++section) {
+		if (snapshot.changed[section]) {
+			snapshot.saveState->committed[section].store(snapshot.hashes[section], std::memory_order_relaxed);
+		}
+	}
+	return true;
+}
+
+bool IOLoginData::savePlayer(Player* player)
+{
+	auto snapshot = capturePlayer(player);
+
+	// an asynchronous save of the same player must not overwrite this one
+	waitForPendingSave(snapshot->guid);
+	return saveSnapshot(Database::getInstance(), *snapshot);
+}
+
+void IOLoginData::savePlayerAsync(Player* player)
+{
+	auto snapshot = capturePlayer(player);
+
+	beginPendingSave(snapshot->guid);
+	bool queued = g_databaseTasks.addJob(snapshot->guid, [snapshot](Database& db) {
+		bool saved = false;
+		for (int tries = 0; tries < 3 && !saved; ++tries) {
+			saved = saveSnapshot(db, *snapshot);
+		}
+
+		if (!saved) {
+			std::cout << "Error while saving player: " << snapshot->name << std::endl;
+		}
+		endPendingSave(snapshot->guid);
+	});
+
+	if (!queued) {
+		endPendingSave(snapshot->guid);
+		waitForPendingSave(snapshot->guid);
+		if (!saveSnapshot(Database::getInstance(), *snapshot)) {
+			std::cout << "Error while saving player: " << snapshot->name << std::endl;
+		}
+	}
 }
 
 std::string IOLoginData::getNameByGuid(uint32_t guid)
@@ -950,15 +1270,24 @@ bool IOLoginData::formatPlayerName(std::string& name)
 	return true;
 }
 
-void IOLoginData::loadItems(ItemMap& itemMap, DBResult_ptr result)
+uint64_t IOLoginData::loadItems(ItemMap& itemMap, DBResult_ptr result)
 {
+	const size_t sidColumn = result->getColumnIndex("sid");
+	const size_t pidColumn = result->getColumnIndex("pid");
+	const size_t typeColumn = result->getColumnIndex("itemtype");
+	const size_t countColumn = result->getColumnIndex("count");
+	const size_t attributesColumn = result->getColumnIndex("attributes");
+
+	uint64_t hash = EMPTY_SECTION_HASH;
 	do {
-		uint32_t sid = result->getNumber<uint32_t>("sid");
-		uint32_t pid = result->getNumber<uint32_t>("pid");
-		uint16_t type = result->getNumber<uint16_t>("itemtype");
-		uint16_t count = result->getNumber<uint16_t>("count");
+		uint32_t sid = result->getNumber<uint32_t>(sidColumn);
+		uint32_t pid = result->getNumber<uint32_t>(pidColumn);
+		uint16_t type = result->getNumber<uint16_t>(typeColumn);
+		uint16_t count = result->getNumber<uint16_t>(countColumn);
+
+		auto attr = result->getString(attributesColumn);
+		hash += hashRow({pid, sid, type, count}, attr);
 
-		auto attr = result->getString("attributes");
 		PropStream propStream;
 		propStream.init(attr.data(), attr.size());
 
@@ -972,12 +1301,25 @@ void IOLoginData::loadItems(ItemMap& itemMap, DBResult_ptr result)
 			itemMap[sid] = pair;
 		}
 	} while (result->next());
+	return hash;
 }
 
 void IOLoginData::increaseBankBalance(uint32_t guid, uint64_t bankBalance)
 {
-	Database::getInstance().executeQuery(
-	    fmt::format("UPDATE `players` SET `balance` = `balance` + {:d} WHERE `id` = {:d}", bankBalance, guid));
+	auto query = fmt::format("UPDATE `players` SET `balance` = `balance` + {:d} WHERE `id` = {:d}", bankBalance, guid);
+
+	// queued behind the saves of the player, which write the balance too, and counted as one so loads wait for it
+	beginPendingSave(guid);
+	bool queued = g_databaseTasks.addJob(guid, [guid, query](Database& db) {
+		db.executeQuery(query);
+		endPendingSave(guid);
+	});
+
+	if (!queued) {
+		endPendingSave(guid);
+		waitForPendingSave(guid);
+		Database::getInstance().executeQuery(query);
+	}
 }
 
 bool IOLoginData::hasBiddedOnHouse(uint32_t guid)
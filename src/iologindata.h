@@ -6,10 +6,13 @@
 
 #include "database.h"
 #include "enums.h"
+#include "tasks.h"
 
 class Item;
 class Player;
 class PropWriteStream;
+struct PlayerItemRow;
+struct PlayerSnapshot;
 struct VIPEntry;
 
 using ItemBlockList = std::list<std::pair<int32_t, Item*>>;
@@ -23,12 +26,24 @@ public:
 	static AccountType_t getAccountType(uint32_t accountId);
 	static void setAccountType(uint32_t accountId, AccountType_t accountType);
 	static void updateOnlineStatus(uint32_t guid, bool login);
+
+	/**
+	 * Adds f to the dispatcher once the pending saves of the player are written and returns true, or returns false
+	 * right away when there are none.
+	 */
+	static bool runAfterPendingSave(uint32_t guid, TaskFunc&& f);
 	static bool preloadPlayer(Player* player);
 
 	static bool loadPlayerById(Player* player, uint32_t id);
 	static bool loadPlayerByName(Player* player, const std::string& name);
 	static bool loadPlayer(Player* player, DBResult_ptr result);
 	static bool savePlayer(Player* player);
+
+	/**
+	 * Copies the persistent state of the player and writes it on the database thread. Loading the same player waits
+	 * until the write is done, logging in is deferred with runAfterPendingSave.
+	 */
+	static void savePlayerAsync(Player* player);
 	static uint32_t getGuidByName(const std::string& name);
 	static bool getGuidByNameEx(uint32_t& guid, bool& specialVip, std::string& name);
 	static std::string getNameByGuid(uint32_t guid);
@@ -48,9 +63,12 @@ public:
 private:
 	using ItemMap = std::map<uint32_t, std::pair<Item*, uint32_t>>;
 
-	static void loadItems(ItemMap& itemMap, DBResult_ptr result);
-	static bool saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert,
-	                      PropWriteStream& propWriteStream);
+	static uint64_t loadItems(ItemMap& itemMap, DBResult_ptr result);
+	static void captureItems(const Player* player, const ItemBlockList& itemList, std::vector<PlayerItemRow>& rows,
+	                         PropWriteStream& propWriteStream);
+
+	static std::shared_ptr<PlayerSnapshot> capturePlayer(Player* player);
+	static bool saveSnapshot(Database& db, const PlayerSnapshot& snapshot);
 };
 
 #endif // FS_IOLOGINDATA_H
@@ -6,11 +6,85 @@
 #include "iomapserialize.h"
 
 #include "bed.h"
+#include "databasetasks.h"
 #include "game.h"
 #include "housetile.h"
 
 extern Game g_game;
 
+namespace {
+
+struct HouseSnapshot
+{
+	uint32_t id;
+	uint32_t owner;
+	time_t paidUntil;
+	uint32_t payRentWarnings;
+	std::string name;
+	uint32_t townId;
+	uint32_t rent;
+	size_t size;
+	uint32_t beds;
+
+	std::vector<std::pair<uint32_t, std::string>> lists;
+	std::vector<std::string> tiles;
+};
+
+bool writeHouse(Database& db, const HouseSnapshot& house)
+{
+	DBTransaction transaction(db);
+	if (!transaction.begin()) {
+		return false;
+	}
+
+	DBResult_ptr result = db.storeQuery(fmt::format("SELECT `id` FROM `houses` WHERE `id` = {:d}", house.id));
+	if (result) {
+		db.executeQuery(fmt::format(
+		    "UPDATE `houses` SET `owner` = {:d}, `paid` = {:d}, `warnings` = {:d}, `name` = {:s}, `town_id` = {:d}, `rent` = {:d}, `size` = {:d}, `beds` = {:d} WHERE `id` = {:d}",
+		    house.owner, house.paidUntil, house.payRentWarnings, db.escapeString(house.name), house.townId, house.rent,
+		    house.size, house.beds, house.id));
+	} else {
+		db.executeQuery(fmt::format(
+		    "INSERT INTO `houses` (`id`, `owner`, `paid`, `warnings`, `name`, `town_id`, `rent`, `size`, `beds`) VALUES ({:d}, {:d}, {:d}, {:d}, {:s}, {:d}, {:d}, {:d}, {:d})",
+		    house.id, house.owner, house.paidUntil, house.payRentWarnings, db.escapeString(house.name), house.townId,
+		    house.rent, house.size, house.beds));
+	}
+
+	if (!db.executeQuery(fmt::format("DELETE FROM `house_lists` WHERE `house_id` = {:d}", house.id))) {
+		return false;
+	}
+
+	DBInsert listsQuery("INSERT INTO `house_lists` (`house_id` , `listid` , `list`) VALUES ", db);
+	for (const auto& [listId, listText] : house.lists) {
+		if (!listsQuery.addRow(fmt::format("{:d}, {:d}, {:s}", house.id, listId, db.escapeString(listText)))) {
+			return false;
+		}
+	}
+
+	if (!listsQuery.execute()) {
+		return false;
+	}
+
+	if (!db.executeQuery(fmt::format("DELETE FROM `tile_store` WHERE `house_id` = {:d}", house.id))) {
+		return false;
+	}
+
+	DBInsert tilesQuery("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ", db);
+	for (const std::string& tile : house.tiles) {
+		if (!tilesQuery.addRow(fmt::format("{:d}, {:s}", house.id, db.escapeString(tile)))) {
+			return false;
+		}
+	}
+
+	if (!tilesQuery.execute()) {
+		return false;
+	}
+
+	return transaction.commit();
+}
+
+} // namespace
+
 void IOMapSerialize::loadHouseItems(Map* map)
 {
 	int64_t start = OTSYS_TIME();
@@ -48,50 +122,6 @@ void IOMapSerialize::loadHouseItems(Map* map)
 	std::cout << "> Loaded house items in: " << (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
 }
 
-bool IOMapSerialize::saveHouseItems()
-{
-	int64_t start = OTSYS_TIME();
-	Database& db = Database::getInstance();
-
-	// Start the transaction
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
-	}
-
-	// clear old tile data
-	if (!db.executeQuery("DELETE FROM `tile_store`")) {
-		return false;
-	}
-
-	DBInsert stmt("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ");
-
-	PropWriteStream stream;
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		// save house items
-		House* house = it.second;
-		for (HouseTile* tile : house->getTiles()) {
-			saveTile(stream, tile);
-
-			if (auto attributes = stream.getStream(); !attributes.empty()) {
-				if (!stmt.addRow(fmt::format("{:d}, {:s}", house->getId(), db.escapeString(attributes)))) {
-					return false;
-				}
-				stream.clear();
-			}
-		}
-	}
-
-	if (!stmt.execute()) {
-		return false;
-	}
-
-	// End the transaction
-	bool success = transaction.commit();
-	std::cout << "> Saved house items in: " << (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
-	return success;
-}
-
 bool IOMapSerialize::loadContainer(PropStream& propStream, Container* container)
 {
 	while (container->serializationCount > 0) {
@@ -280,78 +310,56 @@ bool IOMapSerialize::loadHouseInfo()
 	return true;
 }
 
-bool IOMapSerialize::saveHouseInfo()
+void IOMapSerialize::saveHouseAsync(House* house)
 {
-	Database& db = Database::getInstance();
-
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
+	auto snapshot = std::make_shared<HouseSnapshot>();
+	snapshot->id = house->getId();
+	snapshot->owner = house->getOwner();
+	snapshot->paidUntil = house->getPaidUntil();
+	snapshot->payRentWarnings = house->getPayRentWarnings();
+	snapshot->name = house->getName();
+	snapshot->townId = house->getTownId();
+	snapshot->rent = house->getRent();
+	snapshot->size = house->getTiles().size();
+	snapshot->beds = house->getBedCount();
+
+	std::string listText;
+	if (house->getAccessList(GUEST_LIST, listText) && !listText.empty()) {
+		snapshot->lists.emplace_back(std::to_underlying(GUEST_LIST), std::move(listText));
+		listText.clear();
 	}
 
-	if (!db.executeQuery("DELETE FROM `house_lists`")) {
-		return false;
+	if (house->getAccessList(SUBOWNER_LIST, listText) && !listText.empty()) {
+		snapshot->lists.emplace_back(std::to_underlying(SUBOWNER_LIST), std::move(listText));
+		listText.clear();
 	}
 
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		House* house = it.second;
-		DBResult_ptr result = db.storeQuery(fmt::format("SELECT `id` FROM `houses` WHERE `id` = {:d}", house->getId()));
-		if (result) {
-			db.executeQuery(fmt::format(
-			    "UPDATE `houses` SET `owner` = {:d}, `paid` = {:d}, `warnings` = {:d}, `name` = {:s}, `town_id` = {:d}, `rent` = {:d}, `size` = {:d}, `beds` = {:d} WHERE `id` = {:d}",
-			    house->getOwner(), house->getPaidUntil(), house->getPayRentWarnings(),
-			    db.escapeString(house->getName()), house->getTownId(), house->getRent(), house->getTiles().size(),
-			    house->getBedCount(), house->getId()));
-		} else {
-			db.executeQuery(fmt::format(
-			    "INSERT INTO `houses` (`id`, `owner`, `paid`, `warnings`, `name`, `town_id`, `rent`, `size`, `beds`) VALUES ({:d}, {:d}, {:d}, {:d}, {:s}, {:d}, {:d}, {:d}, {:d})",
-			    house->getId(), house->getOwner(), house->getPaidUntil(), house->getPayRentWarnings(),
-			    db.escapeString(house->getName()), house->getTownId(), house->getRent(), house->getTiles().size(),
-			    house->getBedCount()));
-		}
-	}
-
-	DBInsert stmt("INSERT INTO `house_lists` (`house_id` , `listid` , `list`) VALUES ");
-
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		House* house = it.second;
-
-		std::string listText;
-		if (house->getAccessList(GUEST_LIST, listText) && !listText.empty()) {
-			if (!stmt.addRow(fmt::format("{:d}, {:d}, {:s}", house->getId(), std::to_underlying(GUEST_LIST),
-			                             db.escapeString(listText)))) {
-				return false;
-			}
-
+	for (Door* door : house->getDoors()) {
+		if (door->getAccessList(listText) && !listText.empty()) {
+			snapshot->lists.emplace_back(door->getDoorId(), std::move(listText));
 			listText.clear();
 		}
+	}
 
-		if (house->getAccessList(SUBOWNER_LIST, listText) && !listText.empty()) {
-			if (!stmt.addRow(fmt::format("{:d}, {:d}, {:s}", house->getId(), std::to_underlying(SUBOWNER_LIST),
-			                             db.escapeString(listText)))) {
-				return false;
-			}
+	PropWriteStream stream;
+	for (HouseTile* tile : house->getTiles()) {
+		saveTile(stream, tile);
 
-			listText.clear();
+		if (auto attributes = stream.getStream(); !attributes.empty()) {
+			snapshot->tiles.emplace_back(attributes.data(), attributes.size());
+			stream.clear();
 		}
+	}
 
-		for (Door* door : house->getDoors()) {
-			if (door->getAccessList(listText) && !listText.empty()) {
-				if (!stmt.addRow(fmt::format("{:d}, {:d}, {:s}", house->getId(), door->getDoorId(),
-				                             db.escapeString(listText)))) {
-					return false;
-				}
-
-				listText.clear();
-			}
+	bool queued = g_databaseTasks.addJob(snapshot->id, [snapshot](Database& db) {
+		if (!writeHouse(db, *snapshot)) {
+			std::cout << "[Error - IOMapSerialize::saveHouseAsync] Failed to save house " << snapshot->id << std::endl;
 		}
-	}
+	});
 
-	if (!stmt.execute()) {
-		return false;
+	if (!queued && !writeHouse(Database::getInstance(), *snapshot)) {
+		std::cout << "[Error - IOMapSerialize::saveHouseAsync] Failed to save house " << snapshot->id << std::endl;
 	}
-
-	return transaction.commit();
 }
 
 bool IOMapSerialize::saveHouse(House* house)
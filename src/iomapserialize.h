@@ -17,12 +17,15 @@ class IOMapSerialize
 {
 public:
 	static void loadHouseItems(Map* map);
-	static bool saveHouseItems();
 	static bool loadHouseInfo();
-	static bool saveHouseInfo();
 
 	static bool saveHouse(House* house);
 
+	/**
+	 * Copies the items, access lists and rent state of the house and writes them on the database thread.
+	 */
+	static void saveHouseAsync(House* house);
+
 private:
 	static void saveItem(PropWriteStream& stream, const Item* item);
 	static void saveTile(PropWriteStream& stream, const Tile* tile);
@@ -27,24 +27,32 @@ MarketOfferList getActiveOffers(MarketAction_t action, uint16_t itemId)
 {
 	MarketOfferList offerList;
 
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `id`, `amount`, `price`, `created`, `anonymous`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` FROM `market_offers` WHERE `sale` = {:d} AND `itemtype` = {:d}",
-	    std::to_underlying(action), itemId));
+	DBResult_ptr result = Database::getInstance().storeStatement(
+	    "SELECT `id`, `amount`, `price`, `created`, `anonymous`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` FROM `market_offers` WHERE `sale` = ? AND `itemtype` = ?",
+	    action, itemId);
 	if (!result) {
 		return offerList;
 	}
 
 	const int32_t marketOfferDuration = getNumber(ConfigManager::MARKET_OFFER_DURATION);
 
+	// popular items have thousands of offers
+	const size_t idColumn = result->getColumnIndex("id");
+	const size_t amountColumn = result->getColumnIndex("amount");
+	const size_t priceColumn = result->getColumnIndex("price");
+	const size_t createdColumn = result->getColumnIndex("created");
+	const size_t anonymousColumn = result->getColumnIndex("anonymous");
+	const size_t playerNameColumn = result->getColumnIndex("player_name");
+
 	do {
 		MarketOffer offer;
-		offer.amount = result->getNumber<uint16_t>("amount");
-		offer.price = result->getNumber<uint64_t>("price");
-		offer.timestamp = result->getNumber<uint32_t>("created") + marketOfferDuration;
-		offer.counter = result->getNumber<uint32_t>("id") & 0xFFFF;
+		offer.amount = result->getNumber<uint16_t>(amountColumn);
+		offer.price = result->getNumber<uint64_t>(priceColumn);
+		offer.timestamp = result->getNumber<uint32_t>(createdColumn) + marketOfferDuration;
+		offer.counter = result->getNumber<uint32_t>(idColumn) & 0xFFFF;
 		offer.itemId = itemId;
-		if (result->getNumber<uint16_t>("anonymous") == 0) {
-			offer.playerName = result->getString("player_name");
+		if (result->getNumber<uint16_t>(anonymousColumn) == 0) {
+			offer.playerName = result->getString(playerNameColumn);
 		} else {
 			offer.playerName = "Anonymous";
 		}
@@ -59,9 +67,9 @@ MarketOfferList getOwnOffers(MarketAction_t action, uint32_t playerId)
 
 	const int32_t marketOfferDuration = getNumber(ConfigManager::MARKET_OFFER_DURATION);
 
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `id`, `amount`, `price`, `created`, `itemtype` FROM `market_offers` WHERE `player_id` = {:d} AND `sale` = {:d}",
-	    playerId, std::to_underlying(action)));
+	DBResult_ptr result = Database::getInstance().storeStatement(
+	    "SELECT `id`, `amount`, `price`, `created`, `itemtype` FROM `market_offers` WHERE `player_id` = ? AND `sale` = ?",
+	    playerId, action);
 	if (!result) {
 		return offerList;
 	}
@@ -82,9 +90,9 @@ HistoryMarketOfferList getOwnHistory(MarketAction_t action, uint32_t playerId)
 {
 	HistoryMarketOfferList offerList;
 
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `itemtype`, `amount`, `price`, `expires_at`, `state` FROM `market_history` WHERE `player_id` = {:d} AND `sale` = {:d}",
-	    playerId, std::to_underlying(action)));
+	DBResult_ptr result = Database::getInstance().storeStatement(
+	    "SELECT `itemtype`, `amount`, `price`, `expires_at`, `state` FROM `market_history` WHERE `player_id` = ? AND `sale` = ?",
+	    playerId, action);
 	if (!result) {
 		return offerList;
 	}
@@ -204,8 +212,8 @@ void checkExpiredOffers()
 
 uint32_t getPlayerOfferCount(uint32_t playerId)
 {
-	DBResult_ptr result = Database::getInstance().storeQuery(
-	    fmt::format("SELECT COUNT(*) AS `count` FROM `market_offers` WHERE `player_id` = {:d}", playerId));
+	DBResult_ptr result = Database::getInstance().storeStatement(
+	    "SELECT COUNT(*) AS `count` FROM `market_offers` WHERE `player_id` = ?", playerId);
 	if (!result) {
 		return 0;
 	}
@@ -218,9 +226,9 @@ MarketOfferEx getOfferByCounter(uint32_t timestamp, uint16_t counter)
 
 	const int32_t created = timestamp - getNumber(ConfigManager::MARKET_OFFER_DURATION);
 
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `id`, `sale`, `itemtype`, `amount`, `created`, `price`, `player_id`, `anonymous`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` FROM `market_offers` WHERE `created` = {:d} AND (`id` & 65535) = {:d} LIMIT 1",
-	    created, counter));
+	DBResult_ptr result = Database::getInstance().storeStatement(
+	    "SELECT `id`, `sale`, `itemtype`, `amount`, `created`, `price`, `player_id`, `anonymous`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` FROM `market_offers` WHERE `created` = ? AND (`id` & 65535) = ? LIMIT 1",
+	    created, counter);
 	if (!result) {
 		offer.id = 0;
 		offer.playerId = 0;
@@ -246,29 +254,30 @@ MarketOfferEx getOfferByCounter(uint32_t timestamp, uint16_t counter)
 void createOffer(uint32_t playerId, MarketAction_t action, uint32_t itemId, uint16_t amount, uint64_t price,
                  bool anonymous)
 {
-	Database::getInstance().executeQuery(fmt::format(
-	    "INSERT INTO `market_offers` (`player_id`, `sale`, `itemtype`, `amount`, `price`, `created`, `anonymous`) VALUES ({:d}, {:d}, {:d}, {:d}, {:d}, {:d}, {:d})",
-	    playerId, std::to_underlying(action), itemId, amount, price, time(nullptr), anonymous));
+	Database::getInstance().executeStatement(
+	    "INSERT INTO `market_offers` (`player_id`, `sale`, `itemtype`, `amount`, `price`, `created`, `anonymous`) VALUES (?, ?, ?, ?, ?, ?, ?)",
+	    playerId, action, itemId, amount, price, time(nullptr), anonymous);
 }
 
 void acceptOffer(uint32_t offerId, uint16_t amount)
 {
-	Database::getInstance().executeQuery(
-	    fmt::format("UPDATE `market_offers` SET `amount` = `amount` - {:d} WHERE `id` = {:d}", amount, offerId));
+	Database::getInstance().executeStatement("UPDATE `market_offers` SET `amount` = `amount` - ? WHERE `id` = ?", amount,
+	                                         offerId);
 }
 
 void deleteOffer(uint32_t offerId)
 {
-	Database::getInstance().executeQuery(fmt::format("DELETE FROM `market_offers` WHERE `id` = {:d}", offerId));
+	Database::getInstance().executeStatement("DELETE FROM `market_offers` WHERE `id` = ?", offerId);
 }
 
 void appendHistory(uint32_t playerId, MarketAction_t action, uint16_t itemId, uint16_t amount, uint64_t price,
                    time_t timestamp, MarketOfferState_t state)
 {
-	g_databaseTasks.addTask(fmt::format(
-	    "INSERT INTO `market_history` (`player_id`, `sale`, `itemtype`, `amount`, `price`, `expires_at`, `inserted`, `state`) VALUES ({:d}, {:d}, {:d}, {:d}, {:d}, {:d}, {:d}, {:d})",
-	    playerId, std::to_underlying(action), itemId, amount, price, timestamp, time(nullptr),
-	    std::to_underlying(state)));
+	g_databaseTasks.addJob(0, [=, inserted = time(nullptr)](Database& db) {
+		db.executeStatement(
+		    "INSERT INTO `market_history` (`player_id`, `sale`, `itemtype`, `amount`, `price`, `expires_at`, `inserted`, `state`) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+		    playerId, action, itemId, amount, price, timestamp, inserted, state);
+	});
 }
 
 bool moveOfferToHistory(uint32_t offerId, MarketOfferState_t state)
@@ -277,14 +286,13 @@ bool moveOfferToHistory(uint32_t offerId, MarketOfferState_t state)
 
 	Database& db = Database::getInstance();
 
-	DBResult_ptr result = db.storeQuery(fmt::format(
-	    "SELECT `player_id`, `sale`, `itemtype`, `amount`, `price`, `created` FROM `market_offers` WHERE `id` = {:d}",
-	    offerId));
+	DBResult_ptr result = db.storeStatement(
+	    "SELECT `player_id`, `sale`, `itemtype`, `amount`, `price`, `created` FROM `market_offers` WHERE `id` = ?", offerId);
 	if (!result) {
 		return false;
 	}
 
-	if (!db.executeQuery(fmt::format("DELETE FROM `market_offers` WHERE `id` = {:d}", offerId))) {
+	if (!db.executeStatement("DELETE FROM `market_offers` WHERE `id` = ?", offerId)) {
 		return false;
 	}
 
@@ -148,6 +148,10 @@ Item::Item(const Item& i) : Thing(), id(i.id), count(i.count), loadedFromMap(i.l
 {
 	if (i.attributes) {
 		attributes.reset(new ItemAttributes(*i.attributes));
+		if (attributes->decaySlot != 0) {
+			attributes->decaySlot = 0;
+			setIntAttr(ITEM_ATTRIBUTE_DURATION, i.getDuration());
+		}
 	}
 }
 
@@ -156,10 +160,13 @@ Item* Item::clone() const
 	Item* item = Item::CreateItem(id, count);
 	if (attributes) {
 		item->attributes.reset(new ItemAttributes(*attributes));
+		if (attributes->decaySlot != 0) {
+			item->attributes->decaySlot = 0;
+			item->setIntAttr(ITEM_ATTRIBUTE_DURATION, getDuration());
+		}
+
 		if (item->getDuration() > 0) {
-			item->incrementReferenceCounter();
-			item->setDecaying(DECAYING_TRUE);
-			g_game.toDecayItems.push_front(item);
+			g_game.scheduleDecay(item);
 		}
 	}
 	return item;
@@ -799,7 +806,7 @@ void Item::serializeAttr(PropWriteStream& propWriteStream) const
 
 	if (hasAttribute(ITEM_ATTRIBUTE_DURATION)) {
 		propWriteStream.write<uint8_t>(ATTR_DURATION);
-		propWriteStream.write<uint32_t>(getIntAttr(ITEM_ATTRIBUTE_DURATION));
+		propWriteStream.write<uint32_t>(getDuration());
 	}
 
 	ItemDecayState_t decayState = getDecaying();
@@ -1055,6 +1062,31 @@ void Item::setUniqueId(uint16_t n)
 	}
 }
 
+void Item::setDuration(int32_t time)
+{
+	if (getDecaySlot() == 0) {
+		setIntAttr(ITEM_ATTRIBUTE_DURATION, time);
+		return;
+	}
+
+	// keep decaying, with the new duration
+	g_game.stopDecay(this);
+	setIntAttr(ITEM_ATTRIBUTE_DURATION, time);
+	g_game.scheduleDecay(this);
+}
+
+uint32_t Item::getDuration() const
+{
+	if (!attributes) {
+		return 0;
+	}
+
+	if (attributes->decaySlot != 0) {
+		return g_game.getDecayDuration(this);
+	}
+	return getIntAttr(ITEM_ATTRIBUTE_DURATION);
+}
+
 void Item::setDefaultDuration()
 {
 	uint32_t duration = getDefaultDurationMin();
@@ -354,6 +354,9 @@ private:
 	std::vector<Attribute> attributes;
 	uint32_t attributeBits = 0;
 
+	// owned by the decay wheel of the game, copies of the attributes must reset it
+	uint32_t decaySlot = 0;
+
 	std::map<CombatType_t, Reflect> reflect;
 	std::map<CombatType_t, uint16_t> boostPercent;
 
@@ -680,15 +683,12 @@ public:
 		return getIntAttr(ITEM_ATTRIBUTE_CORPSEOWNER);
 	}
 
-	void setDuration(int32_t time) { setIntAttr(ITEM_ATTRIBUTE_DURATION, time); }
-	void decreaseDuration(int32_t time) { increaseIntAttr(ITEM_ATTRIBUTE_DURATION, -time); }
-	uint32_t getDuration() const
-	{
-		if (!attributes) {
-			return 0;
-		}
-		return getIntAttr(ITEM_ATTRIBUTE_DURATION);
-	}
+	void setDuration(int32_t time);
+	uint32_t getDuration() const;
+
+	// slot of the item in the decay wheel of the game, 0 while it is not decaying
+	uint32_t getDecaySlot() const { return attributes ? attributes->decaySlot : 0; }
+	void setDecaySlot(uint32_t slot) { getAttributes()->decaySlot = slot; }
 
 	void setDecaying(ItemDecayState_t decayState) { setIntAttr(ITEM_ATTRIBUTE_DECAYSTATE, decayState); }
 	ItemDecayState_t getDecaying() const
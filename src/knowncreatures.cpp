@@ -0,0 +1,117 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "knowncreatures.h"
+
+KnownCreatureList::KnownCreatureList() { index.fill(NONE); }
+
+uint16_t KnownCreatureList::find(uint32_t id) const
+{
+	for (size_t slot = homeSlot(id);; slot = (slot + 1) & INDEX_MASK) {
+		uint16_t node = index[slot];
+		if (node == NONE || nodes[node].id == id) {
+			return node;
+		}
+	}
+}
+
+void KnownCreatureList::addToIndex(uint16_t node)
+{
+	size_t slot = homeSlot(nodes[node].id);
+	while (index[slot] != NONE) {
+		slot = (slot + 1) & INDEX_MASK;
+	}
+	index[slot] = node;
+}
+
+void KnownCreatureList::removeFromIndex(uint32_t id)
+{
+	size_t slot = homeSlot(id);
+	while (nodes[index[slot]].id != id) {
+		slot = (slot + 1) & INDEX_MASK;
+	}
+
+	// shift the following entries back into the hole instead of leaving a tombstone
+	index[slot] = NONE;
+	for (size_t next = (slot + 1) & INDEX_MASK; index[next] != NONE; next = (next + 1) & INDEX_MASK) {
+		size_t home = homeSlot(nodes[index[next]].id);
+		if (((next - home) & INDEX_MASK) >= ((next - slot) & INDEX_MASK)) {
+			index[slot] = index[next];
+			index[next] = NONE;
+			slot = next;
+		}
+	}
+}
+
+void KnownCreatureList::unlink(uint16_t node)
+{
+	Node& entry = nodes[node];
+	if (entry.prev != NONE) {
+		nodes[entry.prev].next = entry.next;
+	} else {
+		head = entry.next;
+	}
+
+	if (entry.next != NONE) {
+		nodes[entry.next].prev = entry.prev;
+	} else {
+		tail = entry.prev;
+	}
+}
+
+void KnownCreatureList::pushFront(uint16_t node)
+{
+	nodes[node].prev = NONE;
+	nodes[node].next = head;
+	if (head != NONE) {
+		nodes[head].prev = node;
+	} else {
+		tail = node;
+	}
+	head = node;
+}
+
+bool KnownCreatureList::insert(uint32_t id, uint32_t& removed, const std::function<bool(uint32_t)>& isVisible)
+{
+	uint16_t node = find(id);
+	if (node != NONE) {
+		if (node != head) {
+			unlink(node);
+			pushFront(node);
+		}
+		return true;
+	}
+
+	if (count < CAPACITY) {
+		removed = 0;
+		node = count++;
+	} else {
+		// creatures still in view are moved to the front, so the next eviction does not check them again
+		node = NONE;
+		for (int i = 0; i < EVICTION_CANDIDATES; ++i) {
+			uint16_t candidate = tail;
+			if (!isVisible(nodes[candidate].id)) {
+				node = candidate;
+				break;
+			}
+			unlink(candidate);
+			pushFront(candidate);
+		}
+
+		if (node == NONE) {
+			// everything checked is in view, forget the least recently sent one anyway
+			node = tail;
+		}
+
+		removed = nodes[node].id;
+		unlink(node);
+		removeFromIndex(removed);
+	}
+
+	nodes[node].id = id;
+	pushFront(node);
+	addToIndex(node);
+	return false;
+}
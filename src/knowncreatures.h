@@ -0,0 +1,68 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_KNOWNCREATURES_H
+#define FS_KNOWNCREATURES_H
+
+/**
+ * The creatures a client has already been sent in full, with the same capacity as the list kept by the client.
+ *
+ * Entries are kept in least recently sent order in a fixed array of nodes, indexed by a flat open addressing table,
+ * so lookups, inserts and evictions never allocate nor scan the whole list.
+ */
+class KnownCreatureList
+{
+public:
+	static constexpr uint16_t CAPACITY = 1300;
+
+	KnownCreatureList();
+
+	// non-copyable
+	KnownCreatureList(const KnownCreatureList&) = delete;
+	KnownCreatureList& operator=(const KnownCreatureList&) = delete;
+
+	bool contains(uint32_t id) const { return find(id) != NONE; }
+	size_t size() const { return count; }
+
+	/**
+	 * Marks id as the most recently sent creature and returns whether it was known already. When a new id does not
+	 * fit, one of the least recently sent creatures is forgotten and stored in removed (0 otherwise), preferring one
+	 * that isVisible rejects.
+	 */
+	bool insert(uint32_t id, uint32_t& removed, const std::function<bool(uint32_t)>& isVisible);
+
+private:
+	static constexpr uint16_t NONE = 0xFFFF;
+
+	// at most a third of the slots are used, which keeps the probe sequences short
+	static constexpr int INDEX_BITS = 12;
+	static constexpr size_t INDEX_SIZE = 1 << INDEX_BITS;
+	static constexpr size_t INDEX_MASK = INDEX_SIZE - 1;
+
+	// least recently sent entries checked for visibility before evicting anyway
+	static constexpr int EVICTION_CANDIDATES = 8;
+
+	struct Node
+	{
+		uint32_t id;
+		uint16_t prev;
+		uint16_t next;
+	};
+
+	static size_t homeSlot(uint32_t id) { return (id * 0x9E3779B1u) >> (32 - INDEX_BITS); }
+
+	uint16_t find(uint32_t id) const;
+	void addToIndex(uint16_t node);
+	void removeFromIndex(uint32_t id);
+
+	void unlink(uint16_t node);
+	void pushFront(uint16_t node);
+
+	std::array<Node, CAPACITY> nodes;
+	std::array<uint16_t, INDEX_SIZE> index;
+	uint16_t head = NONE;
+	uint16_t tail = NONE;
+	uint16_t count = 0;
+};
+
+#endif // FS_KNOWNCREATURES_H
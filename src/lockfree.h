@@ -28,43 +28,186 @@ struct LockfreeFreeList
 	}
 };
 
-template <typename T, size_t Capacity>
-class LockfreePoolingAllocator
+/**
+ * Hook for the objects stored in an MpscQueue, the queue is intrusive so pushing never allocates.
+ */
+struct MpscQueueNode
+{
+	std::atomic<MpscQueueNode*> mpscNext{nullptr};
+};
+
+/**
+ * Unbounded intrusive multi-producer single-consumer queue (Dmitry Vyukov's algorithm).
+ *
+ * Producers only do one atomic exchange and one store, so they never wait for each other nor for the consumer. A
+ * producer that was preempted between both steps makes the following items invisible for a moment: pop returns
+ * nullptr while empty is already false, and the consumer should simply retry.
+ */
+template <typename T>
+class MpscQueue
 {
 public:
-	template <class U>
-	struct rebind
+	MpscQueue() = default;
+
+	// non-copyable
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	void push(T* item)
 	{
-		using other = LockfreePoolingAllocator<U, Capacity>;
-	};
+		MpscQueueNode* node = item;
+		node->mpscNext.store(nullptr, std::memory_order_relaxed);
+		MpscQueueNode* prev = tail.exchange(node);
+		prev->mpscNext.store(node, std::memory_order_release);
+	}
 
-	LockfreePoolingAllocator() = default;
+	// consumer only
+	T* pop()
+	{
+		MpscQueueNode* first = head;
+		MpscQueueNode* next = first->mpscNext.load(std::memory_order_acquire);
+		if (first == &stub) {
+			if (!next) {
+				return nullptr;
+			}
+			head = next;
+			first = next;
+			next = next->mpscNext.load(std::memory_order_acquire);
+		}
 
-	template <typename U>
-	explicit constexpr LockfreePoolingAllocator(const LockfreePoolingAllocator<U, Capacity>&)
-	{}
-	using value_type = T;
+		if (next) {
+			head = next;
+			return static_cast<T*>(first);
+		}
 
-	T* allocate(size_t) const
+		if (first != tail.load(std::memory_order_acquire)) {
+			// a producer is in the middle of a push
+			return nullptr;
+		}
+
+		// first is the last item, put the stub back behind it so it can be detached
+		pushStub();
+		next = first->mpscNext.load(std::memory_order_acquire);
+		if (next) {
+			head = next;
+			return static_cast<T*>(first);
+		}
+		return nullptr;
+	}
+
+	// consumer only, false as soon as a push has started
+	bool empty() const { return head == &stub && tail.load() == &stub; }
+
+private:
+	void pushStub()
 	{
-		auto& inst = LockfreeFreeList<sizeof(T), Capacity>::get();
-		void* p; // NOTE: p doesn't have to be initialized
-		if (!inst.pop(p)) {
-			// Acquire memory without calling the constructor of T
-			p = operator new(sizeof(T));
+		stub.mpscNext.store(nullptr, std::memory_order_relaxed);
+		MpscQueueNode* prev = tail.exchange(&stub, std::memory_order_acq_rel);
+		prev->mpscNext.store(&stub, std::memory_order_release);
+	}
+
+	MpscQueueNode stub;
+	MpscQueueNode* head = &stub;
+	alignas(64) std::atomic<MpscQueueNode*> tail{&stub};
+};
+
+/**
+ * Fixed array of SlotCount blocks of SlotSize bytes, the free ones kept in a lock-free stack of indices.
+ *
+ * Any thread may allocate, but only one thread (the consumer of whatever is built in the blocks) may release. The
+ * consumer collects released blocks and hands them back RELEASE_BATCH at a time, so it touches the shared head once per
+ * batch. The head carries a tag next to the index of the first free block, so a pop racing with another pop and push
+ * of the same block fails instead of corrupting the stack.
+ */
+template <size_t SlotSize, size_t SlotCount>
+class LockfreeSlab
+{
+public:
+	static constexpr size_t RELEASE_BATCH = 64;
+
+	LockfreeSlab() : slots(new Slot[SlotCount]), next(new std::atomic<uint32_t>[SlotCount])
+	{
+		for (uint32_t i = 0; i < SlotCount; ++i) {
+			next[i].store(i + 1 < SlotCount ? i + 1 : NONE, std::memory_order_relaxed);
+		}
+	}
+
+	// non-copyable
+	LockfreeSlab(const LockfreeSlab&) = delete;
+	LockfreeSlab& operator=(const LockfreeSlab&) = delete;
+
+	// returns nullptr when every block is in use
+	void* allocate()
+	{
+		uint64_t first = head.load(std::memory_order_acquire);
+		while (getIndex(first) != NONE) {
+			uint64_t second = nextTag(first) | next[getIndex(first)].load(std::memory_order_relaxed);
+			if (head.compare_exchange_weak(first, second, std::memory_order_acquire, std::memory_order_acquire)) {
+				return slots[getIndex(first)].bytes;
+			}
+		}
+		return nullptr;
+	}
+
+	bool owns(const void* block) const
+	{
+		const Slot* slot = static_cast<const Slot*>(block);
+		return !std::less<const Slot*>()(slot, slots.get()) && std::less<const Slot*>()(slot, slots.get() + SlotCount);
+	}
+
+	// consumer only
+	void release(void* block)
+	{
+		uint32_t index = static_cast<uint32_t>(static_cast<Slot*>(block) - slots.get());
+		next[index].store(released, std::memory_order_relaxed);
+		if (released == NONE) {
+			releasedLast = index;
+		}
+		released = index;
+
+		if (++releasedCount == RELEASE_BATCH) {
+			flush();
 		}
-		return static_cast<T*>(p);
 	}
 
-	void deallocate(T* p, size_t) const
+	// consumer only, makes the blocks released so far available again
+	void flush()
 	{
-		auto& inst = LockfreeFreeList<sizeof(T), Capacity>::get();
-		if (!inst.bounded_push(p)) {
-			// Release memory without calling the destructor of T
-			//(it has already been called at this point)
-			operator delete(p);
+		if (releasedCount == 0) {
+			return;
 		}
+
+		uint64_t first = head.load(std::memory_order_relaxed);
+		do {
+			next[releasedLast].store(getIndex(first), std::memory_order_relaxed);
+		} while (!head.compare_exchange_weak(first, nextTag(first) | released, std::memory_order_release,
+		                                     std::memory_order_relaxed));
+
+		released = NONE;
+		releasedCount = 0;
 	}
+
+private:
+	static_assert(SlotCount < std::numeric_limits<uint32_t>::max());
+
+	static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+	static uint32_t getIndex(uint64_t head) { return static_cast<uint32_t>(head); }
+	static uint64_t nextTag(uint64_t head) { return ((head >> 32) + 1) << 32; }
+
+	struct alignas(64) Slot
+	{
+		unsigned char bytes[SlotSize];
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	std::unique_ptr<std::atomic<uint32_t>[]> next;
+	alignas(64) std::atomic<uint64_t> head{0};
+
+	// released blocks not handed back yet, chained through next
+	alignas(64) uint32_t released = NONE;
+	uint32_t releasedLast = NONE;
+	size_t releasedCount = 0;
 };
 
 #endif // FS_LOCKFREE_H
@@ -21,6 +21,7 @@
 #include "iomarket.h"
 #include "luavariant.h"
 #include "matrixarea.h"
+#include "messagepool.h"
 #include "monster.h"
 #include "movement.h"
 #include "npc.h"
@@ -2416,6 +2417,8 @@ void LuaScriptInterface::registerFunctions()
 	registerMethod(L, "Game", "startEvent", LuaScriptInterface::luaGameStartEvent);
 
 	registerMethod(L, "Game", "getClientVersion", LuaScriptInterface::luaGameGetClientVersion);
+	registerMethod(L, "Game", "getMessagePoolStats", LuaScriptInterface::luaGameGetMessagePoolStats);
+	registerMethod(L, "Game", "getDatabaseStats", LuaScriptInterface::luaGameGetDatabaseStats);
 
 	registerMethod(L, "Game", "reload", LuaScriptInterface::luaGameReload);
 
@@ -5155,6 +5158,45 @@ int LuaScriptInterface::luaGameGetClientVersion(lua_State* L)
 	return 1;
 }
 
+int LuaScriptInterface::luaGameGetMessagePoolStats(lua_State* L)
+{
+	// Game.getMessagePoolStats()
+	const auto stats = tfs::net::get_message_pool_stats();
+	lua_createtable(L, stats.size(), 0);
+
+	int index = 0;
+	for (const auto& sizeClass : stats) {
+		lua_createtable(L, 0, 6);
+		setField(L, "blockSize", sizeClass.blockSize);
+		setField(L, "hits", sizeClass.hits);
+		setField(L, "misses", sizeClass.misses);
+		setField(L, "inUse", sizeClass.inUse);
+		setField(L, "highWater", sizeClass.highWater);
+		setField(L, "cached", sizeClass.cached);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int LuaScriptInterface::luaGameGetDatabaseStats(lua_State* L)
+{
+	// Game.getDatabaseStats()
+	const auto stats = g_databaseTasks.getStats();
+	lua_createtable(L, stats.size(), 0);
+
+	int index = 0;
+	for (const auto& worker : stats) {
+		lua_createtable(L, 0, 5);
+		setField(L, "queued", worker.queued);
+		setField(L, "maxQueued", worker.maxQueued);
+		setField(L, "executed", worker.executed);
+		setField(L, "waitTime", worker.waitTime);
+		setField(L, "runTime", worker.runTime);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
 int LuaScriptInterface::luaGameReload(lua_State* L)
 {
 	// Game.reload(reloadType)
@@ -6996,7 +7038,9 @@ int LuaScriptInterface::luaItemGetAttribute(lua_State* L)
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
 
-	if (ItemAttributes::isIntAttrType(attribute)) {
+	if (attribute == ITEM_ATTRIBUTE_DURATION) {
+		lua_pushnumber(L, item->getDuration());
+	} else if (ItemAttributes::isIntAttrType(attribute)) {
 		lua_pushnumber(L, item->getIntAttr(attribute));
 	} else if (ItemAttributes::isStrAttrType(attribute)) {
 		tfs::lua::pushString(L, item->getStrAttr(attribute));
@@ -7031,7 +7075,16 @@ int LuaScriptInterface::luaItemSetAttribute(lua_State* L)
 			return 1;
 		}
 
-		item->setIntAttr(attribute, tfs::lua::getNumber<int32_t>(L, 3));
+		if (attribute == ITEM_ATTRIBUTE_DURATION) {
+			item->setDuration(tfs::lua::getNumber<int32_t>(L, 3));
+		} else {
+			item->setIntAttr(attribute, tfs::lua::getNumber<int32_t>(L, 3));
+		}
+
+		// counts and fluids are part of how the item looks on the map
+		if (Tile* tile = item->getTile()) {
+			tile->invalidateDescription();
+		}
 		tfs::lua::pushBoolean(L, true);
 	} else if (ItemAttributes::isStrAttrType(attribute)) {
 		item->setStrAttr(attribute, tfs::lua::getString(L, 3));
@@ -7063,6 +7116,9 @@ int LuaScriptInterface::luaItemRemoveAttribute(lua_State* L)
 	bool ret = attribute != ITEM_ATTRIBUTE_UNIQUEID;
 	if (ret) {
 		item->removeAttribute(attribute);
+		if (Tile* tile = item->getTile()) {
+			tile->invalidateDescription();
+		}
 	} else {
 		reportErrorFunc(L, "Attempt to erase protected key \"uid\"");
 	}
@@ -10925,9 +10981,16 @@ int LuaScriptInterface::luaPlayerGetClient(lua_State* L)
 	// player:getClient()
 	Player* player = tfs::lua::getUserdata<Player>(L, 1);
 	if (player) {
-		lua_createtable(L, 0, 2);
+		const CompressionStats stats = player->getCompressionStats();
+		lua_createtable(L, 0, 7);
 		setField(L, "version", player->getProtocolVersion());
 		setField(L, "os", player->getOperatingSystem());
+		setField(L, "compressionLevel", stats.level);
+		setField(L, "compressionRatio",
+		         stats.bytesIn != 0 ? static_cast<double>(stats.bytesOut) / stats.bytesIn : 1.0);
+		setField(L, "compressionTime", std::chrono::duration_cast<std::chrono::microseconds>(stats.time).count());
+		setField(L, "compressedMessages", stats.compressedMessages);
+		setField(L, "uncompressedMessages", stats.skippedMessages);
 	} else {
 		lua_pushnil(L);
 	}
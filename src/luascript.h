@@ -308,6 +308,8 @@ private:
 	static int luaGameStartEvent(lua_State* L);
 
 	static int luaGameGetClientVersion(lua_State* L);
+	static int luaGameGetMessagePoolStats(lua_State* L);
+	static int luaGameGetDatabaseStats(lua_State* L);
 
 	static int luaGameReload(lua_State* L);
 
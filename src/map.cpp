@@ -38,30 +38,6 @@ bool Map::loadMap(const std::string& identifier, bool loadHouses, bool isCalledB
 	return true;
 }
 
-bool Map::save()
-{
-	bool saved = false;
-	for (uint32_t tries = 0; tries < 3; tries++) {
-		if (IOMapSerialize::saveHouseInfo()) {
-			saved = true;
-			break;
-		}
-	}
-
-	if (!saved) {
-		return false;
-	}
-
-	saved = false;
-	for (uint32_t tries = 0; tries < 3; tries++) {
-		if (IOMapSerialize::saveHouseItems()) {
-			saved = true;
-			break;
-		}
-	}
-	return saved;
-}
-
 Tile* Map::getTile(uint16_t x, uint16_t y, uint8_t z) const
 {
 	if (z >= MAP_MAX_LAYERS) {
@@ -87,35 +63,7 @@ void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 		return;
 	}
 
-	QTreeLeafNode::newLeaf = false;
 	QTreeLeafNode* leaf = root.createLeaf(x, y, 15);
-
-	if (QTreeLeafNode::newLeaf) {
-		// update north
-		QTreeLeafNode* northLeaf = root.getLeaf(x, y - FLOOR_SIZE);
-		if (northLeaf) {
-			northLeaf->leafS = leaf;
-		}
-
-		// update west leaf
-		QTreeLeafNode* westLeaf = root.getLeaf(x - FLOOR_SIZE, y);
-		if (westLeaf) {
-			westLeaf->leafE = leaf;
-		}
-
-		// update south
-		QTreeLeafNode* southLeaf = root.getLeaf(x, y + FLOOR_SIZE);
-		if (southLeaf) {
-			leaf->leafS = southLeaf;
-		}
-
-		// update east
-		QTreeLeafNode* eastLeaf = root.getLeaf(x + FLOOR_SIZE, y);
-		if (eastLeaf) {
-			leaf->leafE = eastLeaf;
-		}
-	}
-
 	Floor* floor = leaf->createFloor(z);
 	uint32_t offsetX = x & FLOOR_MASK;
 	uint32_t offsetY = y & FLOOR_MASK;
@@ -243,8 +191,7 @@ bool Map::placeCreature(const Position& centerPos, Creature* creature, bool exte
 	Cylinder* toCylinder = tile->queryDestination(index, *creature, &toItem, flags);
 	toCylinder->internalAddThing(creature);
 
-	const Position& dest = toCylinder->getPosition();
-	getQTNode(dest.x, dest.y)->addCreature(creature);
+	spectatorGrid.addCreature(creature, toCylinder->getPosition(), creature->getPlayer() != nullptr);
 	return true;
 }
 
@@ -281,14 +228,8 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport /*
 	// remove the creature
 	oldTile.removeThing(&creature, 0);
 
-	QTreeLeafNode* leaf = getQTNode(oldPos.x, oldPos.y);
-	QTreeLeafNode* new_leaf = getQTNode(newPos.x, newPos.y);
-
-	// Switch the node ownership
-	if (leaf != new_leaf) {
-		leaf->removeCreature(&creature);
-		new_leaf->addCreature(&creature);
-	}
+	// update the spectator index
+	spectatorGrid.moveCreature(&creature, oldPos, newPos, creature.getPlayer() != nullptr);
 
 	// add the creature
 	newTile.addThing(&creature);
@@ -307,15 +248,22 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport /*
 		}
 	}
 
-	// send to client
+	// send to client, a plain step is the same packet for every spectator that had the creature at the same stackpos
+	NetworkMessage step;
+	int32_t stepStackPos = -1;
 	size_t i = 0;
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			// Use the correct stackpos
 			int32_t stackpos = oldStackPosVector[i++];
 			if (stackpos != -1) {
+				if (stackpos != stepStackPos) {
+					step.reset();
+					ProtocolGame::AddCreatureStep(step, &creature, oldPos, stackpos, newPos);
+					stepStackPos = stackpos;
+				}
 				tmpPlayer->sendCreatureMove(&creature, newPos, newTile.getClientIndexOfCreature(tmpPlayer, &creature),
-				                            oldPos, stackpos, teleport);
+				                            oldPos, stackpos, teleport, &step);
 			}
 		}
 	}
@@ -333,60 +281,60 @@ void Map::getSpectatorsInternal(SpectatorVec& spectators, const Position& center
                                 int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ,
                                 int32_t maxRangeZ, bool onlyPlayers) const
 {
-	auto min_y = centerPos.y + minRangeY;
-	auto min_x = centerPos.x + minRangeX;
-	auto max_y = centerPos.y + maxRangeY;
-	auto max_x = centerPos.x + maxRangeX;
-
-	int32_t minoffset = centerPos.getZ() - maxRangeZ;
-	uint16_t x1 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (min_x + minoffset)));
-	uint16_t y1 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (min_y + minoffset)));
-
-	int32_t maxoffset = centerPos.getZ() - minRangeZ;
-	uint16_t x2 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (max_x + maxoffset)));
-	uint16_t y2 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (max_y + maxoffset)));
-
-	int32_t startx1 = x1 - (x1 % FLOOR_SIZE);
-	int32_t starty1 = y1 - (y1 % FLOOR_SIZE);
-	int32_t endx2 = x2 - (x2 % FLOOR_SIZE);
-	int32_t endy2 = y2 - (y2 % FLOOR_SIZE);
-
-	const QTreeLeafNode* startLeaf =
-	    QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, startx1, starty1);
-	const QTreeLeafNode* leafS = startLeaf;
-	const QTreeLeafNode* leafE;
-
-	for (int_fast32_t ny = starty1; ny <= endy2; ny += FLOOR_SIZE) {
-		leafE = leafS;
-		for (int_fast32_t nx = startx1; nx <= endx2; nx += FLOOR_SIZE) {
-			if (leafE) {
-				const CreatureVector& node_list = (onlyPlayers ? leafE->player_list : leafE->creature_list);
-				for (Creature* creature : node_list) {
-					const Position& cpos = creature->getPosition();
-					if (minRangeZ > cpos.z || maxRangeZ < cpos.z) {
-						continue;
-					}
-
-					int16_t offsetZ = centerPos.getOffsetZ(cpos);
-					if ((min_y + offsetZ) > cpos.y || (max_y + offsetZ) < cpos.y || (min_x + offsetZ) > cpos.x ||
-					    (max_x + offsetZ) < cpos.x) {
-						continue;
-					}
-
-					spectators.emplace_back(creature);
-				}
-				leafE = leafE->leafE;
-			} else {
-				leafE = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, nx + FLOOR_SIZE, ny);
-			}
-		}
+	spectatorGrid.getSpectators(spectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ,
+	                            onlyPlayers);
+}
 
-		if (leafS) {
-			leafS = leafS->leafS;
-		} else {
-			leafS = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, startx1, ny + FLOOR_SIZE);
-		}
+namespace {
+
+constexpr size_t SPECTATOR_CACHE_MAX_CELLS = 4096;
+
+uint32_t getSpectatorCacheKey(const Position& pos)
+{
+	return (static_cast<uint32_t>(pos.z) << 24) | ((pos.y >> SpectatorGrid::CELL_BITS) << 12) |
+	       (pos.x >> SpectatorGrid::CELL_BITS);
+}
+
+} // namespace
+
+const SpectatorVec* Map::getCachedSpectators(SpectatorCache& cache, const Position& centerPos, int32_t minRangeZ,
+                                             int32_t maxRangeZ)
+{
+	auto it = cache.find(getSpectatorCacheKey(centerPos));
+	if (it == cache.end()) {
+		return nullptr;
+	}
+
+	auto& entries = it->second;
+	auto entry = std::find_if(entries.begin(), entries.end(),
+	                          [&](const CachedSpectators& cached) { return cached.centerPos == centerPos; });
+	if (entry == entries.end()) {
+		return nullptr;
 	}
+
+	// the result stays valid as long as no creature changed in the area covered by any of the scanned floors
+	if (spectatorGrid.isUnchangedSince(entry->version, centerPos.x - maxViewportX + centerPos.getZ() - maxRangeZ,
+	                                   centerPos.x + maxViewportX + centerPos.getZ() - minRangeZ,
+	                                   centerPos.y - maxViewportY + centerPos.getZ() - maxRangeZ,
+	                                   centerPos.y + maxViewportY + centerPos.getZ() - minRangeZ)) {
+		return &entry->spectators;
+	}
+
+	*entry = std::move(entries.back());
+	entries.pop_back();
+	if (entries.empty()) {
+		cache.erase(it);
+	}
+	return nullptr;
+}
+
+void Map::cacheSpectators(SpectatorCache& cache, const Position& centerPos, const SpectatorVec& spectators)
+{
+	if (cache.size() >= SPECTATOR_CACHE_MAX_CELLS) {
+		cache.clear();
+	}
+
+	cache[getSpectatorCacheKey(centerPos)].push_back({centerPos, spectatorGrid.getVersion(), spectators});
 }
 
 void Map::getSpectators(SpectatorVec& spectators, const Position& centerPos, bool multifloor /*= false*/,
@@ -397,95 +345,81 @@ void Map::getSpectators(SpectatorVec& spectators, const Position& centerPos, boo
 		return;
 	}
 
-	bool foundCache = false;
-	bool cacheResult = false;
-
 	minRangeX = (minRangeX == 0 ? -maxViewportX : -minRangeX);
 	maxRangeX = (maxRangeX == 0 ? maxViewportX : maxRangeX);
 	minRangeY = (minRangeY == 0 ? -maxViewportY : -minRangeY);
 	maxRangeY = (maxRangeY == 0 ? maxViewportY : maxRangeY);
 
-	if (minRangeX == -maxViewportX && maxRangeX == maxViewportX && minRangeY == -maxViewportY &&
-	    maxRangeY == maxViewportY && multifloor) {
-		if (onlyPlayers) {
-			auto it = playersSpectatorCache.find(centerPos);
-			if (it != playersSpectatorCache.end()) {
-				if (!spectators.empty()) {
-					spectators.addSpectators(it->second);
-				} else {
-					spectators = it->second;
-				}
-
-				foundCache = true;
-			}
+	int32_t minRangeZ;
+	int32_t maxRangeZ;
+
+	if (multifloor) {
+		if (centerPos.z > 7) {
+			// underground (8->15)
+			minRangeZ = std::max(centerPos.getZ() - 2, 0);
+			maxRangeZ = std::min(centerPos.getZ() + 2, MAP_MAX_LAYERS - 1);
+		} else if (centerPos.z == 6) {
+			minRangeZ = 0;
+			maxRangeZ = 8;
+		} else if (centerPos.z == 7) {
+			minRangeZ = 0;
+			maxRangeZ = 9;
+		} else {
+			minRangeZ = 0;
+			maxRangeZ = 7;
 		}
+	} else {
+		minRangeZ = centerPos.z;
+		maxRangeZ = centerPos.z;
+	}
 
-		if (!foundCache) {
-			auto it = spectatorCache.find(centerPos);
-			if (it != spectatorCache.end()) {
-				if (!onlyPlayers) {
-					if (!spectators.empty()) {
-						const SpectatorVec& cachedSpectators = it->second;
-						spectators.addSpectators(cachedSpectators);
-					} else {
-						spectators = it->second;
-					}
-				} else {
-					const SpectatorVec& cachedSpectators = it->second;
-					for (Creature* spectator : cachedSpectators) {
-						if (spectator->getPlayer()) {
-							spectators.emplace_back(spectator);
-						}
-					}
-				}
+	if (minRangeX != -maxViewportX || maxRangeX != maxViewportX || minRangeY != -maxViewportY ||
+	    maxRangeY != maxViewportY || !multifloor) {
+		getSpectatorsInternal(spectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ,
+		                      onlyPlayers);
+		return;
+	}
 
-				foundCache = true;
+	if (onlyPlayers) {
+		if (const SpectatorVec* cachedSpectators =
+		        getCachedSpectators(playersSpectatorCache, centerPos, minRangeZ, maxRangeZ)) {
+			if (!spectators.empty()) {
+				spectators.addSpectators(*cachedSpectators);
 			} else {
-				cacheResult = true;
+				spectators = *cachedSpectators;
 			}
+			return;
 		}
 	}
 
-	if (!foundCache) {
-		int32_t minRangeZ;
-		int32_t maxRangeZ;
-
-		if (multifloor) {
-			if (centerPos.z > 7) {
-				// underground (8->15)
-				minRangeZ = std::max(centerPos.getZ() - 2, 0);
-				maxRangeZ = std::min(centerPos.getZ() + 2, MAP_MAX_LAYERS - 1);
-			} else if (centerPos.z == 6) {
-				minRangeZ = 0;
-				maxRangeZ = 8;
-			} else if (centerPos.z == 7) {
-				minRangeZ = 0;
-				maxRangeZ = 9;
+	if (const SpectatorVec* cachedSpectators = getCachedSpectators(spectatorCache, centerPos, minRangeZ, maxRangeZ)) {
+		if (!onlyPlayers) {
+			if (!spectators.empty()) {
+				spectators.addSpectators(*cachedSpectators);
 			} else {
-				minRangeZ = 0;
-				maxRangeZ = 7;
+				spectators = *cachedSpectators;
 			}
 		} else {
-			minRangeZ = centerPos.z;
-			maxRangeZ = centerPos.z;
-		}
-
-		getSpectatorsInternal(spectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ,
-		                      onlyPlayers);
-
-		if (cacheResult) {
-			if (onlyPlayers) {
-				playersSpectatorCache[centerPos] = spectators;
-			} else {
-				spectatorCache[centerPos] = spectators;
+			for (Creature* spectator : *cachedSpectators) {
+				if (spectator->getPlayer()) {
+					spectators.emplace_back(spectator);
+				}
 			}
 		}
+		return;
 	}
-}
 
-void Map::clearSpectatorCache() { spectatorCache.clear(); }
+	SpectatorVec foundSpectators;
+	getSpectatorsInternal(foundSpectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ,
+	                      onlyPlayers);
+	cacheSpectators(onlyPlayers ? playersSpectatorCache : spectatorCache, centerPos, foundSpectators);
 
-void Map::clearPlayersSpectatorCache() { playersSpectatorCache.clear(); }
+	if (!spectators.empty()) {
+		spectators.addSpectators(foundSpectators);
+	} else {
+		spectators = std::move(foundSpectators);
+	}
+}
 
 bool Map::canThrowObjectTo(const Position& fromPos, const Position& toPos, bool checkLineOfSight /*= true*/,
                            bool sameFloor /*= false*/, int32_t rangex /*= Map::maxClientViewportX*/,
@@ -663,6 +597,269 @@ const Tile* Map::canWalkTo(const Creature& creature, const Position& pos) const
 	return tile;
 }
 
+namespace {
+
+// paths found by monsters are kept shortly per target, another monster of the same type standing on one of them
+// walks the rest of it instead of searching again
+constexpr int64_t PATH_CACHE_DURATION = 250;
+constexpr size_t PATH_CACHE_MAX_TARGETS = 1024;
+constexpr size_t PATH_CACHE_PATHS_PER_TARGET = 8;
+
+struct CachedPath
+{
+	int64_t expiration;
+	const MonsterType* monsterType;
+	FindPathParams fpp;
+	// tiles from the start to the end of the path, dirList holds the steps in reverse order like getPathMatching
+	std::vector<uint32_t> tiles;
+	std::vector<Direction> dirList;
+};
+
+thread_local std::unordered_map<uint64_t, std::vector<CachedPath>> pathCache;
+
+uint64_t getPathCacheKey(const Position& targetPos)
+{
+	return (static_cast<uint64_t>(targetPos.z) << 32) | hashCoord(targetPos.x, targetPos.y);
+}
+
+const MonsterType* getPathCacheProfile(const Creature& creature, const FindPathParams& fpp)
+{
+	// only searches that do not depend on the start position are shared, and only between monsters that walk alike
+	if (!fpp.fullPathSearch || fpp.keepDistance || fpp.summonTargetMaster) {
+		return nullptr;
+	}
+
+	const Monster* monster = creature.getMonster();
+	if (!monster || monster->isSummon()) {
+		return nullptr;
+	}
+	return monster->getMonsterType();
+}
+
+bool getCachedPath(const MonsterType* monsterType, const Position& startPos, const Position& targetPos,
+                   const FindPathParams& fpp, std::vector<Direction>& dirList)
+{
+	auto it = pathCache.find(getPathCacheKey(targetPos));
+	if (it == pathCache.end()) {
+		return false;
+	}
+
+	int64_t now = OTSYS_TIME();
+	uint32_t startTile = hashCoord(startPos.x, startPos.y);
+	for (const CachedPath& path : it->second) {
+		if (path.expiration < now || path.monsterType != monsterType || path.fpp != fpp) {
+			continue;
+		}
+
+		auto tile = std::find(path.tiles.begin(), path.tiles.end() - 1, startTile);
+		if (tile != path.tiles.end() - 1) {
+			size_t steps = path.tiles.end() - 1 - tile;
+			dirList.insert(dirList.end(), path.dirList.begin(), path.dirList.begin() + steps);
+			return true;
+		}
+	}
+	return false;
+}
+
+void addCachedPath(const MonsterType* monsterType, const Position& targetPos, const FindPathParams& fpp,
+                   const AStarNode* endNode, std::vector<Direction>::const_iterator first,
+                   std::vector<Direction>::const_iterator last)
+{
+	int64_t now = OTSYS_TIME();
+	if (pathCache.size() >= PATH_CACHE_MAX_TARGETS) {
+		std::erase_if(pathCache, [now](const auto& entry) {
+			return std::all_of(entry.second.begin(), entry.second.end(),
+			                   [now](const CachedPath& path) { return path.expiration < now; });
+		});
+	}
+
+	auto& paths = pathCache[getPathCacheKey(targetPos)];
+	std::erase_if(paths, [now](const CachedPath& path) { return path.expiration < now; });
+	if (paths.size() >= PATH_CACHE_PATHS_PER_TARGET) {
+		paths.erase(paths.begin());
+	}
+
+	CachedPath& path = paths.emplace_back(CachedPath{now + PATH_CACHE_DURATION, monsterType, fpp, {}, {first, last}});
+	for (const AStarNode* node = endNode; node; node = node->parent) {
+		path.tiles.push_back(hashCoord(node->x, node->y));
+	}
+	std::reverse(path.tiles.begin(), path.tiles.end());
+}
+
+// melee followers of the same type close to a target share one field of the walking costs towards it, built by a
+// reverse Dijkstra search from the tiles next to the target once enough of them asked for a path to it
+constexpr int32_t FLOW_FIELD_RADIUS = Map::maxViewportX + 1;
+constexpr int32_t FLOW_FIELD_SIDE = FLOW_FIELD_RADIUS * 2 + 1;
+constexpr int64_t FLOW_FIELD_DURATION = 500;
+constexpr uint32_t FLOW_FIELD_MIN_REQUESTS = 4;
+constexpr size_t FLOW_FIELD_MAX_FIELDS = 256;
+constexpr uint32_t FLOW_FIELD_UNREACHABLE = std::numeric_limits<uint32_t>::max();
+
+constexpr std::array<std::pair<int32_t, int32_t>, 8> flowFieldNeighbors = {
+    {{-1, 0}, {0, 1}, {1, 0}, {0, -1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}}};
+
+struct FlowField
+{
+	int64_t expiration = 0;
+	uint32_t requests = 0;
+	bool built = false;
+	// cost from each tile of the window to the tiles next to the target, and the cost of stepping on each tile
+	std::array<uint32_t, FLOW_FIELD_SIDE * FLOW_FIELD_SIDE> costs;
+	std::array<uint32_t, FLOW_FIELD_SIDE * FLOW_FIELD_SIDE> tileCosts;
+};
+
+using FlowFieldKey = std::pair<uint64_t, const MonsterType*>;
+
+thread_local std::map<FlowFieldKey, FlowField> flowFields;
+
+void buildFlowField(const Map& map, const Creature& creature, const Position& targetPos, FlowField& field)
+{
+	field.costs.fill(FLOW_FIELD_UNREACHABLE);
+
+	Position pos = targetPos;
+	for (int32_t y = 0; y < FLOW_FIELD_SIDE; ++y) {
+		for (int32_t x = 0; x < FLOW_FIELD_SIDE; ++x) {
+			pos.x = targetPos.x + x - FLOW_FIELD_RADIUS;
+			pos.y = targetPos.y + y - FLOW_FIELD_RADIUS;
+
+			const Tile* tile = targetPos.getDistanceX(pos) + targetPos.getDistanceY(pos) != 0
+			                       ? map.canWalkTo(creature, pos)
+			                       : nullptr;
+			field.tileCosts[y * FLOW_FIELD_SIDE + x] =
+			    tile ? AStarNodes::getTileWalkCost(creature, tile) : FLOW_FIELD_UNREACHABLE;
+		}
+	}
+
+	using QueueEntry = std::pair<uint32_t, uint16_t>;
+	thread_local std::vector<QueueEntry> queue;
+	queue.clear();
+
+	for (const auto& [offsetX, offsetY] : flowFieldNeighbors) {
+		uint16_t index = (FLOW_FIELD_RADIUS + offsetY) * FLOW_FIELD_SIDE + FLOW_FIELD_RADIUS + offsetX;
+		if (field.tileCosts[index] != FLOW_FIELD_UNREACHABLE) {
+			field.costs[index] = 0;
+			queue.emplace_back(0, index);
+		}
+	}
+
+	std::make_heap(queue.begin(), queue.end(), std::greater<>());
+	while (!queue.empty()) {
+		std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+		auto [cost, index] = queue.back();
+		queue.pop_back();
+		if (cost != field.costs[index]) {
+			continue;
+		}
+
+		// walking from a neighbour onto this tile
+		int32_t x = index % FLOW_FIELD_SIDE;
+		int32_t y = index / FLOW_FIELD_SIDE;
+		for (const auto& [offsetX, offsetY] : flowFieldNeighbors) {
+			int32_t neighborX = x + offsetX;
+			int32_t neighborY = y + offsetY;
+			if (neighborX < 0 || neighborX >= FLOW_FIELD_SIDE || neighborY < 0 || neighborY >= FLOW_FIELD_SIDE) {
+				continue;
+			}
+
+			uint16_t neighbor = neighborY * FLOW_FIELD_SIDE + neighborX;
+			if (field.tileCosts[neighbor] == FLOW_FIELD_UNREACHABLE) {
+				continue;
+			}
+
+			uint32_t walkCost = offsetX != 0 && offsetY != 0 ? MAP_DIAGONALWALKCOST : MAP_NORMALWALKCOST;
+			uint32_t neighborCost = cost + walkCost + field.tileCosts[index];
+			if (neighborCost < field.costs[neighbor]) {
+				field.costs[neighbor] = neighborCost;
+				queue.emplace_back(neighborCost, neighbor);
+				std::push_heap(queue.begin(), queue.end(), std::greater<>());
+			}
+		}
+	}
+	field.built = true;
+}
+
+Direction getStepDirection(int32_t offsetX, int32_t offsetY)
+{
+	if (offsetX == 0) {
+		return offsetY < 0 ? DIRECTION_NORTH : DIRECTION_SOUTH;
+	} else if (offsetY == 0) {
+		return offsetX < 0 ? DIRECTION_WEST : DIRECTION_EAST;
+	} else if (offsetY < 0) {
+		return offsetX < 0 ? DIRECTION_NORTHWEST : DIRECTION_NORTHEAST;
+	}
+	return offsetX < 0 ? DIRECTION_SOUTHWEST : DIRECTION_SOUTHEAST;
+}
+
+bool getFlowFieldPath(const Map& map, const Creature& creature, const MonsterType* monsterType,
+                      const Position& startPos, const Position& targetPos, std::vector<Direction>& dirList)
+{
+	if (startPos.getDistanceX(targetPos) >= FLOW_FIELD_RADIUS ||
+	    startPos.getDistanceY(targetPos) >= FLOW_FIELD_RADIUS) {
+		return false;
+	}
+
+	int64_t now = OTSYS_TIME();
+	if (flowFields.size() >= FLOW_FIELD_MAX_FIELDS) {
+		std::erase_if(flowFields, [now](const auto& entry) { return entry.second.expiration < now; });
+	}
+
+	FlowField& field = flowFields[{getPathCacheKey(targetPos), monsterType}];
+	if (field.expiration < now) {
+		field.expiration = now + FLOW_FIELD_DURATION;
+		field.requests = 0;
+		field.built = false;
+	}
+
+	if (!field.built) {
+		if (++field.requests < FLOW_FIELD_MIN_REQUESTS) {
+			return false;
+		}
+		buildFlowField(map, creature, targetPos, field);
+	}
+
+	// descend the field, the start itself is usually occupied by the follower and may not be part of it
+	int32_t x = startPos.x - targetPos.x + FLOW_FIELD_RADIUS;
+	int32_t y = startPos.y - targetPos.y + FLOW_FIELD_RADIUS;
+	uint32_t cost = FLOW_FIELD_UNREACHABLE;
+
+	size_t firstDir = dirList.size();
+	while (cost != 0) {
+		int32_t bestX = 0, bestY = 0;
+		uint32_t bestCost = FLOW_FIELD_UNREACHABLE;
+		for (const auto& [offsetX, offsetY] : flowFieldNeighbors) {
+			int32_t neighborX = x + offsetX;
+			int32_t neighborY = y + offsetY;
+			if (neighborX < 0 || neighborX >= FLOW_FIELD_SIDE || neighborY < 0 || neighborY >= FLOW_FIELD_SIDE) {
+				continue;
+			}
+
+			uint32_t neighborCost = field.costs[neighborY * FLOW_FIELD_SIDE + neighborX];
+			if (neighborCost < bestCost) {
+				bestX = offsetX;
+				bestY = offsetY;
+				bestCost = neighborCost;
+			}
+		}
+
+		if (bestCost >= cost) {
+			// walled off from the target
+			dirList.resize(firstDir);
+			return false;
+		}
+
+		dirList.push_back(getStepDirection(bestX, bestY));
+		x += bestX;
+		y += bestY;
+		cost = bestCost;
+	}
+
+	// same order as the paths of getPathMatching, the last step first
+	std::reverse(dirList.begin() + firstDir, dirList.end());
+	return true;
+}
+
+} // namespace
+
 static uint16_t calculateHeuristic(const Position& p1, const Position& p2)
 {
 	uint16_t dx = std::abs(p1.getX() - p2.getX());
@@ -700,13 +897,24 @@ bool Map::getPathMatching(const Creature& creature, const Position& targetPos, s
 		return false;
 	}
 
+	const MonsterType* cacheProfile = getPathCacheProfile(creature, fpp);
+	if (cacheProfile && fpp.maxTargetDist == 1 && fpp.minTargetDist <= 1 &&
+	    getFlowFieldPath(*this, creature, cacheProfile, startPos, targetPos, dirList)) {
+		return true;
+	}
+
+	if (cacheProfile && getCachedPath(cacheProfile, startPos, targetPos, fpp, dirList)) {
+		return true;
+	}
+
 	static constexpr std::array<std::pair<int, int>, 8> allNeighbors = {
 	    {{-1, 0}, {0, 1}, {1, 0}, {0, -1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}}};
 
 	bool sightClear = isSightClear(startPos, targetPos, true, true);
 
 	Position endPos;
-	AStarNodes nodes(pos.x, pos.y);
+	thread_local AStarNodes nodes;
+	nodes.reset(pos.x, pos.y, fpp.maxSearchDist != 0 ? fpp.maxSearchDist : Map::maxViewportX + Map::maxViewportY);
 
 	AStarNode* found = nullptr;
 	int32_t bestMatch = 0;
@@ -805,9 +1013,7 @@ bool Map::getPathMatching(const Creature& creature, const Position& targetPos, s
 					continue;
 				}
 
-				neighborNode->g = g;
-				neighborNode->f = newf;
-				neighborNode->parent = n;
+				nodes.updateNode(neighborNode, n, g, newf);
 			} else {
 				// Does not exist in the open/closed list, create a new node
 				if (!nodes.createNode(n, pos.x, pos.y, g, newf)) {
@@ -824,6 +1030,9 @@ bool Map::getPathMatching(const Creature& creature, const Position& targetPos, s
 		return false;
 	}
 
+	const AStarNode* endNode = found;
+	size_t firstDir = dirList.size();
+
 	int32_t prevx = endPos.getX();
 	int32_t prevy = endPos.getY();
 
@@ -859,40 +1068,130 @@ bool Map::getPathMatching(const Creature& creature, const Position& targetPos, s
 		found = found->parent;
 	}
 
+	if (cacheProfile) {
+		addCachedPath(cacheProfile, targetPos, fpp, endNode, dirList.begin() + firstDir, dirList.end());
+	}
 	return true;
 }
 
 // AStarNodes
-AStarNodes::AStarNodes(uint16_t x, uint16_t y) : nodes(), nodeMap()
+AStarNodes::AStarNodes() : openBuckets(OPEN_BUCKETS), openBits(OPEN_WORDS) { nodes.reserve(Map::nodeReserveSize); }
+
+void AStarNodes::reset(uint16_t x, uint16_t y, int32_t maxDistance)
 {
-	nodes.reserve(Map::nodeReserveSize);
-	nodeMap.reserve(Map::nodeReserveSize);
-	visited.reserve(Map::nodeReserveSize);
+	// only touch what the previous search used
+	for (const AStarNode& node : nodes) {
+		windowNodes[getWindowIndex(node.x, node.y)] = 0;
+	}
+	nodes.clear();
+
+	for (size_t word = 0; word < openWords.size(); ++word) {
+		for (uint64_t bits = openWords[word]; bits != 0; bits &= bits - 1) {
+			size_t bitsIndex = word * 64 + std::countr_zero(bits);
+			for (uint64_t buckets = openBits[bitsIndex]; buckets != 0; buckets &= buckets - 1) {
+				openBuckets[bitsIndex * 64 + std::countr_zero(buckets)].head = 0;
+			}
+			openBits[bitsIndex] = 0;
+		}
+		openWords[word] = 0;
+	}
+	openEntries.clear();
+
+	// nothing further away than the node limit can be reached anyway
+	maxDistance = std::min<int32_t>(maxDistance, Map::nodeReserveSize);
+	windowX = x - maxDistance;
+	windowY = y - maxDistance;
+	windowSide = maxDistance * 2 + 1;
+
+	size_t windowTiles = windowSide * windowSide;
+	if (windowNodes.size() < windowTiles) {
+		windowNodes.resize(windowTiles);
+	}
+	visited.assign((windowTiles + 63) / 64, 0);
+
 	createNode(nullptr, x, y, 0, 0);
 }
 
+int32_t AStarNodes::getWindowIndex(uint16_t x, uint16_t y) const
+{
+	int32_t windowOffsetX = x - windowX;
+	int32_t windowOffsetY = y - windowY;
+	if (windowOffsetX < 0 || windowOffsetX >= windowSide || windowOffsetY < 0 || windowOffsetY >= windowSide) {
+		return -1;
+	}
+	return windowOffsetY * windowSide + windowOffsetX;
+}
+
+void AStarNodes::pushOpen(const AStarNode* node)
+{
+	openEntries.push_back({0, static_cast<uint16_t>(node - nodes.data())});
+	uint32_t entry = static_cast<uint32_t>(openEntries.size());
+
+	OpenBucket& bucket = openBuckets[node->f];
+	if (bucket.head == 0) {
+		bucket.head = entry;
+	} else {
+		openEntries[bucket.tail - 1].next = entry;
+	}
+	bucket.tail = entry;
+	openBits[node->f / 64] |= uint64_t{1} << (node->f % 64);
+	openWords[node->f / 4096] |= uint64_t{1} << ((node->f / 64) % 64);
+}
+
 AStarNode* AStarNodes::createNode(AStarNode* parent, uint16_t x, uint16_t y, uint16_t g, uint16_t f)
 {
-	if (nodes.size() == Map::nodeReserveSize) {
+	if (nodes.size() == static_cast<size_t>(Map::nodeReserveSize)) {
 		return nullptr;
 	}
 
-	uint32_t key = hashCoord(x, y);
-	nodes.emplace_back(AStarNode{parent, x, y, g, f});
-	AStarNode* node = &nodes.back();
-	nodeMap[key] = node;
-	openSet.push(node);
+	int32_t index = getWindowIndex(x, y);
+	if (index < 0) {
+		return nullptr;
+	}
+
+	AStarNode* node = &nodes.emplace_back(AStarNode{parent, x, y, g, f});
+	windowNodes[index] = static_cast<uint16_t>(nodes.size());
+	pushOpen(node);
 	return node;
 }
 
+void AStarNodes::updateNode(AStarNode* node, AStarNode* parent, uint16_t g, uint16_t f)
+{
+	node->parent = parent;
+	node->g = g;
+	node->f = f;
+
+	int32_t index = getWindowIndex(node->x, node->y);
+	if ((visited[index / 64] & (uint64_t{1} << (index % 64))) == 0) {
+		// the entry with the former f is skipped once the node is visited
+		pushOpen(node);
+	}
+}
+
 AStarNode* AStarNodes::getBestNode()
 {
-	while (!openSet.empty()) {
-		AStarNode* node = openSet.top();
-		openSet.pop();
-		uint32_t key = hashCoord(node->x, node->y);
-		if (visited.find(key) == visited.end()) {
-			visited.insert(key);
+	for (size_t word = 0; word < openWords.size();) {
+		if (openWords[word] == 0) {
+			++word;
+			continue;
+		}
+
+		size_t bitsIndex = word * 64 + std::countr_zero(openWords[word]);
+		size_t f = bitsIndex * 64 + std::countr_zero(openBits[bitsIndex]);
+
+		const OpenEntry& entry = openEntries[openBuckets[f].head - 1];
+		openBuckets[f].head = entry.next;
+		if (entry.next == 0) {
+			openBits[bitsIndex] &= ~(uint64_t{1} << (f % 64));
+			if (openBits[bitsIndex] == 0) {
+				openWords[word] &= ~(uint64_t{1} << (bitsIndex % 64));
+			}
+		}
+
+		AStarNode* node = &nodes[entry.node];
+		int32_t index = getWindowIndex(node->x, node->y);
+		if ((visited[index / 64] & (uint64_t{1} << (index % 64))) == 0) {
+			visited[index / 64] |= uint64_t{1} << (index % 64);
 			return node;
 		}
 	}
@@ -901,8 +1200,11 @@ AStarNode* AStarNodes::getBestNode()
 
 AStarNode* AStarNodes::getNodeByPosition(uint16_t x, uint16_t y)
 {
-	auto it = nodeMap.find(hashCoord(x, y));
-	return (it != nodeMap.end()) ? it->second : nullptr;
+	int32_t index = getWindowIndex(x, y);
+	if (index < 0 || windowNodes[index] == 0) {
+		return nullptr;
+	}
+	return &nodes[windowNodes[index] - 1];
 }
 
 uint16_t AStarNodes::getMapWalkCost(AStarNode* node, const Position& neighborPos)
@@ -973,7 +1275,6 @@ QTreeLeafNode* QTreeNode::createLeaf(uint32_t x, uint32_t y, uint32_t level)
 				child[index] = new QTreeNode();
 			} else {
 				child[index] = new QTreeLeafNode();
-				QTreeLeafNode::newLeaf = true;
 			}
 		}
 		return child[index]->createLeaf(x * 2, y * 2, level - 1);
@@ -982,8 +1283,6 @@ QTreeLeafNode* QTreeNode::createLeaf(uint32_t x, uint32_t y, uint32_t level)
 }
 
 // QTreeLeafNode
-bool QTreeLeafNode::newLeaf = false;
-
 QTreeLeafNode::~QTreeLeafNode()
 {
 	for (auto* ptr : array) {
@@ -999,30 +1298,6 @@ Floor* QTreeLeafNode::createFloor(uint32_t z)
 	return array[z];
 }
 
-void QTreeLeafNode::addCreature(Creature* c)
-{
-	creature_list.push_back(c);
-
-	if (c->getPlayer()) {
-		player_list.push_back(c);
-	}
-}
-
-void QTreeLeafNode::removeCreature(Creature* c)
-{
-	auto iter = std::find(creature_list.begin(), creature_list.end(), c);
-	assert(iter != creature_list.end());
-	*iter = creature_list.back();
-	creature_list.pop_back();
-
-	if (c->getPlayer()) {
-		iter = std::find(player_list.begin(), player_list.end(), c);
-		assert(iter != player_list.end());
-		*iter = player_list.back();
-		player_list.pop_back();
-	}
-}
-
 uint32_t Map::clean() const
 {
 	uint64_t start = OTSYS_TIME();
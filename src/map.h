@@ -7,12 +7,14 @@
 #include "house.h"
 #include "position.h"
 #include "spawn.h"
+#include "spectatorgrid.h"
 #include "spectators.h"
 #include "town.h"
 
 class Creature;
 
 static constexpr int32_t MAP_MAX_LAYERS = 16;
+static_assert(SpectatorGrid::MAX_LAYERS == MAP_MAX_LAYERS);
 
 static constexpr uint16_t MAP_NORMALWALKCOST = 10;
 static constexpr uint16_t MAP_DIAGONALWALKCOST = 25;
@@ -27,12 +29,30 @@ struct AStarNode
 
 inline uint32_t hashCoord(uint16_t x, uint16_t y) { return (static_cast<uint32_t>(x) << 16) | y; }
 
+/**
+ * Node storage and open list of the A* search in Map::getPathMatching, meant to be reused across searches (one
+ * instance per thread) so that nothing is allocated once the buffers reached their working size.
+ *
+ * Nodes are looked up through a table covering the square search window around the start, closed nodes are tracked
+ * in a bitmap of the same window and the open list is a bucket queue indexed by f, with a two level bitmap to find
+ * the lowest non-empty bucket.
+ */
 class AStarNodes
 {
 public:
-	AStarNodes(uint16_t x, uint16_t y);
+	AStarNodes();
+
+	// non-copyable
+	AStarNodes(const AStarNodes&) = delete;
+	AStarNodes& operator=(const AStarNodes&) = delete;
+
+	/**
+	 * Starts a new search from (x, y), nodes may only be created up to maxDistance tiles away on each axis.
+	 */
+	void reset(uint16_t x, uint16_t y, int32_t maxDistance);
 
 	AStarNode* createNode(AStarNode* parent, uint16_t x, uint16_t y, uint16_t g, uint16_t f);
+	void updateNode(AStarNode* node, AStarNode* parent, uint16_t g, uint16_t f);
 	AStarNode* getBestNode();
 	AStarNode* getNodeByPosition(uint16_t x, uint16_t y);
 
@@ -40,22 +60,50 @@ public:
 	static uint16_t getTileWalkCost(const Creature& creature, const Tile* tile);
 
 private:
-	std::vector<AStarNode> nodes;
-	std::unordered_map<uint32_t, AStarNode*> nodeMap;
-	std::unordered_set<uint32_t> visited;
+	static constexpr size_t OPEN_BUCKETS = std::numeric_limits<uint16_t>::max() + 1;
+	static constexpr size_t OPEN_WORDS = OPEN_BUCKETS / 64;
+
+	struct OpenEntry
+	{
+		uint32_t next;
+		uint16_t node;
+	};
 
-	struct NodeCompare
+	// index + 1 of the first and last entry, nodes of equal f are visited in the order they were pushed
+	struct OpenBucket
 	{
-		bool operator()(AStarNode* a, AStarNode* b) const
-		{
-			return a->f > b->f; // Min-heap based on f score
-		}
+		uint32_t head;
+		uint32_t tail;
 	};
 
-	std::priority_queue<AStarNode*, std::vector<AStarNode*>, NodeCompare> openSet;
+	int32_t getWindowIndex(uint16_t x, uint16_t y) const;
+	void pushOpen(const AStarNode* node);
+
+	std::vector<AStarNode> nodes;
+
+	int32_t windowX = 0;
+	int32_t windowY = 0;
+	int32_t windowSide = 0;
+	// index + 1 of the node of each tile of the window, 0 for none
+	std::vector<uint16_t> windowNodes;
+	std::vector<uint64_t> visited;
+
+	// singly linked entries per bucket, a node is pushed again whenever its f decreases
+	std::vector<OpenEntry> openEntries;
+	std::vector<OpenBucket> openBuckets;
+	std::vector<uint64_t> openBits;
+	std::array<uint64_t, OPEN_WORDS / 64> openWords = {};
 };
 
-using SpectatorCache = std::map<Position, SpectatorVec>;
+struct CachedSpectators
+{
+	Position centerPos;
+	uint64_t version;
+	SpectatorVec spectators;
+};
+
+// cached results are grouped by the grid cell of their center position
+using SpectatorCache = std::unordered_map<uint32_t, std::vector<CachedSpectators>>;
 
 static constexpr int32_t FLOOR_BITS = 3;
 static constexpr int32_t FLOOR_SIZE = (1 << FLOOR_BITS);
@@ -119,11 +167,7 @@ private:
 class QTreeLeafNode final : public QTreeNode
 {
 public:
-	QTreeLeafNode()
-	{
-		leaf = true;
-		newLeaf = true;
-	}
+	QTreeLeafNode() { leaf = true; }
 	~QTreeLeafNode();
 
 	// non-copyable
@@ -133,16 +177,8 @@ public:
 	Floor* createFloor(uint32_t z);
 	Floor* getFloor(uint8_t z) const { return array[z]; }
 
-	void addCreature(Creature* c);
-	void removeCreature(Creature* c);
-
 private:
-	static bool newLeaf;
-	QTreeLeafNode* leafS = nullptr;
-	QTreeLeafNode* leafE = nullptr;
 	Floor* array[MAP_MAX_LAYERS] = {};
-	CreatureVector creature_list;
-	CreatureVector player_list;
 
 	friend class Map;
 	friend class QTreeNode;
@@ -170,12 +206,6 @@ public:
 	 */
 	bool loadMap(const std::string& identifier, bool loadHouses, bool isCalledByLua = true);
 
-	/**
-	 * Save a map.
-	 * \returns true if the map was saved successfully
-	 */
-	static bool save();
-
 	/**
 	 * Get a single tile.
 	 * \returns A pointer to that tile.
@@ -212,9 +242,6 @@ public:
 	                   bool onlyPlayers = false, int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0,
 	                   int32_t maxRangeY = 0);
 
-	void clearSpectatorCache();
-	void clearPlayersSpectatorCache();
-
 	/**
 	 * Checks if you can throw an object to that position
 	 *	\param fromPos from Source point
@@ -254,10 +281,7 @@ public:
 
 	std::map<std::string, Position> waypoints;
 
-	QTreeLeafNode* getQTNode(uint16_t x, uint16_t y)
-	{
-		return QTreeNode::getLeafStatic<QTreeLeafNode*, QTreeNode*>(&root, x, y);
-	}
+	SpectatorGrid& getSpectatorGrid() { return spectatorGrid; }
 
 	Spawns spawns;
 	Towns towns;
@@ -268,6 +292,7 @@ private:
 	SpectatorCache playersSpectatorCache;
 
 	QTreeNode root;
+	SpectatorGrid spectatorGrid;
 
 	std::filesystem::path spawnfile;
 	std::filesystem::path housefile;
@@ -275,6 +300,10 @@ private:
 	uint32_t width = 0;
 	uint32_t height = 0;
 
+	const SpectatorVec* getCachedSpectators(SpectatorCache& cache, const Position& centerPos, int32_t minRangeZ,
+	                                        int32_t maxRangeZ);
+	void cacheSpectators(SpectatorCache& cache, const Position& centerPos, const SpectatorVec& spectators);
+
 	// Actually scans the map for spectators
 	void getSpectatorsInternal(SpectatorVec& spectators, const Position& centerPos, int32_t minRangeX,
 	                           int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ,
@@ -0,0 +1,212 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "messagepool.h"
+
+namespace {
+
+using tfs::net::MESSAGE_POOL_BLOCK_SIZES;
+
+constexpr size_t SIZE_CLASSES = MESSAGE_POOL_BLOCK_SIZES.size();
+
+// blocks moved between a thread cache and the shared list at once, a thread caches up to twice as many
+constexpr std::array<size_t, SIZE_CLASSES> BATCH_SIZES = {64, 32, 16, 8, 4};
+
+// the shared lists are trimmed down to the peak demand of the current and the previous window
+constexpr auto TRIM_WINDOW = std::chrono::minutes(1);
+
+struct SizeClass
+{
+	// the thread caches of the main thread are destroyed before this, so every free block is in the list by now
+	~SizeClass()
+	{
+		for (void* block : blocks) {
+			::operator delete(block);
+		}
+	}
+
+	std::mutex lock;
+	std::vector<void*> blocks;
+
+	std::atomic<uint64_t> hits{0};
+	std::atomic<uint64_t> misses{0};
+	std::atomic<size_t> inUse{0};
+	std::atomic<size_t> highWater{0};
+	std::atomic<size_t> windowHighWater{0};
+
+	// guarded by lock
+	size_t previousWindowHighWater = 0;
+	std::chrono::steady_clock::time_point windowStart = std::chrono::steady_clock::now();
+};
+
+void raiseHighWater(std::atomic<size_t>& highWater, size_t inUse)
+{
+	size_t current = highWater.load(std::memory_order_relaxed);
+	while (inUse > current && !highWater.compare_exchange_weak(current, inUse, std::memory_order_relaxed)) {
+	}
+}
+
+std::array<SizeClass, SIZE_CLASSES>& getSizeClasses()
+{
+	static std::array<SizeClass, SIZE_CLASSES> sizeClasses;
+	return sizeClasses;
+}
+
+size_t getSizeClass(size_t size)
+{
+	size_t index = 0;
+	while (index < SIZE_CLASSES && MESSAGE_POOL_BLOCK_SIZES[index] < size) {
+		++index;
+	}
+	return index;
+}
+
+/**
+ * Per-thread cache of free blocks. Messages are usually built by the dispatcher and released by the network threads
+ * once written, so whole batches travel back through the shared list instead of locking it once per message.
+ */
+class MessageBlockCache
+{
+public:
+	~MessageBlockCache()
+	{
+		for (size_t index = 0; index < SIZE_CLASSES; ++index) {
+			while (!blocks[index].empty()) {
+				releaseBatch(index);
+			}
+		}
+	}
+
+	void* allocate(size_t index)
+	{
+		auto& cached = blocks[index];
+		if (cached.empty() && !acquireBatch(index)) {
+			return nullptr;
+		}
+
+		void* block = cached.back();
+		cached.pop_back();
+		return block;
+	}
+
+	void release(size_t index, void* block)
+	{
+		auto& cached = blocks[index];
+		cached.push_back(block);
+		if (cached.size() >= BATCH_SIZES[index] * 2) {
+			releaseBatch(index);
+		}
+	}
+
+private:
+	bool acquireBatch(size_t index)
+	{
+		SizeClass& sizeClass = getSizeClasses()[index];
+		std::lock_guard<std::mutex> lockClass(sizeClass.lock);
+		if (sizeClass.blocks.empty()) {
+			return false;
+		}
+
+		auto first = sizeClass.blocks.end() - std::min(BATCH_SIZES[index], sizeClass.blocks.size());
+		blocks[index].insert(blocks[index].end(), first, sizeClass.blocks.end());
+		sizeClass.blocks.erase(first, sizeClass.blocks.end());
+		return true;
+	}
+
+	void releaseBatch(size_t index)
+	{
+		auto& cached = blocks[index];
+		auto first = cached.end() - std::min(BATCH_SIZES[index], cached.size());
+
+		SizeClass& sizeClass = getSizeClasses()[index];
+		std::vector<void*> trimmed;
+		{
+			std::lock_guard<std::mutex> lockClass(sizeClass.lock);
+			sizeClass.blocks.insert(sizeClass.blocks.end(), first, cached.end());
+
+			auto now = std::chrono::steady_clock::now();
+			size_t inUse = sizeClass.inUse.load(std::memory_order_relaxed);
+			if (now - sizeClass.windowStart >= TRIM_WINDOW) {
+				sizeClass.previousWindowHighWater =
+				    sizeClass.windowHighWater.exchange(inUse, std::memory_order_relaxed);
+				sizeClass.windowStart = now;
+			}
+
+			// enough free blocks to serve the recent peak again, what the thread caches hold is not counted
+			size_t demand = std::max(sizeClass.previousWindowHighWater,
+			                         sizeClass.windowHighWater.load(std::memory_order_relaxed));
+			size_t keep = demand > inUse ? demand - inUse : 0;
+			if (sizeClass.blocks.size() > keep) {
+				trimmed.assign(sizeClass.blocks.begin() + keep, sizeClass.blocks.end());
+				sizeClass.blocks.resize(keep);
+			}
+		}
+		cached.erase(first, cached.end());
+
+		for (void* block : trimmed) {
+			::operator delete(block);
+		}
+	}
+
+	std::array<std::vector<void*>, SIZE_CLASSES> blocks;
+};
+
+thread_local MessageBlockCache messageBlockCache;
+
+} // namespace
+
+void* tfs::net::allocate_message_block(size_t size)
+{
+	size_t index = getSizeClass(size);
+	if (index == SIZE_CLASSES) {
+		return ::operator new(size);
+	}
+
+	SizeClass& sizeClass = getSizeClasses()[index];
+	size_t inUse = sizeClass.inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+	raiseHighWater(sizeClass.highWater, inUse);
+	raiseHighWater(sizeClass.windowHighWater, inUse);
+
+	if (void* block = messageBlockCache.allocate(index)) {
+		sizeClass.hits.fetch_add(1, std::memory_order_relaxed);
+		return block;
+	}
+
+	sizeClass.misses.fetch_add(1, std::memory_order_relaxed);
+	return ::operator new(MESSAGE_POOL_BLOCK_SIZES[index]);
+}
+
+void tfs::net::release_message_block(void* block, size_t size)
+{
+	size_t index = getSizeClass(size);
+	if (index == SIZE_CLASSES) {
+		::operator delete(block);
+		return;
+	}
+
+	getSizeClasses()[index].inUse.fetch_sub(1, std::memory_order_relaxed);
+	messageBlockCache.release(index, block);
+}
+
+std::vector<tfs::net::MessagePoolStats> tfs::net::get_message_pool_stats()
+{
+	std::vector<MessagePoolStats> stats;
+	stats.reserve(SIZE_CLASSES);
+	for (size_t index = 0; index < SIZE_CLASSES; ++index) {
+		SizeClass& sizeClass = getSizeClasses()[index];
+
+		size_t cached;
+		{
+			std::lock_guard<std::mutex> lockClass(sizeClass.lock);
+			cached = sizeClass.blocks.size();
+		}
+
+		stats.push_back({MESSAGE_POOL_BLOCK_SIZES[index], sizeClass.hits.load(std::memory_order_relaxed),
+		                 sizeClass.misses.load(std::memory_order_relaxed),
+		                 sizeClass.inUse.load(std::memory_order_relaxed),
+		                 sizeClass.highWater.load(std::memory_order_relaxed), cached});
+	}
+	return stats;
+}
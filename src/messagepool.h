@@ -0,0 +1,62 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_MESSAGEPOOL_H
+#define FS_MESSAGEPOOL_H
+
+#include "const.h"
+
+namespace tfs::net {
+
+// large enough for a NetworkMessage, or an OutputMessage together with its shared_ptr control block
+static constexpr size_t MESSAGE_BLOCK_SIZE = NETWORKMESSAGE_MAXSIZE + 256;
+
+// the smaller classes hold the encoded packets waiting to be written
+static constexpr std::array<size_t, 5> MESSAGE_POOL_BLOCK_SIZES = {256, 1024, 4096, 8192, MESSAGE_BLOCK_SIZE};
+
+struct MessagePoolStats
+{
+	size_t blockSize;
+	uint64_t hits;
+	uint64_t misses;
+	size_t inUse;
+	size_t highWater;
+	size_t cached;
+};
+
+/**
+ * Buffers of incoming and outgoing messages, in the smallest size class holding size bytes. Every thread keeps a few
+ * free blocks of each class and exchanges them with a shared list in batches. The shared list keeps enough blocks to
+ * serve the peak demand of the last minute or two again, so the pool follows the load instead of either overflowing
+ * into the global heap or holding on to an old peak. Sizes above the largest class are not pooled.
+ */
+void* allocate_message_block(size_t size);
+void release_message_block(void* block, size_t size);
+
+std::vector<MessagePoolStats> get_message_pool_stats();
+
+template <typename T>
+class MessagePoolAllocator
+{
+public:
+	using value_type = T;
+
+	MessagePoolAllocator() = default;
+
+	template <typename U>
+	constexpr MessagePoolAllocator(const MessagePoolAllocator<U>&) noexcept
+	{}
+
+	T* allocate(size_t n) const { return static_cast<T*>(allocate_message_block(n * sizeof(T))); }
+	void deallocate(T* p, size_t n) const { release_message_block(p, n * sizeof(T)); }
+
+	template <typename U>
+	bool operator==(const MessagePoolAllocator<U>&) const noexcept
+	{
+		return true;
+	}
+};
+
+} // namespace tfs::net
+
+#endif // FS_MESSAGEPOOL_H
@@ -495,14 +495,43 @@ void Monster::onCreatureLeave(Creature* creature)
 	}
 }
 
+void Monster::prepareTargetSearch()
+{
+	targetCandidates.clear();
+	targetCandidatesPos = getPosition();
+	targetCandidatesCycle = g_dispatcher.getDispatcherCycle();
+
+	for (Creature* creature : targetList) {
+		if (isTarget(creature)) {
+			targetCandidates.push_back(
+			    {creature, creature->getPosition(), canUseAttack(targetCandidatesPos, creature)});
+		}
+	}
+}
+
 bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAULT*/)
 {
 	std::list<Creature*> resultList;
 	const Position& myPos = getPosition();
 
+	// the sight checks prepared during this task are reused for the targets that have not moved since, the target list
+	// may have changed meanwhile so anything else is checked again
+	const bool prepared = targetCandidatesCycle == g_dispatcher.getDispatcherCycle() && targetCandidatesPos == myPos;
+	auto checkAttack = [&](Creature* creature) {
+		if (prepared) {
+			auto it = std::find_if(targetCandidates.begin(), targetCandidates.end(), [creature](const auto& candidate) {
+				return candidate.creature == creature;
+			});
+			if (it != targetCandidates.end() && it->position == creature->getPosition()) {
+				return it->canUseAttack;
+			}
+		}
+		return canUseAttack(myPos, creature);
+	};
+
 	for (Creature* creature : targetList) {
 		if (followCreature != creature && isTarget(creature)) {
-			if (searchType == TARGETSEARCH_RANDOM || canUseAttack(myPos, creature)) {
+			if (searchType == TARGETSEARCH_RANDOM || checkAttack(creature)) {
 				resultList.push_back(creature);
 			}
 		}
@@ -711,7 +740,7 @@ void Monster::setIdle(bool idle)
 		onIdleStatus();
 		clearTargetList();
 		clearFriendList();
-		Game::removeCreatureCheck(this);
+		g_game.removeCreatureCheck(this);
 	}
 }
 
@@ -1091,7 +1120,7 @@ void Monster::onWalk()
 
 	if ((attackedCreature || followCreature) && isFleeing()) {
 		if (lastPathUpdate < OTSYS_TIME()) {
-			g_dispatcher.addTask(createTask([id = getID()]() { g_game.updateCreatureWalk(id); }));
+			g_dispatcher.addTask([id = getID()]() { g_game.updateCreatureWalk(id); });
 			lastPathUpdate = OTSYS_TIME() + getNumber(ConfigManager::PATHFINDING_DELAY);
 		}
 	}
@@ -111,9 +111,16 @@ public:
 	void doAttacking(uint32_t interval) override;
 	bool hasExtraSwing() override { return lastMeleeAttack == 0; }
 
+	/**
+	 * Checks which creatures of the target list are valid targets and in attack range ahead of onThink. It only reads
+	 * shared state, so the monsters of a think pass may be prepared in parallel; searchTarget reuses the result for
+	 * the rest of the dispatcher task as long as the monster does not move.
+	 */
+	void prepareTargetSearch();
 	bool searchTarget(TargetSearchType_t searchType = TARGETSEARCH_DEFAULT);
 	bool selectTarget(Creature* creature);
 
+	const MonsterType* getMonsterType() const { return mType; }
 	const CreatureList& getTargetList() const { return targetList; }
 	const CreatureHashSet& getFriendList() const { return friendList; }
 
@@ -137,7 +144,15 @@ public:
 	static uint32_t monsterAutoID;
 
 private:
+	struct TargetCandidate
+	{
+		Creature* creature;
+		Position position;
+		bool canUseAttack;
+	};
+
 	CreatureHashSet friendList;
+	std::vector<TargetCandidate> targetCandidates;
 	CreatureList targetList;
 	MonsterIconHashMap monsterIcons;
 
@@ -148,6 +163,7 @@ private:
 	Spawn* spawn = nullptr;
 
 	int64_t lastMeleeAttack = 0;
+	uint64_t targetCandidatesCycle = 0;
 
 	uint32_t attackTicks = 0;
 	uint32_t targetChangeTicks = 0;
@@ -160,6 +176,7 @@ private:
 	int32_t stepDuration = 0;
 
 	Position masterPos;
+	Position targetCandidatesPos;
 
 	bool ignoreFieldDamage = false;
 	bool isIdle = true;
@@ -5,6 +5,7 @@
 #define FS_NETWORKMESSAGE_H
 
 #include "const.h"
+#include "messagepool.h"
 
 class Item;
 struct Position;
@@ -44,6 +45,10 @@ public:
 
 	NetworkMessage() = default;
 
+	// heap allocated messages (received packets, Lua messages) come from the message pool
+	static void* operator new(size_t size) { return tfs::net::allocate_message_block(size); }
+	static void operator delete(void* p, size_t size) { tfs::net::release_message_block(p, size); }
+
 	void reset() { info = {}; }
 
 	// simply read functions for incoming message
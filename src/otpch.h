@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <bitset>
 #include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
@@ -210,6 +210,11 @@ void mainLoader(ServiceManager* services)
 		return;
 	}
 
+	if (int32_t workers = getNumber(ConfigManager::DISPATCHER_WORKERS); workers > 0) {
+		std::cout << ">> Starting " << workers << " dispatcher workers" << std::endl;
+		g_dispatcher.startWorkers(workers);
+	}
+
 	std::cout << ">> Initializing gamestate" << std::endl;
 	g_game.setGameState(GAME_STATE_INIT);
 
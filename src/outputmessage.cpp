@@ -5,7 +5,7 @@
 
 #include "outputmessage.h"
 
-#include "lockfree.h"
+#include "messagepool.h"
 #include "protocol.h"
 #include "scheduler.h"
 
@@ -13,9 +13,11 @@ extern Scheduler g_scheduler;
 
 namespace {
 
-const uint16_t OUTPUTMESSAGE_FREE_LIST_CAPACITY = 2048;
 const std::chrono::milliseconds OUTPUTMESSAGE_AUTOSEND_DELAY{10};
 
+// the shared_ptr control block is allocated along with the message
+static_assert(sizeof(OutputMessage) + 64 <= tfs::net::MESSAGE_BLOCK_SIZE);
+
 // NOTE: A vector is used here because this container is mostly read and relatively rarely modified (only when a
 // client connects/disconnects)
 std::vector<Protocol_ptr> bufferedProtocols;
@@ -46,9 +48,7 @@ void sendAll(const std::vector<Protocol_ptr>& bufferedProtocols)
 
 OutputMessage_ptr tfs::net::make_output_message()
 {
-	// LockfreePoolingAllocator<void,...> will leave (void* allocate) ill-formed because of sizeof(T), so this
-	// guarantees that only one list will be initialized
-	return std::allocate_shared<OutputMessage>(LockfreePoolingAllocator<void, OUTPUTMESSAGE_FREE_LIST_CAPACITY>());
+	return std::allocate_shared<OutputMessage>(MessagePoolAllocator<OutputMessage>());
 }
 
 void tfs::net::insert_protocol_to_autosend(const Protocol_ptr& protocol)
@@ -0,0 +1,157 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "packetratelimiter.h"
+
+namespace {
+
+constexpr int64_t TOKEN = 1000;
+
+// several times what a player clicks or a client sends on its own, so only floods are dropped and never a window the
+// player asked for; the total is still capped by maxPacketsPerSecond
+constexpr std::array<PacketRateLimiter::Rate, PACKET_RATE_LAST> rates = {{
+    {0, 0},   // PACKET_RATE_UNLIMITED
+    {20, 20}, // PACKET_RATE_WALK
+    {10, 10}, // PACKET_RATE_TURN
+    {20, 40}, // PACKET_RATE_ACTION
+    {20, 40}, // PACKET_RATE_LOOK
+    {10, 20}, // PACKET_RATE_TALK
+    {10, 30}, // PACKET_RATE_HEAVY
+    {20, 40}, // PACKET_RATE_EXTENDED
+}};
+
+} // namespace
+
+PacketRateClass_t PacketRateLimiter::getRateClass(uint8_t opcode)
+{
+	switch (opcode) {
+		// logout, pings, closing windows and cancelling are always let through
+		case 0x0F:
+		case 0x14:
+		case 0x1D:
+		case 0x1E:
+		case 0x69:
+		case 0x7C:
+		case 0x7F:
+		case 0x80:
+		case 0x87:
+		case 0x8E:
+		case 0x99:
+		case 0x9E:
+		case 0xA0:
+		case 0xA7:
+		case 0xBE:
+		case 0xC9:
+		case 0xE7:
+		case 0xF3:
+		case 0xF4:
+			return PACKET_RATE_UNLIMITED;
+
+		case 0x64:
+		case 0x65:
+		case 0x66:
+		case 0x67:
+		case 0x68:
+		case 0x6A:
+		case 0x6B:
+		case 0x6C:
+		case 0x6D:
+			return PACKET_RATE_WALK;
+
+		case 0x6F:
+		case 0x70:
+		case 0x71:
+		case 0x72:
+			return PACKET_RATE_TURN;
+
+		case 0x77:
+		case 0x78:
+		case 0x82:
+		case 0x83:
+		case 0x84:
+		case 0x85:
+		case 0x86:
+		case 0x88:
+		case 0x8B:
+		case 0xA1:
+		case 0xA2:
+		case 0xCA:
+		case 0xCB:
+		case 0xCC:
+			return PACKET_RATE_ACTION;
+
+		case 0x79:
+		case 0x7E:
+		case 0x8C:
+		case 0x8D:
+			return PACKET_RATE_LOOK;
+
+		case 0x96:
+		case 0x97:
+		case 0x98:
+		case 0x9A:
+		case 0xAA:
+		case 0xAB:
+		case 0xAC:
+			return PACKET_RATE_TALK;
+
+		// trading, parties, outfits, VIPs, reports and the market touch the database or many players
+		case 0x7A:
+		case 0x7B:
+		case 0x7D:
+		case 0x89:
+		case 0x8A:
+		case 0xA3:
+		case 0xA4:
+		case 0xA5:
+		case 0xA6:
+		case 0xA8:
+		case 0xD2:
+		case 0xD3:
+		case 0xDC:
+		case 0xDD:
+		case 0xDE:
+		case 0xE8:
+		case 0xF2:
+		case 0xF5:
+		case 0xF6:
+		case 0xF7:
+		case 0xF8:
+		case 0xF9:
+			return PACKET_RATE_HEAVY;
+
+		// extended opcodes and anything else is handled by Lua
+		default:
+			return PACKET_RATE_EXTENDED;
+	}
+}
+
+const PacketRateLimiter::Rate& PacketRateLimiter::getRate(PacketRateClass_t rateClass) { return rates[rateClass]; }
+
+bool PacketRateLimiter::allow(uint8_t opcode, int64_t now)
+{
+	PacketRateClass_t rateClass = getRateClass(opcode);
+	if (rateClass == PACKET_RATE_UNLIMITED) {
+		return true;
+	}
+
+	const Rate& rate = rates[rateClass];
+	Bucket& bucket = buckets[rateClass];
+	if (bucket.tokens < 0) {
+		bucket.tokens = rate.burst * TOKEN;
+	} else {
+		// one token per second is one thousandth of a token per millisecond
+		int64_t elapsed = std::max<int64_t>(now - bucket.lastRefill, 0);
+		bucket.tokens = std::min<int64_t>(bucket.tokens + elapsed * rate.perSecond, rate.burst * TOKEN);
+	}
+	bucket.lastRefill = now;
+
+	if (bucket.tokens < TOKEN) {
+		return false;
+	}
+
+	bucket.tokens -= TOKEN;
+	return true;
+}
@@ -0,0 +1,54 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_PACKETRATELIMITER_H
+#define FS_PACKETRATELIMITER_H
+
+enum PacketRateClass_t : uint8_t
+{
+	PACKET_RATE_UNLIMITED,
+	PACKET_RATE_WALK,
+	PACKET_RATE_TURN,
+	PACKET_RATE_ACTION,
+	PACKET_RATE_LOOK,
+	PACKET_RATE_TALK,
+	PACKET_RATE_HEAVY,
+	PACKET_RATE_EXTENDED,
+
+	PACKET_RATE_LAST /* this must be the last one */
+};
+
+/**
+ * Token buckets limiting how often each kind of client packet is passed on to the game, one bucket per rate class.
+ * Packets of the same class share the bucket, which refills continuously up to its burst size.
+ */
+class PacketRateLimiter
+{
+public:
+	struct Rate
+	{
+		uint32_t perSecond;
+		uint32_t burst;
+	};
+
+	static PacketRateClass_t getRateClass(uint8_t opcode);
+	static const Rate& getRate(PacketRateClass_t rateClass);
+
+	/**
+	 * Takes a token from the bucket of the opcode and returns whether the packet may be handled, now being the
+	 * current time in milliseconds.
+	 */
+	bool allow(uint8_t opcode, int64_t now);
+
+private:
+	struct Bucket
+	{
+		// thousandths of a token, so refilling is exact integer arithmetic
+		int64_t tokens = -1;
+		int64_t lastRefill = 0;
+	};
+
+	std::array<Bucket, PACKET_RATE_LAST> buckets;
+};
+
+#endif // FS_PACKETRATELIMITER_H
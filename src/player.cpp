@@ -1276,18 +1276,7 @@ void Player::onRemoveCreature(Creature* creature, bool isLogout)
 		}
 
 		IOLoginData::updateOnlineStatus(guid, false);
-
-		bool saved = false;
-		for (uint32_t tries = 0; tries < 3; ++tries) {
-			if (IOLoginData::savePlayer(this)) {
-				saved = true;
-				break;
-			}
-		}
-
-		if (!saved) {
-			std::cout << "Error while saving player: " << getName() << std::endl;
-		}
+		IOLoginData::savePlayerAsync(this);
 	}
 }
 
@@ -4603,6 +4592,13 @@ void Player::sendClosePrivate(uint16_t channelId)
 	}
 }
 
+void Player::setBankBalance(uint64_t balance)
+{
+	// transfers change two players, the incremental server save may have written only one of them yet
+	g_game.captureBeforeChange(this);
+	bankBalance = balance;
+}
+
 uint64_t Player::getMoney() const
 {
 	std::vector<const Container*> containers;
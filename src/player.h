@@ -21,6 +21,7 @@ struct Mount;
 class NetworkMessage;
 class Npc;
 class Party;
+struct PlayerSaveState;
 class SchedulerTask;
 
 enum skillsid_t
@@ -164,7 +165,7 @@ public:
 	void setOfflineTrainingSkill(int32_t skill) { offlineTrainingSkill = skill; }
 
 	uint64_t getBankBalance() const { return bankBalance; }
-	void setBankBalance(uint64_t balance) { bankBalance = balance; }
+	void setBankBalance(uint64_t balance);
 
 	Guild_ptr getGuild() const { return guild; }
 	void setGuild(Guild_ptr guild);
@@ -211,6 +212,15 @@ public:
 		return client->getVersion();
 	}
 
+	CompressionStats getCompressionStats() const
+	{
+		if (!client) {
+			return {};
+		}
+
+		return client->getCompressionStats();
+	}
+
 	bool hasSecureMode() const { return secureMode; }
 
 	void setParty(Party* party) { this->party = party; }
@@ -611,10 +621,10 @@ public:
 		}
 	}
 	void sendCreatureMove(const Creature* creature, const Position& newPos, int32_t newStackPos, const Position& oldPos,
-	                      int32_t oldStackPos, bool teleport)
+	                      int32_t oldStackPos, bool teleport, const NetworkMessage* step = nullptr)
 	{
 		if (client) {
-			client->sendMoveCreature(creature, newPos, newStackPos, oldPos, oldStackPos, teleport);
+			client->sendMoveCreature(creature, newPos, newStackPos, oldPos, oldStackPos, teleport, step);
 		}
 	}
 	void sendCreatureTurn(const Creature* creature)
@@ -1212,6 +1222,7 @@ private:
 	int64_t nextAction = 0;
 
 	ProtocolGame_ptr client;
+	std::shared_ptr<PlayerSaveState> saveState;
 	Connection::Address lastIP = {};
 	BedItem* bedItem = nullptr;
 	Guild_ptr guild = nullptr;
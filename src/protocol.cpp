@@ -5,12 +5,24 @@
 
 #include "protocol.h"
 
+#include "configmanager.h"
 #include "outputmessage.h"
 #include "rsa.h"
 #include "xtea.h"
 
 namespace {
 
+// smaller messages are not worth the CPU time
+constexpr uint16_t COMPRESSION_MIN_LENGTH = 128;
+
+// a message that does not shrink below 90% goes out uncompressed, and after a streak of them the connection stops
+// trying for a while, as long as it sends the same kind of data
+constexpr uint32_t COMPRESSION_POOR_STREAK = 8;
+constexpr uint32_t COMPRESSION_BACKOFF_MESSAGES = 64;
+
+// the level is reviewed against the time budget after this many compressed messages
+constexpr uint32_t COMPRESSION_LEVEL_WINDOW = 64;
+
 void XTEA_encrypt(OutputMessage& msg, const xtea::round_keys& key)
 {
 	// The message must be a multiple of 8
@@ -43,6 +55,16 @@ bool XTEA_decrypt(NetworkMessage& msg, const xtea::round_keys& key)
 
 } // namespace
 
+Protocol::Protocol(Connection_ptr connection) :
+    connection(connection), compressionLevel(std::clamp<int32_t>(getNumber(ConfigManager::COMPRESSION_LEVEL), 0, 9))
+{
+	// level 0 still needs a stream, it is never used though
+	if (deflateInit2(&zstream, std::max(compressionLevel, 1), Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		std::cout << "ZLIB initialization error: " << (zstream.msg ? zstream.msg : "unknown") << std::endl;
+	}
+	compressionCounters.level = compressionLevel;
+}
+
 Protocol::~Protocol()
 {
 	const auto zlibEndResult = deflateEnd(&zstream);
@@ -58,7 +80,7 @@ void Protocol::onSendMessage(const OutputMessage_ptr& msg)
 	if (!rawMessages) {
 		if (encryptionEnabled && checksumMode == CHECKSUM_SEQUENCE) {
 			uint32_t compressionChecksum = 0;
-			if (msg->getLength() >= 128 && deflateMessage(*msg)) {
+			if (msg->getLength() >= COMPRESSION_MIN_LENGTH && deflateMessage(*msg)) {
 				compressionChecksum = 0x80000000;
 			}
 
@@ -107,8 +129,22 @@ bool Protocol::RSA_decrypt(NetworkMessage& msg)
 
 bool Protocol::deflateMessage(OutputMessage& msg)
 {
+	if (compressionLevel == 0) {
+		return false;
+	}
+
+	const auto length = msg.getLength();
+	if (skipCompression != 0) {
+		--skipCompression;
+		compressionCounters.skippedMessages.fetch_add(1, std::memory_order_relaxed);
+		compressionCounters.bytesIn.fetch_add(length, std::memory_order_relaxed);
+		compressionCounters.bytesOut.fetch_add(length, std::memory_order_relaxed);
+		return false;
+	}
+
 	static thread_local std::vector<uint8_t> buffer(NETWORKMESSAGE_MAXSIZE);
 
+	const auto start = std::chrono::steady_clock::now();
 	zstream.next_in = msg.getOutputBuffer();
 	zstream.avail_in = msg.getLength();
 	zstream.next_out = buffer.data();
@@ -130,12 +166,73 @@ bool Protocol::deflateMessage(OutputMessage& msg)
 		return false;
 	}
 
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	windowTime += elapsed;
+	windowBytes += length;
+	if (++windowMessages == COMPRESSION_LEVEL_WINDOW) {
+		adaptCompressionLevel();
+	}
+
+	compressionCounters.time.fetch_add(elapsed.count(), std::memory_order_relaxed);
+	compressionCounters.bytesIn.fetch_add(length, std::memory_order_relaxed);
+
+	if (size * 10 >= length * 9u) {
+		if (++poorRatioStreak == COMPRESSION_POOR_STREAK) {
+			poorRatioStreak = 0;
+			skipCompression = COMPRESSION_BACKOFF_MESSAGES;
+		}
+		compressionCounters.skippedMessages.fetch_add(1, std::memory_order_relaxed);
+		compressionCounters.bytesOut.fetch_add(length, std::memory_order_relaxed);
+		return false;
+	}
+
+	poorRatioStreak = 0;
+	compressionCounters.compressedMessages.fetch_add(1, std::memory_order_relaxed);
+	compressionCounters.bytesOut.fetch_add(size, std::memory_order_relaxed);
+
 	msg.reset();
 	msg.addBytes(reinterpret_cast<const char*>(buffer.data()), size);
 
 	return true;
 }
 
+void Protocol::adaptCompressionLevel()
+{
+	// the budget is in microseconds per kilobyte, which is about nanoseconds per byte
+	const int64_t timePerByte = windowTime.count() / static_cast<int64_t>(std::max<uint64_t>(windowBytes, 1));
+	const auto budget = getNumber(ConfigManager::COMPRESSION_TIME_PER_KB);
+	const auto maxLevel = std::clamp<int32_t>(getNumber(ConfigManager::COMPRESSION_LEVEL), 1, 9);
+
+	int32_t level = compressionLevel;
+	if (level > maxLevel || (timePerByte > budget && level > 1)) {
+		--level;
+	} else if (timePerByte * 2 < budget && level < maxLevel) {
+		++level;
+	}
+
+	windowMessages = 0;
+	windowBytes = 0;
+	windowTime = {};
+
+	// the stream was just reset, so there is no pending input to flush at the old level
+	if (level != compressionLevel && deflateParams(&zstream, level, Z_DEFAULT_STRATEGY) == Z_OK) {
+		compressionLevel = level;
+		compressionCounters.level = level;
+	}
+}
+
+CompressionStats Protocol::getCompressionStats() const
+{
+	CompressionStats stats;
+	stats.compressedMessages = compressionCounters.compressedMessages.load(std::memory_order_relaxed);
+	stats.skippedMessages = compressionCounters.skippedMessages.load(std::memory_order_relaxed);
+	stats.bytesIn = compressionCounters.bytesIn.load(std::memory_order_relaxed);
+	stats.bytesOut = compressionCounters.bytesOut.load(std::memory_order_relaxed);
+	stats.time = std::chrono::nanoseconds(compressionCounters.time.load(std::memory_order_relaxed));
+	stats.level = compressionCounters.level.load(std::memory_order_relaxed);
+	return stats;
+}
+
 Connection::Address Protocol::getIP() const
 {
 	if (auto connection = getConnection()) {
@@ -9,15 +9,24 @@
 
 #include <zlib.h>
 
+/**
+ * Snapshot of the outgoing compression of a connection, the ratio is bytesOut / bytesIn over the messages that were
+ * large enough to be considered for compression.
+ */
+struct CompressionStats
+{
+	uint64_t compressedMessages = 0;
+	uint64_t skippedMessages = 0;
+	uint64_t bytesIn = 0;
+	uint64_t bytesOut = 0;
+	std::chrono::nanoseconds time{0};
+	int32_t level = 0;
+};
+
 class Protocol : public std::enable_shared_from_this<Protocol>
 {
 public:
-	explicit Protocol(Connection_ptr connection) : connection(connection)
-	{
-		if (deflateInit2(&zstream, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
-			std::cout << "ZLIB initialization error: " << (zstream.msg ? zstream.msg : "unknown") << std::endl;
-		}
-	}
+	explicit Protocol(Connection_ptr connection);
 	virtual ~Protocol();
 
 	// non-copyable
@@ -49,6 +58,8 @@ public:
 		}
 	}
 
+	CompressionStats getCompressionStats() const;
+
 	uint32_t getNextSequenceId()
 	{
 		const auto sequence = ++sequenceNumber;
@@ -76,6 +87,8 @@ protected:
 
 	bool deflateMessage(OutputMessage& msg);
 
+	void adaptCompressionLevel();
+
 	void setRawMessages(bool value) { rawMessages = value; }
 
 	virtual void release() {}
@@ -93,6 +106,25 @@ private:
 	bool rawMessages = false;
 
 	z_stream zstream{};
+
+	// adaptive compression, only touched by the strand of the connection
+	int32_t compressionLevel = 0;
+	uint32_t poorRatioStreak = 0;
+	uint32_t skipCompression = 0;
+	uint32_t windowMessages = 0;
+	uint64_t windowBytes = 0;
+	std::chrono::nanoseconds windowTime{0};
+
+	// published for the dispatcher
+	struct
+	{
+		std::atomic<uint64_t> compressedMessages{0};
+		std::atomic<uint64_t> skippedMessages{0};
+		std::atomic<uint64_t> bytesIn{0};
+		std::atomic<uint64_t> bytesOut{0};
+		std::atomic<int64_t> time{0};
+		std::atomic<int32_t> level{0};
+	} compressionCounters;
 };
 
 #endif // FS_PROTOCOL_H
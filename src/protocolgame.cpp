@@ -135,6 +135,94 @@ ClientDamageType getClientDamageType(CombatType_t combatType)
 	}
 }
 
+// serialized items of a tile, the creatures in between are added per viewer
+struct TileDescription
+{
+	uint32_t version = 0;
+	bool reusable = false;
+	uint8_t topCount = 0; // ground and top items
+	uint8_t downCount = 0;
+	uint16_t topLength = 0;
+	std::array<uint16_t, MAX_STACKPOS> downEnds;
+	std::vector<uint8_t> bytes;
+};
+
+// about 16 full map descriptions, every thread sending them keeps its own
+constexpr size_t TILE_DESCRIPTION_CACHE_SIZE = 32768;
+
+thread_local std::unordered_map<const Tile*, TileDescription> tileDescriptions;
+
+bool hasVolatileDescription(const Item* item)
+{
+	// charges, running durations, podium outfits and quiver contents change without the tile taking notice
+	const ItemType& it = Item::items[item->getID()];
+	return it.showClientCharges || it.showClientDuration || it.isPodium() ||
+	       (it.isContainer() && it.weaponType == WEAPON_QUIVER);
+}
+
+void addTileItem(NetworkMessage& msg, const Item* item, bool& reusable)
+{
+	if (hasVolatileDescription(item)) {
+		reusable = false;
+	}
+	msg.addItem(item);
+}
+
+const TileDescription& describeTile(const Tile* tile)
+{
+	auto cached = tileDescriptions.find(tile);
+	if (cached != tileDescriptions.end()) {
+		if (cached->second.reusable && cached->second.version == tile->getDescriptionVersion()) {
+			return cached->second;
+		}
+	} else {
+		if (tileDescriptions.size() >= TILE_DESCRIPTION_CACHE_SIZE) {
+			tileDescriptions.clear();
+		}
+		cached = tileDescriptions.emplace(tile, TileDescription{}).first;
+	}
+
+	TileDescription& description = cached->second;
+	description.version = tile->getDescriptionVersion();
+	description.reusable = true;
+
+	thread_local NetworkMessage msg;
+	msg.reset();
+
+	uint8_t count = 0;
+	if (const Item* ground = tile->getGround()) {
+		addTileItem(msg, ground, description.reusable);
+		++count;
+	}
+
+	const TileItemVector* items = tile->getItemList();
+	if (items) {
+		for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end && count < MAX_STACKPOS;
+		     ++it) {
+			addTileItem(msg, *it, description.reusable);
+			++count;
+		}
+	}
+
+	description.topCount = count;
+	description.topLength = msg.getLength();
+	description.downCount = 0;
+
+	// as many as could be shown when no creature is on the tile
+	if (items) {
+		for (auto it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end && count < MAX_STACKPOS;
+		     ++it) {
+			addTileItem(msg, *it, description.reusable);
+			description.downEnds[description.downCount++] = msg.getLength();
+			++count;
+		}
+	}
+
+	const uint8_t* bytes = msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION;
+	description.bytes.assign(bytes, bytes + msg.getLength());
+	return description;
+}
+
 } // namespace
 
 void ProtocolGame::release()
@@ -156,6 +244,12 @@ void ProtocolGame::login(uint32_t characterId, uint32_t accountId, OperatingSyst
 	// dispatcher thread
 	Player* foundPlayer = g_game.getPlayerByGUID(characterId);
 	if (!foundPlayer || getBoolean(ConfigManager::ALLOW_CLONES)) {
+		// the character is still being saved from its last session, try again once that is written
+		auto retry = [=, thisPtr = getThis()]() { thisPtr->login(characterId, accountId, operatingSystem); };
+		if (IOLoginData::runAfterPendingSave(characterId, std::move(retry))) {
+			return;
+		}
+
 		player = new Player(getThis());
 
 		player->incrementReferenceCounter();
@@ -500,6 +594,37 @@ void ProtocolGame::writeToOutputBuffer(const NetworkMessage& msg)
 	out->append(msg);
 }
 
+void ProtocolGame::addGameTask(uint32_t expiration, TaskFunc&& f)
+{
+	auto expiresAt = SYSTEM_TIME_ZERO;
+	if (expiration != 0) {
+		expiresAt = std::chrono::system_clock::now() + std::chrono::milliseconds(expiration);
+	}
+
+	std::lock_guard<std::mutex> lockClass(gameTaskLock);
+	gameTasks.push_back({expiresAt, std::move(f)});
+	if (gameTasks.size() == 1) {
+		// everything received until the dispatcher gets to it is taken along
+		g_dispatcher.addTask([thisPtr = getThis()]() { thisPtr->runGameTasks(); });
+	}
+}
+
+void ProtocolGame::runGameTasks()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(gameTaskLock);
+		runningGameTasks.swap(gameTasks);
+	}
+
+	auto now = std::chrono::system_clock::now();
+	for (GameTask& task : runningGameTasks) {
+		if (task.expiration == SYSTEM_TIME_ZERO || task.expiration >= now) {
+			task.func();
+		}
+	}
+	runningGameTasks.clear();
+}
+
 void ProtocolGame::parsePacket(NetworkMessage& msg)
 {
 	if (!acceptPackets || g_game.getGameState() == GAME_STATE_SHUTDOWN || msg.isEmpty()) {
@@ -528,15 +653,30 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 		}
 	}
 
+	// floods are dropped here instead of reaching the game thread
+	if (getBoolean(ConfigManager::PACKET_RATE_LIMIT) && !packetRateLimiter.allow(recvbyte, OTSYS_TIME())) {
+		// the client already moved or turned the player on its own, one queued cancel brings it back in sync
+		PacketRateClass_t rateClass = PacketRateLimiter::getRateClass(recvbyte);
+		if ((rateClass == PACKET_RATE_WALK || rateClass == PACKET_RATE_TURN) && !cancelWalkQueued.exchange(true)) {
+			addGameTask([thisPtr = getThis(), playerID = player->getID()]() {
+				thisPtr->cancelWalkQueued.store(false);
+				if (Player* player = g_game.getPlayerByID(playerID)) {
+					player->sendCancelWalk();
+				}
+			});
+		}
+		return;
+	}
+
 	switch (recvbyte) {
 		case 0x14:
-			g_dispatcher.addTask([thisPtr = getThis()]() { thisPtr->logout(true, false); });
+			addGameTask([thisPtr = getThis()]() { thisPtr->logout(true, false); });
 			break;
 		case 0x1D:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerReceivePingBack(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerReceivePingBack(playerID); });
 			break;
 		case 0x1E:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerReceivePing(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerReceivePing(playerID); });
 			break;
 		// case 0x2A: break; // bestiary tracker
 		// case 0x2C: break; // team finder (leader)
@@ -549,47 +689,47 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			parseAutoWalk(msg);
 			break;
 		case 0x65:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_NORTH); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_NORTH); });
 			break;
 		case 0x66:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_EAST); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_EAST); });
 			break;
 		case 0x67:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_SOUTH); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_SOUTH); });
 			break;
 		case 0x68:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_WEST); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_WEST); });
 			break;
 		case 0x69:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerStopAutoWalk(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerStopAutoWalk(playerID); });
 			break;
 		case 0x6A:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_NORTHEAST); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_NORTHEAST); });
 			break;
 		case 0x6B:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_SOUTHEAST); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_SOUTHEAST); });
 			break;
 		case 0x6C:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_SOUTHWEST); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_SOUTHWEST); });
 			break;
 		case 0x6D:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_NORTHWEST); });
+			addGameTask([playerID = player->getID()]() { g_game.playerMove(playerID, DIRECTION_NORTHWEST); });
 			break;
 		case 0x6F:
-			g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-			                     [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_NORTH); });
+			addGameTask(DISPATCHER_TASK_EXPIRATION,
+			            [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_NORTH); });
 			break;
 		case 0x70:
-			g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-			                     [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_EAST); });
+			addGameTask(DISPATCHER_TASK_EXPIRATION,
+			            [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_EAST); });
 			break;
 		case 0x71:
-			g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-			                     [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_SOUTH); });
+			addGameTask(DISPATCHER_TASK_EXPIRATION,
+			            [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_SOUTH); });
 			break;
 		case 0x72:
-			g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-			                     [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_WEST); });
+			addGameTask(DISPATCHER_TASK_EXPIRATION,
+			            [playerID = player->getID()]() { g_game.playerTurn(playerID, DIRECTION_WEST); });
 			break;
 		case 0x77:
 			parseEquipObject(msg);
@@ -607,7 +747,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			parsePlayerSale(msg);
 			break;
 		case 0x7C:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerCloseShop(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerCloseShop(playerID); });
 			break;
 		case 0x7D:
 			parseRequestTrade(msg);
@@ -616,10 +756,10 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			parseLookInTrade(msg);
 			break;
 		case 0x7F:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerAcceptTrade(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerAcceptTrade(playerID); });
 			break;
 		case 0x80:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerCloseTrade(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerCloseTrade(playerID); });
 			break;
 		case 0x82:
 			parseUseItem(msg);
@@ -667,7 +807,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			parseSay(msg);
 			break;
 		case 0x97:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerRequestChannels(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerRequestChannels(playerID); });
 			break;
 		case 0x98:
 			parseOpenChannel(msg);
@@ -679,7 +819,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			parseOpenPrivateChannel(msg);
 			break;
 		case 0x9E:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerCloseNpcChannel(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerCloseNpcChannel(playerID); });
 			break;
 		case 0xA0:
 			parseFightModes(msg);
@@ -703,13 +843,13 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			parsePassPartyLeadership(msg);
 			break;
 		case 0xA7:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerLeaveParty(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerLeaveParty(playerID); });
 			break;
 		case 0xA8:
 			parseEnableSharedPartyExperience(msg);
 			break;
 		case 0xAA:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerCreatePrivateChannel(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerCreatePrivateChannel(playerID); });
 			break;
 		case 0xAB:
 			parseChannelInvite(msg);
@@ -719,7 +859,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			break;
 		// case 0xB1: break; // request highscores
 		case 0xBE:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerCancelAttackAndFollow(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerCancelAttackAndFollow(playerID); });
 			break;
 		// case 0xC7: break; // request tournament leaderboard
 		case 0xC9: /* update tile */
@@ -735,7 +875,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 			break;
 		// case 0xCD: break; // request inspect window
 		case 0xD2:
-			g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerRequestOutfit(playerID); });
+			addGameTask([playerID = player->getID()]() { g_game.playerRequestOutfit(playerID); });
 			break;
 		case 0xD3:
 			parseSetOutfit(msg);
@@ -795,7 +935,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 		default:
 			// we cannot pass an unique_ptr as capture here because
 			// std::function requires the callable object to be *copyable*
-			g_dispatcher.addTask([=, playerID = player->getID(), msg = new NetworkMessage(msg)]() {
+			addGameTask([=, playerID = player->getID(), msg = new NetworkMessage(msg)]() {
 				g_game.parsePlayerNetworkMessage(playerID, recvbyte, NetworkMessage_ptr(msg));
 			});
 			break;
@@ -808,25 +948,14 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 
 void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage& msg)
 {
-	int32_t count;
-	Item* ground = tile->getGround();
-	if (ground) {
-		msg.addItem(ground);
-		count = 1;
-	} else {
-		count = 0;
+	// the items are serialized once for every viewer until the tile changes
+	const TileDescription& description = describeTile(tile);
+	const char* bytes = reinterpret_cast<const char*>(description.bytes.data());
+	if (description.topLength != 0) {
+		msg.addBytes(bytes, description.topLength);
 	}
 
-	const TileItemVector* items = tile->getItemList();
-	if (items) {
-		for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
-			msg.addItem(*it);
-
-			if (++count == MAX_STACKPOS) {
-				break;
-			}
-		}
-	}
+	int32_t count = description.topCount;
 
 	const CreatureVector* creatures = tile->getCreatures();
 	if (creatures) {
@@ -844,14 +973,9 @@ void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage& msg)
 		}
 	}
 
-	if (items && count < MAX_STACKPOS) {
-		for (auto it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
-			msg.addItem(*it);
-
-			if (++count == MAX_STACKPOS) {
-				return;
-			}
-		}
+	if (count < MAX_STACKPOS && description.downCount != 0) {
+		size_t downCount = std::min<size_t>(description.downCount, MAX_STACKPOS - count);
+		msg.addBytes(bytes + description.topLength, description.downEnds[downCount - 1] - description.topLength);
 	}
 }
 
@@ -908,36 +1032,8 @@ void ProtocolGame::GetFloorDescription(NetworkMessage& msg, int32_t x, int32_t y
 
 void ProtocolGame::checkCreatureAsKnown(uint32_t id, bool& known, uint32_t& removedKnown)
 {
-	auto result = knownCreatureSet.insert(id);
-	if (!result.second) {
-		known = true;
-		return;
-	}
-
-	known = false;
-
-	if (knownCreatureSet.size() > 1300) {
-		// Look for a creature to remove
-		for (auto it = knownCreatureSet.begin(), end = knownCreatureSet.end(); it != end; ++it) {
-			Creature* creature = g_game.getCreatureByID(*it);
-			if (!canSee(creature)) {
-				removedKnown = *it;
-				knownCreatureSet.erase(it);
-				return;
-			}
-		}
-
-		// Bad situation. Let's just remove anyone.
-		auto it = knownCreatureSet.begin();
-		if (*it == id) {
-			++it;
-		}
-
-		removedKnown = *it;
-		knownCreatureSet.erase(it);
-	} else {
-		removedKnown = 0;
-	}
+	known = knownCreatures.insert(id, removedKnown,
+	                              [this](uint32_t knownId) { return canSee(g_game.getCreatureByID(knownId)); });
 }
 
 bool ProtocolGame::canSee(const Creature* c) const
@@ -988,33 +1084,33 @@ bool ProtocolGame::canSee(int32_t x, int32_t y, int32_t z) const
 void ProtocolGame::parseChannelInvite(NetworkMessage& msg)
 {
 	auto name = msg.getString();
-	g_dispatcher.addTask(
+	addGameTask(
 	    [playerID = player->getID(), name = std::string{name}]() { g_game.playerChannelInvite(playerID, name); });
 }
 
 void ProtocolGame::parseChannelExclude(NetworkMessage& msg)
 {
 	auto name = msg.getString();
-	g_dispatcher.addTask(
+	addGameTask(
 	    [=, playerID = player->getID(), name = std::string{name}]() { g_game.playerChannelExclude(playerID, name); });
 }
 
 void ProtocolGame::parseOpenChannel(NetworkMessage& msg)
 {
 	uint16_t channelID = msg.get<uint16_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerOpenChannel(playerID, channelID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerOpenChannel(playerID, channelID); });
 }
 
 void ProtocolGame::parseCloseChannel(NetworkMessage& msg)
 {
 	uint16_t channelID = msg.get<uint16_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerCloseChannel(playerID, channelID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerCloseChannel(playerID, channelID); });
 }
 
 void ProtocolGame::parseOpenPrivateChannel(NetworkMessage& msg)
 {
 	auto receiver = msg.getString();
-	g_dispatcher.addTask([playerID = player->getID(), receiver = std::string{receiver}]() {
+	addGameTask([playerID = player->getID(), receiver = std::string{receiver}]() {
 		g_game.playerOpenPrivateChannel(playerID, receiver);
 	});
 }
@@ -1067,8 +1163,7 @@ void ProtocolGame::parseAutoWalk(NetworkMessage& msg)
 		return;
 	}
 
-	g_dispatcher.addTask(
-	    [playerID = player->getID(), path = std::move(path)]() { g_game.playerAutoWalk(playerID, path); });
+	addGameTask([playerID = player->getID(), path = std::move(path)]() { g_game.playerAutoWalk(playerID, path); });
 }
 
 void ProtocolGame::parseSetOutfit(NetworkMessage& msg)
@@ -1104,7 +1199,7 @@ void ProtocolGame::parseSetOutfit(NetworkMessage& msg)
 
 		msg.get<uint16_t>(); // familiar looktype
 		bool randomizeMount = msg.getByte() == 0x01;
-		g_dispatcher.addTask(
+		addGameTask(
 		    [=, playerID = player->getID()]() { g_game.playerChangeOutfit(playerID, newOutfit, randomizeMount); });
 
 		// Store "try outfit" window
@@ -1131,7 +1226,7 @@ void ProtocolGame::parseSetOutfit(NetworkMessage& msg)
 		bool podiumVisible = msg.getByte() == 1;
 
 		// apply to podium
-		g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+		addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 			g_game.playerEditPodium(playerID, newOutfit, pos, stackpos, spriteId, podiumVisible, direction);
 		});
 	}
@@ -1142,7 +1237,7 @@ void ProtocolGame::parseEditPodiumRequest(NetworkMessage& msg)
 	Position pos = msg.getPosition();
 	uint16_t spriteId = msg.get<uint16_t>();
 	uint8_t stackpos = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerRequestEditPodium(playerID, pos, stackpos, spriteId);
 	});
 }
@@ -1153,7 +1248,7 @@ void ProtocolGame::parseUseItem(NetworkMessage& msg)
 	uint16_t spriteId = msg.get<uint16_t>();
 	uint8_t stackpos = msg.getByte();
 	uint8_t index = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerUseItem(playerID, pos, stackpos, index, spriteId);
 	});
 }
@@ -1166,7 +1261,7 @@ void ProtocolGame::parseUseItemEx(NetworkMessage& msg)
 	Position toPos = msg.getPosition();
 	uint16_t toSpriteId = msg.get<uint16_t>();
 	uint8_t toStackPos = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerUseItemEx(playerID, fromPos, fromStackPos, fromSpriteId, toPos, toStackPos, toSpriteId);
 	});
 }
@@ -1177,7 +1272,7 @@ void ProtocolGame::parseUseWithCreature(NetworkMessage& msg)
 	uint16_t spriteId = msg.get<uint16_t>();
 	uint8_t fromStackPos = msg.getByte();
 	uint32_t creatureId = msg.get<uint32_t>();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerUseWithCreature(playerID, fromPos, fromStackPos, creatureId, spriteId);
 	});
 }
@@ -1185,19 +1280,19 @@ void ProtocolGame::parseUseWithCreature(NetworkMessage& msg)
 void ProtocolGame::parseCloseContainer(NetworkMessage& msg)
 {
 	uint8_t cid = msg.getByte();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerCloseContainer(playerID, cid); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerCloseContainer(playerID, cid); });
 }
 
 void ProtocolGame::parseUpArrowContainer(NetworkMessage& msg)
 {
 	uint8_t cid = msg.getByte();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerMoveUpContainer(playerID, cid); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerMoveUpContainer(playerID, cid); });
 }
 
 void ProtocolGame::parseUpdateContainer(NetworkMessage& msg)
 {
 	uint8_t cid = msg.getByte();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerUpdateContainer(playerID, cid); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerUpdateContainer(playerID, cid); });
 }
 
 void ProtocolGame::parseThrow(NetworkMessage& msg)
@@ -1209,7 +1304,7 @@ void ProtocolGame::parseThrow(NetworkMessage& msg)
 	uint8_t count = msg.getByte();
 
 	if (toPos != fromPos) {
-		g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+		addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 			g_game.playerMoveThing(playerID, fromPos, spriteId, fromStackpos, toPos, count);
 		});
 	}
@@ -1220,15 +1315,15 @@ void ProtocolGame::parseLookAt(NetworkMessage& msg)
 	Position pos = msg.getPosition();
 	msg.skipBytes(2); // spriteId
 	uint8_t stackpos = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-	                     [=, playerID = player->getID()]() { g_game.playerLookAt(playerID, pos, stackpos); });
+	addGameTask(DISPATCHER_TASK_EXPIRATION,
+	            [=, playerID = player->getID()]() { g_game.playerLookAt(playerID, pos, stackpos); });
 }
 
 void ProtocolGame::parseLookInBattleList(NetworkMessage& msg)
 {
 	uint32_t creatureID = msg.get<uint32_t>();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-	                     [=, playerID = player->getID()]() { g_game.playerLookInBattleList(playerID, creatureID); });
+	addGameTask(DISPATCHER_TASK_EXPIRATION,
+	            [=, playerID = player->getID()]() { g_game.playerLookInBattleList(playerID, creatureID); });
 }
 
 void ProtocolGame::parseSay(NetworkMessage& msg)
@@ -1259,7 +1354,7 @@ void ProtocolGame::parseSay(NetworkMessage& msg)
 		return;
 	}
 
-	g_dispatcher.addTask([=, playerID = player->getID(), receiver = std::string{receiver}, text = std::string{text}]() {
+	addGameTask([=, playerID = player->getID(), receiver = std::string{receiver}, text = std::string{text}]() {
 		g_game.playerSay(playerID, channelId, type, receiver, text);
 	});
 }
@@ -1280,7 +1375,7 @@ void ProtocolGame::parseFightModes(NetworkMessage& msg)
 		fightMode = FIGHTMODE_DEFENSE;
 	}
 
-	g_dispatcher.addTask([=, playerID = player->getID()]() {
+	addGameTask([=, playerID = player->getID()]() {
 		g_game.playerSetFightModes(playerID, fightMode, rawChaseMode != 0, rawSecureMode != 0);
 	});
 }
@@ -1289,14 +1384,14 @@ void ProtocolGame::parseAttack(NetworkMessage& msg)
 {
 	uint32_t creatureID = msg.get<uint32_t>();
 	// msg.get<uint32_t>(); creatureID (same as above)
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerSetAttackedCreature(playerID, creatureID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerSetAttackedCreature(playerID, creatureID); });
 }
 
 void ProtocolGame::parseFollow(NetworkMessage& msg)
 {
 	uint32_t creatureID = msg.get<uint32_t>();
 	// msg.get<uint32_t>(); creatureID (same as above)
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerFollowCreature(playerID, creatureID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerFollowCreature(playerID, creatureID); });
 }
 
 void ProtocolGame::parseEquipObject(NetworkMessage& msg)
@@ -1305,15 +1400,15 @@ void ProtocolGame::parseEquipObject(NetworkMessage& msg)
 	uint16_t spriteID = msg.get<uint16_t>();
 	// msg.get<uint8_t>(); // bool smartMode (?)
 
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-	                     [=, playerID = player->getID()]() { g_game.playerEquipItem(playerID, spriteID); });
+	addGameTask(DISPATCHER_TASK_EXPIRATION,
+	            [=, playerID = player->getID()]() { g_game.playerEquipItem(playerID, spriteID); });
 }
 
 void ProtocolGame::parseTextWindow(NetworkMessage& msg)
 {
 	uint32_t windowTextID = msg.get<uint32_t>();
 	auto newText = msg.getString();
-	g_dispatcher.addTask([playerID = player->getID(), windowTextID, newText]() {
+	addGameTask([playerID = player->getID(), windowTextID, newText]() {
 		g_game.playerWriteItem(playerID, windowTextID, newText);
 	});
 }
@@ -1323,7 +1418,7 @@ void ProtocolGame::parseHouseWindow(NetworkMessage& msg)
 	uint8_t doorId = msg.getByte();
 	uint32_t id = msg.get<uint32_t>();
 	auto text = msg.getString();
-	g_dispatcher.addTask([=, playerID = player->getID(), text = std::string{text}]() {
+	addGameTask([=, playerID = player->getID(), text = std::string{text}]() {
 		g_game.playerUpdateHouseWindow(playerID, doorId, id, text);
 	});
 }
@@ -1333,7 +1428,7 @@ void ProtocolGame::parseWrapItem(NetworkMessage& msg)
 	Position pos = msg.getPosition();
 	uint16_t spriteId = msg.get<uint16_t>();
 	uint8_t stackpos = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerWrapItem(playerID, pos, stackpos, spriteId);
 	});
 }
@@ -1342,8 +1437,8 @@ void ProtocolGame::parseLookInShop(NetworkMessage& msg)
 {
 	uint16_t id = msg.get<uint16_t>();
 	uint8_t count = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION,
-	                     [=, playerID = player->getID()]() { g_game.playerLookInShop(playerID, id, count); });
+	addGameTask(DISPATCHER_TASK_EXPIRATION,
+	            [=, playerID = player->getID()]() { g_game.playerLookInShop(playerID, id, count); });
 }
 
 void ProtocolGame::parsePlayerPurchase(NetworkMessage& msg)
@@ -1353,7 +1448,7 @@ void ProtocolGame::parsePlayerPurchase(NetworkMessage& msg)
 	uint16_t amount = msg.get<uint16_t>();
 	bool ignoreCap = msg.getByte() != 0;
 	bool inBackpacks = msg.getByte() != 0;
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerPurchaseItem(playerID, id, count, amount, ignoreCap, inBackpacks);
 	});
 }
@@ -1364,7 +1459,7 @@ void ProtocolGame::parsePlayerSale(NetworkMessage& msg)
 	uint8_t count = msg.getByte();
 	uint16_t amount = msg.get<uint16_t>();
 	bool ignoreEquipped = msg.getByte() != 0;
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerSellItem(playerID, id, count, amount, ignoreEquipped);
 	});
 }
@@ -1375,7 +1470,7 @@ void ProtocolGame::parseRequestTrade(NetworkMessage& msg)
 	uint16_t spriteId = msg.get<uint16_t>();
 	uint8_t stackpos = msg.getByte();
 	uint32_t playerId = msg.get<uint32_t>();
-	g_dispatcher.addTask(
+	addGameTask(
 	    [=, playerID = player->getID()]() { g_game.playerRequestTrade(playerID, pos, stackpos, playerId, spriteId); });
 }
 
@@ -1383,7 +1478,7 @@ void ProtocolGame::parseLookInTrade(NetworkMessage& msg)
 {
 	bool counterOffer = (msg.getByte() == 0x01);
 	uint8_t index = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerLookInTrade(playerID, counterOffer, index);
 	});
 }
@@ -1391,14 +1486,14 @@ void ProtocolGame::parseLookInTrade(NetworkMessage& msg)
 void ProtocolGame::parseAddVip(NetworkMessage& msg)
 {
 	auto name = msg.getString();
-	g_dispatcher.addTask(
+	addGameTask(
 	    [playerID = player->getID(), name = std::string{name}]() { g_game.playerRequestAddVip(playerID, name); });
 }
 
 void ProtocolGame::parseRemoveVip(NetworkMessage& msg)
 {
 	uint32_t guid = msg.get<uint32_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerRequestRemoveVip(playerID, guid); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerRequestRemoveVip(playerID, guid); });
 }
 
 void ProtocolGame::parseEditVip(NetworkMessage& msg)
@@ -1407,7 +1502,7 @@ void ProtocolGame::parseEditVip(NetworkMessage& msg)
 	auto description = msg.getString();
 	uint32_t icon = std::min<uint32_t>(10, msg.get<uint32_t>()); // 10 is max icon in 9.63
 	bool notify = msg.getByte() != 0;
-	g_dispatcher.addTask([=, playerID = player->getID(), description = std::string{description}]() {
+	addGameTask([=, playerID = player->getID(), description = std::string{description}]() {
 		g_game.playerRequestEditVip(playerID, guid, description, icon, notify);
 	});
 }
@@ -1417,7 +1512,7 @@ void ProtocolGame::parseRotateItem(NetworkMessage& msg)
 	Position pos = msg.getPosition();
 	uint16_t spriteId = msg.get<uint16_t>();
 	uint8_t stackpos = msg.getByte();
-	g_dispatcher.addTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
+	addGameTask(DISPATCHER_TASK_EXPIRATION, [=, playerID = player->getID()]() {
 		g_game.playerRotateItem(playerID, pos, stackpos, spriteId);
 	});
 }
@@ -1436,8 +1531,8 @@ void ProtocolGame::parseRuleViolationReport(NetworkMessage& msg)
 		msg.get<uint32_t>(); // statement id, used to get whatever player have said, we don't log that.
 	}
 
-	g_dispatcher.addTask([=, playerID = player->getID(), targetName = std::string{targetName},
-	                      comment = std::string{comment}, translation = std::string{translation}]() {
+	addGameTask([=, playerID = player->getID(), targetName = std::string{targetName}, comment = std::string{comment},
+	             translation = std::string{translation}]() {
 		g_game.playerReportRuleViolation(playerID, targetName, reportType, reportReason, comment, translation);
 	});
 }
@@ -1454,8 +1549,8 @@ void ProtocolGame::parseDebugAssert(NetworkMessage& msg)
 	auto date = msg.getString();
 	auto description = msg.getString();
 	auto comment = msg.getString();
-	g_dispatcher.addTask([playerID = player->getID(), assertLine = std::string{assertLine}, date = std::string{date},
-	                      description = std::string{description}, comment = std::string{comment}]() {
+	addGameTask([playerID = player->getID(), assertLine = std::string{assertLine}, date = std::string{date},
+	             description = std::string{description}, comment = std::string{comment}]() {
 		g_game.playerDebugAssert(playerID, assertLine, date, description, comment);
 	});
 }
@@ -1463,49 +1558,49 @@ void ProtocolGame::parseDebugAssert(NetworkMessage& msg)
 void ProtocolGame::parseInviteToParty(NetworkMessage& msg)
 {
 	uint32_t targetID = msg.get<uint32_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerInviteToParty(playerID, targetID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerInviteToParty(playerID, targetID); });
 }
 
 void ProtocolGame::parseJoinParty(NetworkMessage& msg)
 {
 	uint32_t targetID = msg.get<uint32_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerJoinParty(playerID, targetID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerJoinParty(playerID, targetID); });
 }
 
 void ProtocolGame::parseRevokePartyInvite(NetworkMessage& msg)
 {
 	uint32_t targetID = msg.get<uint32_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerRevokePartyInvitation(playerID, targetID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerRevokePartyInvitation(playerID, targetID); });
 }
 
 void ProtocolGame::parsePassPartyLeadership(NetworkMessage& msg)
 {
 	uint32_t targetID = msg.get<uint32_t>();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerPassPartyLeadership(playerID, targetID); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerPassPartyLeadership(playerID, targetID); });
 }
 
 void ProtocolGame::parseEnableSharedPartyExperience(NetworkMessage& msg)
 {
 	bool sharedExpActive = msg.getByte() == 1;
-	g_dispatcher.addTask(
+	addGameTask(
 	    [=, playerID = player->getID()]() { g_game.playerEnableSharedPartyExperience(playerID, sharedExpActive); });
 }
 
 void ProtocolGame::parseMarketLeave()
 {
-	g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerLeaveMarket(playerID); });
+	addGameTask([playerID = player->getID()]() { g_game.playerLeaveMarket(playerID); });
 }
 
 void ProtocolGame::parseMarketBrowse(NetworkMessage& msg)
 {
 	uint8_t browseId = msg.get<uint8_t>();
 	if (browseId == MARKETREQUEST_OWN_OFFERS) {
-		g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerBrowseMarketOwnOffers(playerID); });
+		addGameTask([playerID = player->getID()]() { g_game.playerBrowseMarketOwnOffers(playerID); });
 	} else if (browseId == MARKETREQUEST_OWN_HISTORY) {
-		g_dispatcher.addTask([playerID = player->getID()]() { g_game.playerBrowseMarketOwnHistory(playerID); });
+		addGameTask([playerID = player->getID()]() { g_game.playerBrowseMarketOwnHistory(playerID); });
 	} else {
 		uint16_t spriteID = msg.get<uint16_t>();
-		g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerBrowseMarket(playerID, spriteID); });
+		addGameTask([=, playerID = player->getID()]() { g_game.playerBrowseMarket(playerID, spriteID); });
 	}
 }
 
@@ -1524,7 +1619,7 @@ void ProtocolGame::parseMarketCreateOffer(NetworkMessage& msg)
 	uint16_t amount = msg.get<uint16_t>();
 	uint64_t price = msg.get<uint64_t>();
 	bool anonymous = (msg.getByte() != 0);
-	g_dispatcher.addTask([=, playerID = player->getID()]() {
+	addGameTask([=, playerID = player->getID()]() {
 		g_game.playerCreateMarketOffer(playerID, type, spriteId, amount, price, anonymous);
 	});
 	sendStoreBalance();
@@ -1534,8 +1629,7 @@ void ProtocolGame::parseMarketCancelOffer(NetworkMessage& msg)
 {
 	uint32_t timestamp = msg.get<uint32_t>();
 	uint16_t counter = msg.get<uint16_t>();
-	g_dispatcher.addTask(
-	    [=, playerID = player->getID()]() { g_game.playerCancelMarketOffer(playerID, timestamp, counter); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerCancelMarketOffer(playerID, timestamp, counter); });
 	sendStoreBalance();
 }
 
@@ -1544,7 +1638,7 @@ void ProtocolGame::parseMarketAcceptOffer(NetworkMessage& msg)
 	uint32_t timestamp = msg.get<uint32_t>();
 	uint16_t counter = msg.get<uint16_t>();
 	uint16_t amount = msg.get<uint16_t>();
-	g_dispatcher.addTask(
+	addGameTask(
 	    [=, playerID = player->getID()]() { g_game.playerAcceptMarketOffer(playerID, timestamp, counter, amount); });
 }
 
@@ -1553,22 +1647,20 @@ void ProtocolGame::parseModalWindowAnswer(NetworkMessage& msg)
 	uint32_t id = msg.get<uint32_t>();
 	uint8_t button = msg.getByte();
 	uint8_t choice = msg.getByte();
-	g_dispatcher.addTask(
-	    [=, playerID = player->getID()]() { g_game.playerAnswerModalWindow(playerID, id, button, choice); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerAnswerModalWindow(playerID, id, button, choice); });
 }
 
 void ProtocolGame::parseBrowseField(NetworkMessage& msg)
 {
 	Position pos = msg.getPosition();
-	g_dispatcher.addTask([=, playerID = player->getID()]() { g_game.playerBrowseField(playerID, pos); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerBrowseField(playerID, pos); });
 }
 
 void ProtocolGame::parseSeekInContainer(NetworkMessage& msg)
 {
 	uint8_t containerId = msg.getByte();
 	uint16_t index = msg.get<uint16_t>();
-	g_dispatcher.addTask(
-	    [=, playerID = player->getID()]() { g_game.playerSeekInContainer(playerID, containerId, index); });
+	addGameTask([=, playerID = player->getID()]() { g_game.playerSeekInContainer(playerID, containerId, index); });
 }
 
 // Send methods
@@ -2423,29 +2515,7 @@ void ProtocolGame::sendCreatureSay(const Creature* creature, SpeakClasses type,
                                    const Position* pos /* = nullptr*/)
 {
 	NetworkMessage msg;
-	msg.addByte(0xAA);
-
-	static uint32_t statementId = 0;
-	msg.add<uint32_t>(++statementId);
-
-	msg.addString(creature->getName());
-	msg.addByte(0x00); // "(Traded)" suffix after player name
-
-	// Add level only for players
-	if (const Player* speaker = creature->getPlayer()) {
-		msg.add<uint16_t>(speaker->getLevel());
-	} else {
-		msg.add<uint16_t>(0x00);
-	}
-
-	msg.addByte(type);
-	if (pos) {
-		msg.addPosition(*pos);
-	} else {
-		msg.addPosition(creature->getPosition());
-	}
-
-	msg.addString(text);
+	AddCreatureSay(msg, creature, type, text, pos ? *pos : creature->getPosition());
 	writeToOutputBuffer(msg);
 }
 
@@ -2547,13 +2617,7 @@ void ProtocolGame::sendPingBack()
 void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, uint8_t type)
 {
 	NetworkMessage msg;
-	msg.addByte(0x83);
-	msg.addPosition(from);
-	msg.addByte(MAGIC_EFFECTS_CREATE_DISTANCEEFFECT);
-	msg.addByte(type);
-	msg.addByte(static_cast<uint8_t>(static_cast<int8_t>(static_cast<int32_t>(to.x) - static_cast<int32_t>(from.x))));
-	msg.addByte(static_cast<uint8_t>(static_cast<int8_t>(static_cast<int32_t>(to.y) - static_cast<int32_t>(from.y))));
-	msg.addByte(MAGIC_EFFECTS_END_LOOP);
+	AddDistanceShoot(msg, from, to, type);
 	writeToOutputBuffer(msg);
 }
 
@@ -2564,26 +2628,14 @@ void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 	}
 
 	NetworkMessage msg;
-	msg.addByte(0x83);
-	msg.addPosition(pos);
-	msg.addByte(MAGIC_EFFECTS_CREATE_EFFECT);
-	msg.addByte(type);
-	msg.addByte(MAGIC_EFFECTS_END_LOOP);
+	AddMagicEffect(msg, pos, type);
 	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendCreatureHealth(const Creature* creature)
 {
 	NetworkMessage msg;
-	msg.addByte(0x8C);
-	msg.add<uint32_t>(creature->getID());
-
-	if (creature->isHealthHidden()) {
-		msg.addByte(0x00);
-	} else {
-		msg.addByte(std::ceil(
-		    (static_cast<double>(creature->getHealth()) / std::max<int32_t>(creature->getMaxHealth(), 1)) * 100));
-	}
+	AddCreatureHealth(msg, creature);
 	writeToOutputBuffer(msg);
 }
 
@@ -2827,7 +2879,8 @@ void ProtocolGame::sendAddCreature(const Creature* creature, const Position& pos
 }
 
 void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& newPos, int32_t newStackPos,
-                                    const Position& oldPos, int32_t oldStackPos, bool teleport)
+                                    const Position& oldPos, int32_t oldStackPos, bool teleport,
+                                    const NetworkMessage* step /* = nullptr*/)
 {
 	if (creature == player) {
 		if (teleport) {
@@ -2838,15 +2891,7 @@ void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& ne
 			if (oldPos.z == 7 && newPos.z >= 8) {
 				RemoveTileCreature(msg, creature, oldPos, oldStackPos);
 			} else {
-				msg.addByte(0x6D);
-				if (oldStackPos < MAX_STACKPOS) {
-					msg.addPosition(oldPos);
-					msg.addByte(oldStackPos);
-				} else {
-					msg.add<uint16_t>(0xFFFF);
-					msg.add<uint32_t>(creature->getID());
-				}
-				msg.addPosition(newPos);
+				AddCreatureStep(msg, creature, oldPos, oldStackPos, newPos);
 			}
 
 			if (newPos.z > oldPos.z) {
@@ -2880,17 +2925,11 @@ void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& ne
 		if (teleport || (oldPos.z == 7 && newPos.z >= 8)) {
 			sendRemoveTileCreature(creature, oldPos, oldStackPos);
 			sendAddCreature(creature, newPos, newStackPos);
+		} else if (step) {
+			writeToOutputBuffer(*step);
 		} else {
 			NetworkMessage msg;
-			msg.addByte(0x6D);
-			if (oldStackPos < MAX_STACKPOS) {
-				msg.addPosition(oldPos);
-				msg.addByte(oldStackPos);
-			} else {
-				msg.add<uint16_t>(0xFFFF);
-				msg.add<uint32_t>(creature->getID());
-			}
-			msg.addPosition(creature->getPosition());
+			AddCreatureStep(msg, creature, oldPos, oldStackPos, creature->getPosition());
 			writeToOutputBuffer(msg);
 		}
 	} else if (canSee(oldPos)) {
@@ -3661,6 +3700,77 @@ void ProtocolGame::RemoveTileCreature(NetworkMessage& msg, const Creature* creat
 	msg.add<uint32_t>(creature->getID());
 }
 
+void ProtocolGame::AddCreatureStep(NetworkMessage& msg, const Creature* creature, const Position& oldPos,
+                                   int32_t oldStackPos, const Position& newPos)
+{
+	msg.addByte(0x6D);
+	if (oldStackPos < MAX_STACKPOS) {
+		msg.addPosition(oldPos);
+		msg.addByte(oldStackPos);
+	} else {
+		msg.add<uint16_t>(0xFFFF);
+		msg.add<uint32_t>(creature->getID());
+	}
+	msg.addPosition(newPos);
+}
+
+// broadcast
+void ProtocolGame::AddCreatureSay(NetworkMessage& msg, const Creature* creature, SpeakClasses type,
+                                  const std::string& text, const Position& pos)
+{
+	msg.addByte(0xAA);
+
+	static uint32_t statementId = 0;
+	msg.add<uint32_t>(++statementId);
+
+	msg.addString(creature->getName());
+	msg.addByte(0x00); // "(Traded)" suffix after player name
+
+	// Add level only for players
+	if (const Player* speaker = creature->getPlayer()) {
+		msg.add<uint16_t>(speaker->getLevel());
+	} else {
+		msg.add<uint16_t>(0x00);
+	}
+
+	msg.addByte(type);
+	msg.addPosition(pos);
+	msg.addString(text);
+}
+
+void ProtocolGame::AddCreatureHealth(NetworkMessage& msg, const Creature* creature)
+{
+	msg.addByte(0x8C);
+	msg.add<uint32_t>(creature->getID());
+
+	if (creature->isHealthHidden()) {
+		msg.addByte(0x00);
+	} else {
+		msg.addByte(std::ceil(
+		    (static_cast<double>(creature->getHealth()) / std::max<int32_t>(creature->getMaxHealth(), 1)) * 100));
+	}
+}
+
+void ProtocolGame::AddDistanceShoot(NetworkMessage& msg, const Position& from, const Position& to, uint8_t type)
+{
+	msg.addByte(0x83);
+	msg.addPosition(from);
+	msg.addByte(MAGIC_EFFECTS_CREATE_DISTANCEEFFECT);
+	msg.addByte(type);
+	msg.addByte(static_cast<uint8_t>(static_cast<int8_t>(static_cast<int32_t>(to.x) - static_cast<int32_t>(from.x))));
+	msg.addByte(static_cast<uint8_t>(static_cast<int8_t>(static_cast<int32_t>(to.y) - static_cast<int32_t>(from.y))));
+	msg.addByte(MAGIC_EFFECTS_END_LOOP);
+}
+
+void ProtocolGame::AddMagicEffect(NetworkMessage& msg, const Position& pos, uint8_t type)
+{
+	msg.addByte(0x83);
+	msg.addPosition(pos);
+	msg.addByte(MAGIC_EFFECTS_CREATE_EFFECT);
+	msg.addByte(type);
+	msg.addByte(MAGIC_EFFECTS_END_LOOP);
+}
+
 void ProtocolGame::MoveUpCreature(NetworkMessage& msg, const Creature* creature, const Position& newPos,
                                   const Position& oldPos)
 {
@@ -3781,7 +3891,7 @@ void ProtocolGame::parseExtendedOpcode(NetworkMessage& msg)
 	auto buffer = msg.getString();
 
 	// process additional opcodes via lua script event
-	g_dispatcher.addTask([=, playerID = player->getID(), buffer = std::string{buffer}]() {
+	addGameTask([=, playerID = player->getID(), buffer = std::string{buffer}]() {
 		g_game.parsePlayerExtendedOpcode(playerID, opcode, buffer);
 	});
 }
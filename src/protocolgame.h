@@ -6,6 +6,8 @@
 
 #include "chat.h"
 #include "creature.h"
+#include "knowncreatures.h"
+#include "packetratelimiter.h"
 #include "protocol.h"
 #include "tasks.h"
 
@@ -69,6 +71,15 @@ public:
 
 	uint16_t getVersion() const { return version; }
 
+	// packets that are the same for every spectator, so they are encoded once and the bytes sent to each of them
+	static void AddCreatureSay(NetworkMessage& msg, const Creature* creature, SpeakClasses type,
+	                           const std::string& text, const Position& pos);
+	static void AddCreatureStep(NetworkMessage& msg, const Creature* creature, const Position& oldPos,
+	                            int32_t oldStackPos, const Position& newPos);
+	static void AddCreatureHealth(NetworkMessage& msg, const Creature* creature);
+	static void AddDistanceShoot(NetworkMessage& msg, const Position& from, const Position& to, uint8_t type);
+	static void AddMagicEffect(NetworkMessage& msg, const Position& pos, uint8_t type);
+
 private:
 	ProtocolGame_ptr getThis() { return std::static_pointer_cast<ProtocolGame>(shared_from_this()); }
 	void connect(uint32_t playerId, OperatingSystem_t operatingSystem);
@@ -83,6 +94,15 @@ private:
 	bool canSee(const Creature*) const;
 	bool canSee(const Position& pos) const;
 
+	/**
+	 * Queues a task parsed from a client packet. The tasks queued until the game thread gets to them are run by a
+	 * single dispatcher task, in the order they were received; expiring ones are dropped when older than expiration
+	 * milliseconds by then.
+	 */
+	void addGameTask(TaskFunc&& f) { addGameTask(0, std::move(f)); }
+	void addGameTask(uint32_t expiration, TaskFunc&& f);
+	void runGameTasks();
+
 	// we have all the parse methods
 	void parsePacket(NetworkMessage& msg) override;
 	void onRecvFirstMessage(NetworkMessage& msg) override;
@@ -256,7 +276,7 @@ private:
 	void sendAddCreature(const Creature* creature, const Position& pos, int32_t stackpos,
 	                     MagicEffectClasses magicEffect = CONST_ME_NONE);
 	void sendMoveCreature(const Creature* creature, const Position& newPos, int32_t newStackPos, const Position& oldPos,
-	                      int32_t oldStackPos, bool teleport);
+	                      int32_t oldStackPos, bool teleport, const NetworkMessage* step = nullptr);
 
 	// containers
 	void sendAddContainerItem(uint8_t cid, uint16_t slot, const Item* item);
@@ -312,7 +332,20 @@ private:
 
 	friend class Player;
 
-	std::unordered_set<uint32_t> knownCreatureSet;
+	struct GameTask
+	{
+		std::chrono::system_clock::time_point expiration;
+		TaskFunc func;
+	};
+
+	// filled by the network thread, swapped out and run by the dispatcher thread
+	std::mutex gameTaskLock;
+	std::vector<GameTask> gameTasks;
+	std::vector<GameTask> runningGameTasks;
+
+	PacketRateLimiter packetRateLimiter;
+	std::atomic<bool> cancelWalkQueued{false};
+	KnownCreatureList knownCreatures;
 	Player* player = nullptr;
 
 	uint32_t eventConnect = 0;
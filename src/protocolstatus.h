@@ -37,6 +37,7 @@ public:
 
 private:
 	static std::map<Connection::Address, int64_t> ipConnectMap;
+	static std::mutex ipConnectMapLock;
 };
 
 #endif // FS_PROTOCOLSTATUS_H
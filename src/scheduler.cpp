@@ -5,33 +5,200 @@
 
 #include "scheduler.h"
 
-uint32_t Scheduler::addEvent(SchedulerTask* task)
+namespace {
+
+// event id layout: generation of the slot in the high bits, slot in the low bits
+constexpr uint32_t EVENT_SLOT_BITS = 20;
+constexpr uint32_t EVENT_SLOT_MASK = (1 << EVENT_SLOT_BITS) - 1;
+constexpr uint32_t EVENT_GENERATION_MAX = std::numeric_limits<uint32_t>::max() >> EVENT_SLOT_BITS;
+
+// slots are only reused once this many are free, so a stale id needs a very long time to match a new event
+constexpr size_t EVENT_MIN_FREE_SLOTS = 1 << 16;
+
+} // namespace
+
+void TimingWheel::clear()
+{
+	for (auto& level : levels) {
+		level.fill(nullptr);
+	}
+	taskCount = 0;
+}
+
+void TimingWheel::insert(SchedulerTask* task, uint64_t expiryTick)
+{
+	uint64_t maxTick = currentTick + std::numeric_limits<uint32_t>::max();
+	task->expiryTick = std::clamp(expiryTick, currentTick + 1, maxTick);
+	link(task);
+	++taskCount;
+}
+
+void TimingWheel::remove(SchedulerTask* task)
 {
-	// check if the event has a valid id
-	if (task->getEventId() == 0) {
-		task->setEventId(++lastEventId);
+	*task->wheelPrev = task->wheelNext;
+	if (task->wheelNext) {
+		task->wheelNext->wheelPrev = task->wheelPrev;
 	}
+	task->wheelPrev = nullptr;
+	task->wheelNext = nullptr;
+	--taskCount;
+}
+
+void TimingWheel::link(SchedulerTask* task)
+{
+	uint64_t delta = task->expiryTick - currentTick;
 
-	boost::asio::post(io_context, [this, task]() {
-		// insert the event id in the list of active events
-		auto it = eventIdTimerMap.emplace(task->getEventId(), boost::asio::steady_timer{io_context});
-		auto& timer = it.first->second;
+	uint32_t level = 0;
+	while (level + 1 < WHEEL_LEVELS && delta >= (uint64_t{1} << (WHEEL_BITS * (level + 1)))) {
+		++level;
+	}
 
-		timer.expires_after(std::chrono::milliseconds(task->getDelay()));
-		timer.async_wait([this, task](const boost::system::error_code& error) {
-			eventIdTimerMap.erase(task->getEventId());
+	SchedulerTask*& head = levels[level][(task->expiryTick >> (WHEEL_BITS * level)) & WHEEL_MASK];
+	task->wheelNext = head;
+	if (head) {
+		head->wheelPrev = &task->wheelNext;
+	}
+	task->wheelPrev = &head;
+	head = task;
+}
+
+void TimingWheel::cascade(uint32_t level)
+{
+	SchedulerTask* task = std::exchange(levels[level][(currentTick >> (WHEEL_BITS * level)) & WHEEL_MASK], nullptr);
+	if (!task) {
+		return;
+	}
 
-			if (error == boost::asio::error::operation_aborted || getState() == THREAD_STATE_TERMINATED) {
-				// the timer has been manually canceled(timer->cancel()) or Scheduler::shutdown has been called
-				delete task;
+	// lists are newest first, relink oldest first so tasks expiring on the same tick keep their order
+	std::vector<SchedulerTask*> tasks;
+	for (; task; task = task->wheelNext) {
+		tasks.push_back(task);
+	}
+
+	for (auto it = tasks.rbegin(), end = tasks.rend(); it != end; ++it) {
+		link(*it);
+	}
+}
+
+void TimingWheel::advance(uint64_t tick, std::vector<SchedulerTask*>& expired)
+{
+	while (currentTick < tick) {
+		if (!levels[0][(currentTick + 1) & WHEEL_MASK]) {
+			// skip the ticks where nothing expires nor cascades
+			uint64_t nextTick = getNextTick();
+			if (nextTick > tick) {
+				currentTick = tick;
 				return;
 			}
+			currentTick = nextTick - 1;
+		}
 
-			g_dispatcher.addTask(task);
-		});
-	});
+		++currentTick;
 
-	return task->getEventId();
+		for (uint32_t level = WHEEL_LEVELS - 1; level > 0; --level) {
+			if ((currentTick & ((uint64_t{1} << (WHEEL_BITS * level)) - 1)) == 0) {
+				cascade(level);
+			}
+		}
+
+		SchedulerTask* task = std::exchange(levels[0][currentTick & WHEEL_MASK], nullptr);
+		size_t first = expired.size();
+		while (task) {
+			SchedulerTask* next = task->wheelNext;
+			task->wheelPrev = nullptr;
+			task->wheelNext = nullptr;
+			expired.push_back(task);
+			--taskCount;
+			task = next;
+		}
+		std::reverse(expired.begin() + first, expired.end());
+	}
+}
+
+uint64_t TimingWheel::getNextTick() const
+{
+	uint64_t nextTick = std::numeric_limits<uint64_t>::max();
+	if (taskCount == 0) {
+		return nextTick;
+	}
+
+	// a slot of level L holds the tasks cascading (or expiring, on the first level) at one of the next WHEEL_SIZE
+	// multiples of its span, so every level only needs to be scanned once around
+	for (uint32_t level = 0; level < WHEEL_LEVELS; ++level) {
+		uint32_t shift = WHEEL_BITS * level;
+		for (uint64_t step = (currentTick >> shift) + 1, end = step + WHEEL_SIZE; step < end; ++step) {
+			if (levels[level][step & WHEEL_MASK]) {
+				nextTick = std::min(nextTick, step << shift);
+				break;
+			}
+		}
+	}
+	return nextTick;
+}
+
+uint64_t Scheduler::getTick() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint32_t Scheduler::registerEvent(SchedulerTask* task)
+{
+	uint32_t slot;
+	if (freeEventSlots.size() > EVENT_MIN_FREE_SLOTS ||
+	    (eventSlots.size() > EVENT_SLOT_MASK && !freeEventSlots.empty())) {
+		slot = freeEventSlots.front();
+		freeEventSlots.pop_front();
+	} else if (eventSlots.size() <= EVENT_SLOT_MASK) {
+		slot = eventSlots.size();
+		eventSlots.emplace_back();
+	} else {
+		return 0;
+	}
+
+	EventSlot& eventSlot = eventSlots[slot];
+	uint32_t generation = (eventSlot.eventId >> EVENT_SLOT_BITS) + 1;
+	if (generation > EVENT_GENERATION_MAX) {
+		generation = 1;
+	}
+
+	eventSlot.eventId = (generation << EVENT_SLOT_BITS) | slot;
+	eventSlot.task = task;
+	return eventSlot.eventId;
+}
+
+void Scheduler::releaseEvent(uint32_t eventId)
+{
+	uint32_t slot = eventId & EVENT_SLOT_MASK;
+	eventSlots[slot].task = nullptr;
+	freeEventSlots.push_back(slot);
+}
+
+uint32_t Scheduler::addEvent(SchedulerTask* task)
+{
+	std::unique_lock<std::mutex> eventLockUnique(eventLock);
+
+	if (getState() == THREAD_STATE_TERMINATED) {
+		eventLockUnique.unlock();
+		delete task;
+		return 0;
+	}
+
+	uint32_t eventId = registerEvent(task);
+	if (eventId == 0) {
+		eventLockUnique.unlock();
+		std::cout << "[Error - Scheduler::addEvent] Too many pending events." << std::endl;
+		delete task;
+		return 0;
+	}
+
+	task->setEventId(eventId);
+	wheel.insert(task, getTick() + task->getDelay());
+
+	// wake the scheduler thread up if it sleeps past the new event
+	if (task->getExpiryTick() < wakeUpTick) {
+		eventSignal.notify_one();
+	}
+	return eventId;
 }
 
 void Scheduler::stopEvent(uint32_t eventId)
@@ -40,26 +207,65 @@ void Scheduler::stopEvent(uint32_t eventId)
 		return;
 	}
 
-	boost::asio::post(io_context, [this, eventId]() {
+	SchedulerTask* task;
+	{
+		std::lock_guard<std::mutex> lockClass(eventLock);
+
 		// search the event id
-		auto it = eventIdTimerMap.find(eventId);
-		if (it != eventIdTimerMap.end()) {
-			it->second.cancel();
+		uint32_t slot = eventId & EVENT_SLOT_MASK;
+		if (slot >= eventSlots.size() || eventSlots[slot].eventId != eventId || !eventSlots[slot].task) {
+			return;
 		}
-	});
+
+		task = eventSlots[slot].task;
+		wheel.remove(task);
+		releaseEvent(eventId);
+	}
+	delete task;
 }
 
-void Scheduler::shutdown()
+void Scheduler::threadMain()
 {
-	setState(THREAD_STATE_TERMINATED);
-	boost::asio::post(io_context, [this]() {
-		// cancel all active timers
-		for (auto& it : eventIdTimerMap) {
-			it.second.cancel();
+	std::vector<SchedulerTask*> expiredTasks;
+	std::unique_lock<std::mutex> eventLockUnique(eventLock);
+
+	while (getState() != THREAD_STATE_TERMINATED) {
+		wheel.advance(getTick(), expiredTasks);
+
+		if (!expiredTasks.empty()) {
+			for (SchedulerTask* task : expiredTasks) {
+				releaseEvent(task->getEventId());
+			}
+
+			// hand the whole batch to the dispatcher without holding the lock
+			eventLockUnique.unlock();
+			for (SchedulerTask* task : expiredTasks) {
+				g_dispatcher.addTask(task);
+			}
+			expiredTasks.clear();
+			eventLockUnique.lock();
+			continue;
 		}
 
-		io_context.stop();
-	});
+		wakeUpTick = wheel.getNextTick();
+		if (wakeUpTick == std::numeric_limits<uint64_t>::max()) {
+			eventSignal.wait(eventLockUnique);
+		} else {
+			eventSignal.wait_until(eventLockUnique, startTime + std::chrono::milliseconds(wakeUpTick));
+		}
+	}
+
+	// Scheduler::shutdown has been called, drop the pending events
+	wheel.drain([](SchedulerTask* task) { delete task; });
+	eventSlots.clear();
+	freeEventSlots.clear();
+}
+
+void Scheduler::shutdown()
+{
+	std::lock_guard<std::mutex> lockClass(eventLock);
+	setState(THREAD_STATE_TERMINATED);
+	eventSignal.notify_one();
 }
 
 SchedulerTask* createSchedulerTask(uint32_t delay, TaskFunc&& f) { return new SchedulerTask(delay, std::move(f)); }
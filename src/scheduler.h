@@ -16,6 +16,7 @@ public:
 	uint32_t getEventId() const { return eventId; }
 
 	uint32_t getDelay() const { return delay; }
+	uint64_t getExpiryTick() const { return expiryTick; }
 
 private:
 	SchedulerTask(uint32_t delay, TaskFunc&& f) : Task(std::move(f)), delay(delay) {}
@@ -23,11 +24,89 @@ private:
 	uint32_t eventId = 0;
 	uint32_t delay = 0;
 
+	// timing wheel links, the previous link points to whatever points to this task
+	SchedulerTask** wheelPrev = nullptr;
+	SchedulerTask* wheelNext = nullptr;
+	uint64_t expiryTick = 0;
+
 	friend SchedulerTask* createSchedulerTask(uint32_t, TaskFunc&&);
+	friend class TimingWheel;
 };
 
 SchedulerTask* createSchedulerTask(uint32_t delay, TaskFunc&& f);
 
+/**
+ * Hierarchical timing wheel with a resolution of one tick (a millisecond for the scheduler).
+ *
+ * Every level has WHEEL_SIZE slots holding intrusive lists of tasks: the first level covers the next WHEEL_SIZE ticks
+ * one slot per tick, each following level covers WHEEL_SIZE times the span of the previous one, and the last level
+ * reaches 2^32 ticks ahead. Inserting and removing a task are O(1); when the current tick crosses the span of a slot of
+ * an upper level, its tasks are redistributed (cascaded) into the lower levels.
+ */
+class TimingWheel
+{
+public:
+	static constexpr uint32_t WHEEL_BITS = 8;
+	static constexpr uint32_t WHEEL_SIZE = (1 << WHEEL_BITS);
+	static constexpr uint32_t WHEEL_MASK = (WHEEL_SIZE - 1);
+	static constexpr uint32_t WHEEL_LEVELS = 4;
+
+	TimingWheel() { clear(); }
+
+	// non-copyable
+	TimingWheel(const TimingWheel&) = delete;
+	TimingWheel& operator=(const TimingWheel&) = delete;
+
+	/**
+	 * Adds a task expiring at the given tick, ticks that already passed expire on the next one.
+	 */
+	void insert(SchedulerTask* task, uint64_t expiryTick);
+	void remove(SchedulerTask* task);
+
+	/**
+	 * Moves the wheel forward up to tick and appends the tasks that expired, in order of expiration.
+	 */
+	void advance(uint64_t tick, std::vector<SchedulerTask*>& expired);
+
+	/**
+	 * Returns the first tick at which advancing can expire or cascade something, or UINT64_MAX when the wheel is empty.
+	 */
+	uint64_t getNextTick() const;
+
+	uint64_t getCurrentTick() const { return currentTick; }
+	size_t size() const { return taskCount; }
+
+	/**
+	 * Unlinks every task and hands them to the callback, the wheel is left empty.
+	 */
+	template <typename Callback>
+	void drain(Callback&& callback)
+	{
+		for (auto& level : levels) {
+			for (SchedulerTask*& slot : level) {
+				SchedulerTask* task = std::exchange(slot, nullptr);
+				while (task) {
+					SchedulerTask* next = task->wheelNext;
+					task->wheelPrev = nullptr;
+					task->wheelNext = nullptr;
+					callback(task);
+					task = next;
+				}
+			}
+		}
+		taskCount = 0;
+	}
+
+private:
+	void clear();
+	void link(SchedulerTask* task);
+	void cascade(uint32_t level);
+
+	std::array<std::array<SchedulerTask*, WHEEL_SIZE>, WHEEL_LEVELS> levels;
+	uint64_t currentTick = 0;
+	size_t taskCount = 0;
+};
+
 class Scheduler : public ThreadHolder<Scheduler>
 {
 public:
@@ -36,13 +115,29 @@ public:
 
 	void shutdown();
 
-	void threadMain() { io_context.run(); }
+	void threadMain();
 
 private:
-	std::atomic<uint32_t> lastEventId{0};
-	std::unordered_map<uint32_t, boost::asio::steady_timer> eventIdTimerMap;
-	boost::asio::io_context io_context;
-	boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work{io_context.get_executor()};
+	struct EventSlot
+	{
+		uint32_t eventId = 0;
+		SchedulerTask* task = nullptr;
+	};
+
+	uint64_t getTick() const;
+	uint32_t registerEvent(SchedulerTask* task);
+	void releaseEvent(uint32_t eventId);
+
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	std::mutex eventLock;
+	std::condition_variable eventSignal;
+	TimingWheel wheel;
+	uint64_t wakeUpTick = std::numeric_limits<uint64_t>::max();
+
+	// event ids are a slot of this table plus the generation of the slot, so they can be resolved without hashing
+	std::vector<EventSlot> eventSlots;
+	std::deque<uint32_t> freeEventSlots;
 };
 
 extern Scheduler g_scheduler;
@@ -80,7 +80,18 @@ void ServiceManager::run()
 {
 	assert(!running);
 	running = true;
+
+	// the calling thread is one of the network threads, connections are serialized by their own strands
+	std::vector<std::thread> threads;
+	for (int32_t i = 1; i < getNumber(ConfigManager::NETWORK_THREADS); ++i) {
+		threads.emplace_back([this]() { io_context.run(); });
+	}
+
 	io_context.run();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
 }
 
 void ServiceManager::stop()
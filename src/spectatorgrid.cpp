@@ -0,0 +1,220 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "spectatorgrid.h"
+
+namespace {
+
+template <typename Vec>
+void eraseCreature(Vec& entries, const Creature* creature)
+{
+	auto it =
+	    std::find_if(entries.begin(), entries.end(), [=](const auto& entry) { return entry.creature == creature; });
+	assert(it != entries.end());
+	*it = entries.back();
+	entries.pop_back();
+}
+
+template <typename Vec>
+void updateCreature(Vec& entries, const Creature* creature, const Position& pos)
+{
+	auto it =
+	    std::find_if(entries.begin(), entries.end(), [=](const auto& entry) { return entry.creature == creature; });
+	assert(it != entries.end());
+	it->x = pos.x;
+	it->y = pos.y;
+}
+
+int32_t clampCoord(int32_t value) { return std::clamp<int32_t>(value, 0, 0xFFFF); }
+
+} // namespace
+
+SpectatorGrid::SpectatorGrid()
+{
+	for (auto& floor : floors) {
+		floor.chunks.resize(CHUNKS_PER_AXIS * CHUNKS_PER_AXIS);
+	}
+	versionChunks.resize(CHUNKS_PER_AXIS * CHUNKS_PER_AXIS);
+}
+
+SpectatorGrid::Cell* SpectatorGrid::getCell(const Position& pos) const
+{
+	uint32_t cellX = pos.x >> CELL_BITS;
+	uint32_t cellY = pos.y >> CELL_BITS;
+
+	const auto& chunk = floors[pos.z].chunks[(cellY >> CHUNK_BITS) * CHUNKS_PER_AXIS + (cellX >> CHUNK_BITS)];
+	if (!chunk) {
+		return nullptr;
+	}
+	return &chunk->cells[cellY & CHUNK_MASK][cellX & CHUNK_MASK];
+}
+
+SpectatorGrid::Cell& SpectatorGrid::createCell(const Position& pos)
+{
+	uint32_t cellX = pos.x >> CELL_BITS;
+	uint32_t cellY = pos.y >> CELL_BITS;
+
+	auto& chunk = floors[pos.z].chunks[(cellY >> CHUNK_BITS) * CHUNKS_PER_AXIS + (cellX >> CHUNK_BITS)];
+	if (!chunk) {
+		chunk = std::make_unique<Chunk>();
+	}
+	return chunk->cells[cellY & CHUNK_MASK][cellX & CHUNK_MASK];
+}
+
+void SpectatorGrid::touch(const Position& pos)
+{
+	uint32_t cellX = pos.x >> CELL_BITS;
+	uint32_t cellY = pos.y >> CELL_BITS;
+
+	auto& chunk = versionChunks[(cellY >> CHUNK_BITS) * CHUNKS_PER_AXIS + (cellX >> CHUNK_BITS)];
+	if (!chunk) {
+		chunk = std::make_unique<VersionChunk>();
+	}
+	chunk->versions[cellY & CHUNK_MASK][cellX & CHUNK_MASK] = ++version;
+}
+
+bool SpectatorGrid::isUnchangedSince(uint64_t sinceVersion, int32_t minX, int32_t maxX, int32_t minY,
+                                     int32_t maxY) const
+{
+	if (sinceVersion == version) {
+		return true;
+	}
+
+	minX = clampCoord(minX);
+	maxX = clampCoord(maxX);
+	minY = clampCoord(minY);
+	maxY = clampCoord(maxY);
+
+	for (int32_t cellY = minY >> CELL_BITS, endCellY = maxY >> CELL_BITS; cellY <= endCellY; ++cellY) {
+		const auto* chunkRow = &versionChunks[(cellY >> CHUNK_BITS) * CHUNKS_PER_AXIS];
+		for (int32_t cellX = minX >> CELL_BITS, endCellX = maxX >> CELL_BITS; cellX <= endCellX; ++cellX) {
+			const auto& chunk = chunkRow[cellX >> CHUNK_BITS];
+			if (!chunk) {
+				// nothing ever changed in this chunk
+				cellX |= CHUNK_MASK;
+				continue;
+			}
+
+			if (chunk->versions[cellY & CHUNK_MASK][cellX & CHUNK_MASK] > sinceVersion) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void SpectatorGrid::addCreature(Creature* creature, const Position& pos, bool isPlayer)
+{
+	if (pos.z >= MAX_LAYERS) {
+		return;
+	}
+
+	touch(pos);
+
+	Cell& cell = createCell(pos);
+	cell.creatures.push_back({creature, pos.x, pos.y});
+	++floors[pos.z].creatureCount;
+
+	if (isPlayer) {
+		cell.players.push_back({creature, pos.x, pos.y});
+		++floors[pos.z].playerCount;
+	}
+}
+
+void SpectatorGrid::removeCreature(Creature* creature, const Position& pos, bool isPlayer)
+{
+	if (pos.z >= MAX_LAYERS) {
+		return;
+	}
+
+	touch(pos);
+
+	Cell* cell = getCell(pos);
+	assert(cell);
+
+	eraseCreature(cell->creatures, creature);
+	--floors[pos.z].creatureCount;
+
+	if (isPlayer) {
+		eraseCreature(cell->players, creature);
+		--floors[pos.z].playerCount;
+	}
+}
+
+void SpectatorGrid::moveCreature(Creature* creature, const Position& oldPos, const Position& newPos, bool isPlayer)
+{
+	if (oldPos.z == newPos.z && (oldPos.x >> CELL_BITS) == (newPos.x >> CELL_BITS) &&
+	    (oldPos.y >> CELL_BITS) == (newPos.y >> CELL_BITS)) {
+		if (newPos.z >= MAX_LAYERS) {
+			return;
+		}
+
+		// same cell, only the cached coordinates change
+		touch(newPos);
+
+		Cell* cell = getCell(newPos);
+		assert(cell);
+
+		updateCreature(cell->creatures, creature, newPos);
+		if (isPlayer) {
+			updateCreature(cell->players, creature, newPos);
+		}
+		return;
+	}
+
+	removeCreature(creature, oldPos, isPlayer);
+	addCreature(creature, newPos, isPlayer);
+}
+
+void SpectatorGrid::collect(SpectatorVec& spectators, const std::vector<Entry>& entries, int32_t minX, int32_t maxX,
+                            int32_t minY, int32_t maxY)
+{
+	for (const Entry& entry : entries) {
+		if (entry.x < minX || entry.x > maxX || entry.y < minY || entry.y > maxY) {
+			continue;
+		}
+		spectators.emplace_back(entry.creature);
+	}
+}
+
+void SpectatorGrid::getSpectators(SpectatorVec& spectators, const Position& centerPos, int32_t minRangeX,
+                                  int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ,
+                                  int32_t maxRangeZ, bool onlyPlayers) const
+{
+	minRangeZ = std::max<int32_t>(minRangeZ, 0);
+	maxRangeZ = std::min<int32_t>(maxRangeZ, MAX_LAYERS - 1);
+
+	for (int32_t z = minRangeZ; z <= maxRangeZ; ++z) {
+		const GridFloor& floor = floors[z];
+		if ((onlyPlayers ? floor.playerCount : floor.creatureCount) == 0) {
+			continue;
+		}
+
+		// floors above and below the center are seen shifted diagonally
+		int32_t offsetZ = centerPos.getZ() - z;
+		int32_t minX = clampCoord(centerPos.x + minRangeX + offsetZ);
+		int32_t maxX = clampCoord(centerPos.x + maxRangeX + offsetZ);
+		int32_t minY = clampCoord(centerPos.y + minRangeY + offsetZ);
+		int32_t maxY = clampCoord(centerPos.y + maxRangeY + offsetZ);
+		if (minX > maxX || minY > maxY) {
+			continue;
+		}
+
+		for (int32_t cellY = minY >> CELL_BITS, endCellY = maxY >> CELL_BITS; cellY <= endCellY; ++cellY) {
+			const auto* chunkRow = &floor.chunks[(cellY >> CHUNK_BITS) * CHUNKS_PER_AXIS];
+			for (int32_t cellX = minX >> CELL_BITS, endCellX = maxX >> CELL_BITS; cellX <= endCellX; ++cellX) {
+				const auto& chunk = chunkRow[cellX >> CHUNK_BITS];
+				if (!chunk) {
+					// skip the remaining cells of this chunk
+					cellX |= CHUNK_MASK;
+					continue;
+				}
+
+				const Cell& cell = chunk->cells[cellY & CHUNK_MASK][cellX & CHUNK_MASK];
+				collect(spectators, onlyPlayers ? cell.players : cell.creatures, minX, maxX, minY, maxY);
+			}
+		}
+	}
+}
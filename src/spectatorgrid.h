@@ -0,0 +1,113 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_SPECTATORGRID_H
+#define FS_SPECTATORGRID_H
+
+#include "position.h"
+#include "spectators.h"
+
+class Creature;
+
+/**
+ * Uniform grid holding the creatures of every floor, used to answer spectator queries.
+ *
+ * Each floor is split into square cells of CELL_SIZE tiles that store the creatures standing on them together with
+ * their coordinates, so a query only touches the contiguous arrays of the cells covering the requested area and never
+ * dereferences the creatures themselves. Players are additionally kept in a separate array per cell for player-only
+ * queries. Cells are grouped in lazily allocated chunks so the grid stays small on sparse maps while the lookup of any
+ * cell remains a direct index.
+ *
+ * Every change is also recorded as a version per cell column (all floors together), which lets callers validate
+ * results cached for an area without invalidating what was cached elsewhere.
+ */
+class SpectatorGrid
+{
+public:
+	static constexpr int32_t CELL_BITS = 4;
+	static constexpr int32_t CELL_SIZE = (1 << CELL_BITS);
+
+	static constexpr int32_t CHUNK_BITS = 5;
+	static constexpr int32_t CHUNK_SIZE = (1 << CHUNK_BITS);
+	static constexpr int32_t CHUNK_MASK = (CHUNK_SIZE - 1);
+
+	static constexpr int32_t CELLS_PER_AXIS = (0x10000 >> CELL_BITS);
+	static constexpr int32_t CHUNKS_PER_AXIS = (CELLS_PER_AXIS >> CHUNK_BITS);
+
+	static constexpr int32_t MAX_LAYERS = 16;
+
+	SpectatorGrid();
+
+	// non-copyable
+	SpectatorGrid(const SpectatorGrid&) = delete;
+	SpectatorGrid& operator=(const SpectatorGrid&) = delete;
+
+	void addCreature(Creature* creature, const Position& pos, bool isPlayer);
+	void removeCreature(Creature* creature, const Position& pos, bool isPlayer);
+	void moveCreature(Creature* creature, const Position& oldPos, const Position& newPos, bool isPlayer);
+
+	/**
+	 * Collects the creatures in range of centerPos, with the same semantics as Map::getSpectators: every floor between
+	 * minRangeZ and maxRangeZ is scanned with the range shifted by its distance to the center floor.
+	 */
+	void getSpectators(SpectatorVec& spectators, const Position& centerPos, int32_t minRangeX, int32_t maxRangeX,
+	                   int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ, int32_t maxRangeZ,
+	                   bool onlyPlayers) const;
+
+	/**
+	 * Returns a counter that increases every time a creature is added to, removed from or moved inside the grid.
+	 */
+	uint64_t getVersion() const { return version; }
+
+	/**
+	 * Checks that no creature was added, removed or moved on any floor of the given area after sinceVersion was
+	 * taken.
+	 */
+	bool isUnchangedSince(uint64_t sinceVersion, int32_t minX, int32_t maxX, int32_t minY, int32_t maxY) const;
+
+	size_t getCreatureCount(uint8_t z) const { return z < MAX_LAYERS ? floors[z].creatureCount : 0; }
+	size_t getPlayerCount(uint8_t z) const { return z < MAX_LAYERS ? floors[z].playerCount : 0; }
+
+private:
+	struct Entry
+	{
+		Creature* creature;
+		uint16_t x, y;
+	};
+
+	struct Cell
+	{
+		std::vector<Entry> creatures;
+		std::vector<Entry> players;
+	};
+
+	struct Chunk
+	{
+		Cell cells[CHUNK_SIZE][CHUNK_SIZE];
+	};
+
+	struct VersionChunk
+	{
+		uint64_t versions[CHUNK_SIZE][CHUNK_SIZE] = {};
+	};
+
+	struct GridFloor
+	{
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		size_t creatureCount = 0;
+		size_t playerCount = 0;
+	};
+
+	Cell* getCell(const Position& pos) const;
+	Cell& createCell(const Position& pos);
+	void touch(const Position& pos);
+
+	static void collect(SpectatorVec& spectators, const std::vector<Entry>& entries, int32_t minX, int32_t maxX,
+	                    int32_t minY, int32_t maxY);
+
+	std::array<GridFloor, MAX_LAYERS> floors;
+	std::vector<std::unique_ptr<VersionChunk>> versionChunks;
+	uint64_t version = 0;
+};
+
+#endif // FS_SPECTATORGRID_H
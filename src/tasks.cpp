@@ -16,62 +16,184 @@ Task* createTask(uint32_t expiration, TaskFunc&& f) { return new Task(expiration
 
 void Dispatcher::threadMain()
 {
-	std::vector<Task*> tmpTaskList;
-	// NOTE: second argument defer_lock is to prevent from immediate locking
-	std::unique_lock<std::mutex> taskLockUnique(taskLock, std::defer_lock);
-
 	while (getState() != THREAD_STATE_TERMINATED) {
 		// check if there are tasks waiting
-		taskLockUnique.lock();
-		if (taskList.empty()) {
-			// if the list is empty wait for signal
-			taskSignal.wait(taskLockUnique);
+		if (taskQueue.empty()) {
+			taskSlab.flush();
+			waitForTasks();
 		}
-		tmpTaskList.swap(taskList);
-		taskLockUnique.unlock();
 
-		for (Task* task : tmpTaskList) {
+		// tasks are run as they are popped, so each one is only brought into the cache once
+		while (Task* task = taskQueue.pop()) {
 			if (!task->hasExpired()) {
 				++dispatcherCycle;
 				// execute it
 				(*task)();
 			}
-			delete task;
+			releaseTask(task);
+
+			if (getState() == THREAD_STATE_TERMINATED) {
+				break;
+			}
 		}
-		tmpTaskList.clear();
+
+		if (getState() != THREAD_STATE_TERMINATED && !taskQueue.empty()) {
+			// a producer is still linking its task
+			std::this_thread::yield();
+		}
+	}
+
+	stopWorkers();
+
+	// tasks that arrived after the shutdown task
+	while (Task* task = taskQueue.pop()) {
+		releaseTask(task);
 	}
 }
 
-void Dispatcher::addTask(Task* task)
+void Dispatcher::waitForTasks()
 {
-	bool do_signal = false;
+	std::unique_lock<std::mutex> taskLockUnique(taskLock);
+	waitingForTasks.store(true);
+	if (!taskQueue.empty()) {
+		waitingForTasks.store(false);
+		return;
+	}
+	taskSignal.wait(taskLockUnique, [this]() { return !waitingForTasks.load(); });
+}
 
-	taskLock.lock();
+void Dispatcher::wakeUp()
+{
+	// the sequentially consistent exchange of the push and the store in waitForTasks make sure that either the
+	// consumer sees the task or the producer sees it waiting
+	if (waitingForTasks.load() && waitingForTasks.exchange(false)) {
+		std::lock_guard<std::mutex> lockClass(taskLock);
+		taskSignal.notify_one();
+	}
+}
+
+void Dispatcher::parallelFor(size_t count, const std::function<void(size_t, size_t)>& f)
+{
+	if (count == 0) {
+		return;
+	}
+
+	if (workers.empty()) {
+		f(0, count);
+		return;
+	}
+
+	// a few ranges per thread so an unlucky range does not leave the others waiting
+	size_t rangeCount = std::min(count, (workers.size() + 1) * 4);
+
+	std::unique_lock<std::mutex> workerLockUnique(workerLock);
+	parallelJob = &f;
+	ranges.clear();
+	nextRange = 0;
+	for (size_t i = 0; i < rangeCount; ++i) {
+		ranges.emplace_back(count * i / rangeCount, count * (i + 1) / rangeCount);
+	}
+
+	runRanges(workerLockUnique);
+	parallelJob = nullptr;
+}
+
+void Dispatcher::runRanges(std::unique_lock<std::mutex>& workerLockUnique)
+{
+	pendingRanges = ranges.size();
+	workerSignal.notify_all();
+
+	// help the workers instead of waiting idle
+	while (nextRange < ranges.size()) {
+		const Range& range = ranges[nextRange++];
+		workerLockUnique.unlock();
+		(*parallelJob)(range.first, range.second);
+		workerLockUnique.lock();
+		--pendingRanges;
+	}
+
+	workerDoneSignal.wait(workerLockUnique, [this]() { return pendingRanges == 0; });
+}
 
-	if (getState() == THREAD_STATE_RUNNING) {
-		do_signal = taskList.empty();
-		taskList.push_back(task);
-	} else {
+void Dispatcher::workerMain()
+{
+	std::unique_lock<std::mutex> workerLockUnique(workerLock);
+	while (true) {
+		workerSignal.wait(workerLockUnique, [this]() { return stoppingWorkers || nextRange < ranges.size(); });
+		if (stoppingWorkers) {
+			return;
+		}
+
+		const Range& range = ranges[nextRange++];
+		workerLockUnique.unlock();
+		(*parallelJob)(range.first, range.second);
+		workerLockUnique.lock();
+
+		if (--pendingRanges == 0) {
+			workerDoneSignal.notify_one();
+		}
+	}
+}
+
+void Dispatcher::startWorkers(size_t count)
+{
+	if (!workers.empty()) {
+		return;
+	}
+
+	stoppingWorkers = false;
+	for (size_t i = 0; i < count; ++i) {
+		workers.emplace_back(&Dispatcher::workerMain, this);
+	}
+	workersRunning.store(count != 0, std::memory_order_relaxed);
+}
+
+void Dispatcher::stopWorkers()
+{
+	workersRunning.store(false, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lockClass(workerLock);
+		stoppingWorkers = true;
+	}
+	workerSignal.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+}
+
+void Dispatcher::releaseTask(Task* task)
+{
+	if (!taskSlab.owns(task)) {
 		delete task;
+		return;
 	}
 
-	taskLock.unlock();
+	task->~Task();
+	taskSlab.release(task);
+}
 
-	// send a signal if the list was empty
-	if (do_signal) {
-		taskSignal.notify_one();
+void Dispatcher::addTask(Task* task)
+{
+	if (getState() != THREAD_STATE_RUNNING) {
+		if (taskSlab.owns(task)) {
+			// only the dispatcher thread may release slots, the slot of a task queued during shutdown is not reused
+			task->~Task();
+		} else {
+			delete task;
+		}
+		return;
 	}
+
+	taskQueue.push(task);
+	wakeUp();
 }
 
 void Dispatcher::shutdown()
 {
-	Task* task = createTask([this]() {
-		setState(THREAD_STATE_TERMINATED);
-		taskSignal.notify_one();
-	});
-
-	std::lock_guard<std::mutex> lockClass(taskLock);
-	taskList.push_back(task);
+	Task* task = createTask([this]() { setState(THREAD_STATE_TERMINATED); });
 
-	taskSignal.notify_one();
+	taskQueue.push(task);
+	wakeUp();
 }
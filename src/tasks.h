@@ -4,23 +4,40 @@
 #ifndef FS_TASKS_H
 #define FS_TASKS_H
 
+#include "lockfree.h"
 #include "thread_holder_base.h"
 
 using TaskFunc = std::function<void(void)>;
 const int DISPATCHER_TASK_EXPIRATION = 2000;
 const auto SYSTEM_TIME_ZERO = std::chrono::system_clock::time_point(std::chrono::milliseconds(0));
 
-class Task
+// callables up to this size are stored in the task itself, bigger ones are moved to the heap
+static constexpr size_t TASK_INLINE_SIZE = 72;
+
+class Task : public MpscQueueNode
 {
 public:
 	// DO NOT allocate this class on the stack
-	explicit Task(TaskFunc&& f) : func(std::move(f)) {}
-	Task(uint32_t ms, TaskFunc&& f) :
-	    expiration(std::chrono::system_clock::now() + std::chrono::milliseconds(ms)), func(std::move(f))
-	{}
+	template <typename F>
+	    requires std::invocable<std::decay_t<F>&>
+	explicit Task(F&& f)
+	{
+		store(std::forward<F>(f));
+	}
+
+	template <typename F>
+	    requires std::invocable<std::decay_t<F>&>
+	Task(uint32_t ms, F&& f) : expiration(std::chrono::system_clock::now() + std::chrono::milliseconds(ms))
+	{
+		store(std::forward<F>(f));
+	}
 
-	virtual ~Task() = default;
-	void operator()() { func(); }
+	// non-copyable
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	virtual ~Task() { destroy(storage); }
+	void operator()() { invoke(storage); }
 
 	void setDontExpire() { expiration = SYSTEM_TIME_ZERO; }
 
@@ -33,25 +50,76 @@ public:
 	}
 
 protected:
+	// Expiration has another meaning for scheduler tasks, then it is the time the task should be added to the
+	// dispatcher
 	std::chrono::system_clock::time_point expiration = SYSTEM_TIME_ZERO;
 
 private:
-	// Expiration has another meaning for scheduler tasks, then it is the time the task should be added to the
-	// dispatcher
-	TaskFunc func;
+	template <typename F>
+	void store(F&& f)
+	{
+		using Func = std::decay_t<F>;
+		if constexpr (sizeof(Func) <= TASK_INLINE_SIZE && alignof(Func) <= alignof(std::max_align_t)) {
+			new (storage) Func(std::forward<F>(f));
+			invoke = [](void* func) { (*static_cast<Func*>(func))(); };
+			destroy = [](void* func) { static_cast<Func*>(func)->~Func(); };
+		} else {
+			new (storage) Func*(new Func(std::forward<F>(f)));
+			invoke = [](void* func) { (**static_cast<Func**>(func))(); };
+			destroy = [](void* func) { delete *static_cast<Func**>(func); };
+		}
+	}
+
+	// the callable, or a pointer to it when it does not fit
+	void (*invoke)(void*);
+	void (*destroy)(void*);
+	alignas(std::max_align_t) unsigned char storage[TASK_INLINE_SIZE];
 };
 
 Task* createTask(TaskFunc&& f);
 Task* createTask(uint32_t expiration, TaskFunc&& f);
 
+// tasks queued while this many are still waiting for the dispatcher are allocated on the heap
+static constexpr size_t DISPATCHER_TASK_SLOTS = 16384;
+
 class Dispatcher : public ThreadHolder<Dispatcher>
 {
 public:
 	void addTask(Task* task);
 
-	void addTask(TaskFunc&& f) { addTask(new Task(std::move(f))); }
+	/**
+	 * Queues a task running f. The task and f are built in a slot of the task slab, which the dispatcher recycles once
+	 * the task ran, so queueing does not allocate unless the slab is exhausted or f does not fit in a task.
+	 */
+	template <typename F>
+	    requires std::invocable<std::decay_t<F>&>
+	void addTask(F&& f)
+	{
+		void* slot = taskSlab.allocate();
+		addTask(slot ? new (slot) Task(std::forward<F>(f)) : new Task(std::forward<F>(f)));
+	}
+
+	template <typename F>
+	    requires std::invocable<std::decay_t<F>&>
+	void addTask(uint32_t expiration, F&& f)
+	{
+		void* slot = taskSlab.allocate();
+		addTask(slot ? new (slot) Task(expiration, std::forward<F>(f)) : new Task(expiration, std::forward<F>(f)));
+	}
+
+	/**
+	 * Spawns the worker threads helping with parallelFor, must be called from the dispatcher thread.
+	 */
+	void startWorkers(size_t count);
+	bool hasWorkers() const { return workersRunning.load(std::memory_order_relaxed); }
 
-	void addTask(uint32_t expiration, TaskFunc&& f) { addTask(new Task(expiration, std::move(f))); }
+	/**
+	 * Splits [0, count) into ranges and calls f(first, last) for each of them on the workers and the calling thread,
+	 * returning once every range is done; without workers f(0, count) is called inline. Must be called from a task.
+	 * Nothing else runs on the dispatcher meanwhile, so f may read any game state, but it must only write state owned
+	 * by the elements of its range: no Lua and no shared caches (such as the spectator caches of the map).
+	 */
+	void parallelFor(size_t count, const std::function<void(size_t, size_t)>& f);
 
 	void shutdown();
 
@@ -60,11 +128,36 @@ public:
 	void threadMain();
 
 private:
-	std::mutex taskLock;
-	std::condition_variable taskSignal;
+	void waitForTasks();
+	void wakeUp();
+	void releaseTask(Task* task);
+
+	using Range = std::pair<size_t, size_t>;
+
+	void runRanges(std::unique_lock<std::mutex>& workerLockUnique);
+	void workerMain();
+	void stopWorkers();
 
-	std::vector<Task*> taskList;
+	MpscQueue<Task> taskQueue;
+	LockfreeSlab<sizeof(Task), DISPATCHER_TASK_SLOTS> taskSlab;
 	uint64_t dispatcherCycle = 0;
+
+	// only used to park the dispatcher thread while the queue is empty
+	std::mutex taskLock;
+	std::condition_variable taskSignal;
+	std::atomic<bool> waitingForTasks{false};
+
+	// parallelFor, only touched by the dispatcher thread and the workers
+	std::vector<std::thread> workers;
+	std::vector<Range> ranges;
+	const std::function<void(size_t, size_t)>* parallelJob = nullptr;
+	size_t nextRange = 0;
+	size_t pendingRanges = 0;
+	bool stoppingWorkers = false;
+	std::atomic<bool> workersRunning{false};
+	std::mutex workerLock;
+	std::condition_variable workerSignal;
+	std::condition_variable workerDoneSignal;
 };
 
 extern Dispatcher g_dispatcher;
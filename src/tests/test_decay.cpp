@@ -0,0 +1,128 @@
+#define BOOST_TEST_MODULE decay
+
+#include "../otpch.h"
+
+#include "../decay.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+// the wheel never dereferences items, so fake handles are enough
+Item* makeItem(uintptr_t id) { return reinterpret_cast<Item*>(id << 4); }
+
+std::vector<Item*> advance(DecayWheel& wheel)
+{
+	std::vector<Item*> expired;
+	wheel.advance(expired);
+	std::sort(expired.begin(), expired.end());
+	return expired;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_DecayWheel_expiry)
+{
+	DecayWheel wheel;
+	Item* a = makeItem(1);
+	Item* b = makeItem(2);
+	Item* c = makeItem(3);
+
+	uint32_t slotA = wheel.add(a, 2);
+	uint32_t slotB = wheel.add(b, 2);
+	uint32_t slotC = wheel.add(c, 0);
+	BOOST_TEST(slotA != 0u);
+	BOOST_TEST(wheel.getItem(slotB) == b);
+	BOOST_TEST(wheel.getExpiryTick(slotC) == 1u);
+	BOOST_TEST(wheel.size() == 3u);
+
+	BOOST_TEST(advance(wheel) == (std::vector<Item*>{c}));
+	BOOST_TEST(advance(wheel) == (std::vector<Item*>{a, b}));
+	BOOST_TEST(advance(wheel).empty());
+	BOOST_TEST(wheel.size() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_DecayWheel_remove)
+{
+	DecayWheel wheel;
+	Item* a = makeItem(1);
+	Item* b = makeItem(2);
+	Item* c = makeItem(3);
+
+	uint32_t slotA = wheel.add(a, 5);
+	uint32_t slotB = wheel.add(b, 5);
+	wheel.add(c, 5);
+
+	// removing moves the last item of the bucket, which must still be found through its slot
+	wheel.remove(slotA);
+	wheel.remove(slotB);
+	BOOST_TEST(wheel.size() == 1u);
+
+	// released slots are reused
+	uint32_t slotD = wheel.add(makeItem(4), 6);
+	BOOST_TEST((slotD == slotA || slotD == slotB));
+
+	for (int i = 0; i < 4; ++i) {
+		BOOST_TEST(advance(wheel).empty());
+	}
+	BOOST_TEST(advance(wheel) == (std::vector<Item*>{c}));
+	BOOST_TEST(advance(wheel) == (std::vector<Item*>{makeItem(4)}));
+}
+
+BOOST_AUTO_TEST_CASE(test_DecayWheel_long_duration)
+{
+	DecayWheel wheel;
+	Item* a = makeItem(1);
+	Item* b = makeItem(2);
+
+	// both land in the same bucket, a full turn of the wheel apart
+	wheel.add(a, 10);
+	wheel.add(b, 10 + 3 * DecayWheel::WHEEL_SIZE);
+
+	for (int i = 0; i < 9; ++i) {
+		BOOST_TEST(advance(wheel).empty());
+	}
+	BOOST_TEST(advance(wheel) == (std::vector<Item*>{a}));
+
+	size_t expired = 0;
+	while (wheel.getCurrentTick() < 10 + 3 * DecayWheel::WHEEL_SIZE - 1) {
+		expired += advance(wheel).size();
+	}
+	BOOST_TEST(expired == 0u);
+	BOOST_TEST(advance(wheel) == (std::vector<Item*>{b}));
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_DecayWheel_mass_kill,
+	*boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	constexpr size_t corpses = 100000;
+
+	DecayWheel wheel;
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<uint64_t> ticks(4, 4 * 60 * 20);
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uint32_t> slots;
+	slots.reserve(corpses);
+	for (size_t i = 0; i < corpses; ++i) {
+		slots.push_back(wheel.add(makeItem(i + 1), ticks(rng)));
+	}
+
+	// a third of the corpses are looted and removed before they decay
+	for (size_t i = 0; i < corpses; i += 3) {
+		wheel.remove(slots[i]);
+	}
+
+	std::vector<Item*> expired;
+	while (wheel.size() != 0) {
+		wheel.advance(expired);
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_TEST(expired.size() == corpses - (corpses + 2) / 3);
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	BOOST_TEST_MESSAGE("DecayWheel: " << corpses << " corpses added, removed or expired over "
+	                                  << wheel.getCurrentTick() << " ticks in "
+	                                  << duration_cast<microseconds>(elapsed).count() << "us");
+}
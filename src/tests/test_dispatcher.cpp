@@ -0,0 +1,265 @@
+#define BOOST_TEST_MODULE dispatcher
+
+#include "../otpch.h"
+
+#include "../tasks.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+struct DispatcherFixture
+{
+	DispatcherFixture() { dispatcher.start(); }
+	~DispatcherFixture()
+	{
+		dispatcher.shutdown();
+		dispatcher.join();
+	}
+
+	void startWorkers(size_t count)
+	{
+		std::promise<void> started;
+		dispatcher.addTask([&]() {
+			dispatcher.startWorkers(count);
+			started.set_value();
+		});
+		started.get_future().wait();
+	}
+
+	void waitIdle()
+	{
+		std::promise<void> idle;
+		dispatcher.addTask([&]() { idle.set_value(); });
+		idle.get_future().wait();
+	}
+
+	Dispatcher dispatcher;
+};
+
+struct QueueItem : MpscQueueNode
+{
+	QueueItem(size_t producer, size_t sequence) : producer(producer), sequence(sequence) {}
+
+	size_t producer;
+	size_t sequence;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(test_parallelFor, DispatcherFixture)
+{
+	constexpr size_t count = 10000;
+
+	for (size_t workers : {0, 3}) {
+		if (workers != 0) {
+			startWorkers(workers);
+		}
+
+		std::vector<int> visits(count);
+		std::promise<void> done;
+		dispatcher.addTask([&]() {
+			dispatcher.parallelFor(count, [&](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i) {
+					++visits[i];
+				}
+			});
+			done.set_value();
+		});
+		done.get_future().wait();
+
+		BOOST_TEST(std::all_of(visits.begin(), visits.end(), [](int visited) { return visited == 1; }));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_MpscQueue_producer_order)
+{
+	constexpr size_t producers = 4;
+	constexpr size_t itemsPerProducer = 100000;
+
+	MpscQueue<QueueItem> queue;
+	BOOST_TEST(queue.empty());
+	BOOST_TEST(queue.pop() == nullptr);
+
+	std::vector<std::thread> threads;
+	for (size_t producer = 0; producer < producers; ++producer) {
+		threads.emplace_back([&queue, producer]() {
+			for (size_t i = 0; i < itemsPerProducer; ++i) {
+				queue.push(new QueueItem(producer, i));
+			}
+		});
+	}
+
+	std::array<size_t, producers> expected = {};
+	size_t received = 0;
+	bool ordered = true;
+	while (received < producers * itemsPerProducer) {
+		QueueItem* item = queue.pop();
+		if (!item) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		ordered = ordered && item->sequence == expected[item->producer]++;
+		++received;
+		delete item;
+	}
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	BOOST_TEST(ordered);
+	BOOST_TEST(queue.empty());
+	BOOST_TEST(queue.pop() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_LockfreeSlab)
+{
+	constexpr size_t slots = 1000;
+	constexpr size_t producers = 4;
+
+	LockfreeSlab<32, slots> slab;
+
+	std::array<std::vector<void*>, producers> allocated;
+	std::vector<std::thread> threads;
+	for (size_t producer = 0; producer < producers; ++producer) {
+		threads.emplace_back([&, producer]() {
+			while (void* block = slab.allocate()) {
+				allocated[producer].push_back(block);
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	std::set<void*> blocks;
+	for (const auto& producerBlocks : allocated) {
+		blocks.insert(producerBlocks.begin(), producerBlocks.end());
+	}
+	BOOST_TEST(blocks.size() == slots);
+	BOOST_TEST(std::all_of(blocks.begin(), blocks.end(), [&slab](void* block) { return slab.owns(block); }));
+
+	// released blocks come back once handed over
+	int local = 0;
+	BOOST_TEST(!slab.owns(&local));
+	slab.release(*blocks.begin());
+	BOOST_TEST(slab.allocate() == nullptr);
+	slab.flush();
+	BOOST_TEST(slab.allocate() == *blocks.begin());
+	BOOST_TEST(slab.allocate() == nullptr);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_addTask_releases_callables, DispatcherFixture)
+{
+	constexpr size_t tasks = DISPATCHER_TASK_SLOTS + 1000;
+
+	// the tasks queued while the dispatcher is blocked exhaust the slab, the rest go to the heap
+	std::promise<void> blocked;
+	dispatcher.addTask([future = blocked.get_future().share()]() { future.wait(); });
+
+	auto captured = std::make_shared<int>(0);
+	size_t executed = 0;
+	for (size_t i = 0; i < tasks; ++i) {
+		if (i % 2 == 0) {
+			dispatcher.addTask([captured, &executed]() { ++executed; });
+		} else {
+			// too big to be stored in the task itself
+			std::array<char, TASK_INLINE_SIZE> padding = {};
+			dispatcher.addTask([captured, padding, &executed]() { executed += padding.size() / TASK_INLINE_SIZE; });
+		}
+	}
+
+	BOOST_TEST(captured.use_count() == static_cast<long>(tasks + 1));
+	blocked.set_value();
+	waitIdle();
+
+	BOOST_TEST(executed == tasks);
+	BOOST_TEST(captured.use_count() == 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_addTask_producer_order, DispatcherFixture)
+{
+	constexpr size_t producers = 4;
+	constexpr int tasksPerProducer = 10000;
+
+	std::array<std::vector<int>, producers> orders;
+	std::vector<std::thread> threads;
+	for (size_t producer = 0; producer < producers; ++producer) {
+		threads.emplace_back([&, producer]() {
+			for (int i = 0; i < tasksPerProducer; ++i) {
+				dispatcher.addTask([&orders, producer, i]() { orders[producer].push_back(i); });
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	waitIdle();
+
+	for (const auto& order : orders) {
+		BOOST_TEST(order.size() == static_cast<size_t>(tasksPerProducer));
+		BOOST_TEST(std::is_sorted(order.begin(), order.end()));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_addTask, *boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	constexpr size_t tasks = 1000000;
+
+	// the same tasks built in the slab of the dispatcher and on the heap, flooding the dispatcher or keeping at most
+	// half as many tasks queued as the slab holds, the flood exhausts the slab so most of its tasks use the heap too
+	for (bool bounded : {false, true}) {
+		for (bool pooled : {true, false}) {
+			for (size_t producers : {1, 2, 4, 8}) {
+				DispatcherFixture fixture;
+				std::atomic<size_t> queued{0};
+				std::atomic<size_t> executed{0};
+				std::promise<void> done;
+
+				auto start = std::chrono::steady_clock::now();
+				std::vector<std::thread> threads;
+				for (size_t producer = 0; producer < producers; ++producer) {
+					threads.emplace_back([&]() {
+						auto task = [&]() {
+							if (executed.fetch_add(1, std::memory_order_relaxed) + 1 == tasks / producers * producers) {
+								done.set_value();
+							}
+						};
+
+						for (size_t i = 0; i < tasks / producers; ++i) {
+							if (bounded) {
+								while (queued.load(std::memory_order_relaxed) -
+								           executed.load(std::memory_order_relaxed) >=
+								       DISPATCHER_TASK_SLOTS / 2) {
+									std::this_thread::yield();
+								}
+								queued.fetch_add(1, std::memory_order_relaxed);
+							}
+
+							if (pooled) {
+								fixture.dispatcher.addTask(task);
+							} else {
+								fixture.dispatcher.addTask(new Task(task));
+							}
+						}
+					});
+				}
+				for (std::thread& thread : threads) {
+					thread.join();
+				}
+				done.get_future().wait();
+				auto elapsed = std::chrono::steady_clock::now() - start;
+
+				BOOST_TEST(executed == tasks / producers * producers);
+				using std::chrono::duration_cast;
+				using std::chrono::microseconds;
+				auto us = std::max<int64_t>(duration_cast<microseconds>(elapsed).count(), 1);
+				BOOST_TEST_MESSAGE("addTask (" << (pooled ? "slab" : "heap") << ", " << (bounded ? "bounded" : "flood")
+				                               << ") with " << producers << " producers: " << executed * 1000000 / us
+				                               << " tasks/s");
+			}
+		}
+	}
+}
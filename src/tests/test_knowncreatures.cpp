@@ -0,0 +1,126 @@
+#define BOOST_TEST_MODULE knowncreatures
+
+#include "../otpch.h"
+
+#include "../knowncreatures.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+constexpr size_t capacity = KnownCreatureList::CAPACITY;
+
+bool nothingVisible(uint32_t) { return false; }
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_insert_until_full)
+{
+	KnownCreatureList known;
+	uint32_t removed = 1;
+
+	BOOST_TEST(!known.insert(0x10000001, removed, nothingVisible));
+	BOOST_TEST(removed == 0u);
+	BOOST_TEST(known.insert(0x10000001, removed, nothingVisible));
+	BOOST_TEST(known.size() == 1u);
+
+	for (uint32_t id = 0x10000002; known.size() < capacity; ++id) {
+		BOOST_TEST(!known.insert(id, removed, nothingVisible));
+		BOOST_TEST(removed == 0u);
+	}
+
+	// the least recently sent one goes first
+	BOOST_TEST(!known.insert(0x20000000, removed, nothingVisible));
+	BOOST_TEST(removed == 0x10000001u);
+	BOOST_TEST(!known.contains(0x10000001));
+	BOOST_TEST(known.contains(0x20000000));
+	BOOST_TEST(known.size() == capacity);
+}
+
+BOOST_AUTO_TEST_CASE(test_eviction_prefers_out_of_view)
+{
+	KnownCreatureList known;
+	uint32_t removed;
+	for (uint32_t id = 1; id <= capacity; ++id) {
+		known.insert(id, removed, nothingVisible);
+	}
+
+	// the three oldest are still in view
+	auto inView = [](uint32_t id) { return id <= 3; };
+	BOOST_TEST(!known.insert(5000, removed, inView));
+	BOOST_TEST(removed == 4u);
+	BOOST_TEST(known.contains(1));
+
+	// and are not checked again before everything sent after them
+	BOOST_TEST(!known.insert(5001, removed, [](uint32_t id) {
+		BOOST_TEST(id > 3u);
+		return false;
+	}));
+	BOOST_TEST(removed == 5u);
+
+	// when everything is in view the least recently sent one is forgotten anyway
+	BOOST_TEST(!known.insert(5002, removed, [](uint32_t) { return true; }));
+	BOOST_TEST(removed != 0u);
+	BOOST_TEST(!known.contains(removed));
+	BOOST_TEST(known.size() == capacity);
+}
+
+BOOST_AUTO_TEST_CASE(test_matches_reference)
+{
+	KnownCreatureList known;
+	std::list<uint32_t> reference; // most recently sent first
+
+	std::mt19937 rng(1337);
+	std::uniform_int_distribution<uint32_t> ids(1, 3000);
+	for (int i = 0; i < 200000; ++i) {
+		uint32_t id = ids(rng);
+		uint32_t removed;
+		bool wasKnown = known.insert(id, removed, nothingVisible);
+
+		auto it = std::find(reference.begin(), reference.end(), id);
+		BOOST_REQUIRE(wasKnown == (it != reference.end()));
+		if (wasKnown) {
+			reference.splice(reference.begin(), reference, it);
+			continue;
+		}
+
+		uint32_t expectedRemoved = 0;
+		if (reference.size() == capacity) {
+			expectedRemoved = reference.back();
+			reference.pop_back();
+		}
+		reference.push_front(id);
+
+		BOOST_REQUIRE(removed == expectedRemoved);
+	}
+
+	BOOST_TEST(known.size() == reference.size());
+	for (uint32_t id : reference) {
+		BOOST_TEST(known.contains(id));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_insert, *boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	constexpr int inserts = 1000000;
+
+	KnownCreatureList known;
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<uint32_t> ids(0x10000000, 0x10000000 + 4000);
+
+	size_t evictions = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < inserts; ++i) {
+		uint32_t removed;
+		if (!known.insert(ids(rng), removed, [](uint32_t id) { return id % 2 == 0; }) && removed != 0) {
+			++evictions;
+		}
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_TEST(known.size() == capacity);
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+	BOOST_TEST_MESSAGE("KnownCreatureList::insert: " << duration_cast<nanoseconds>(elapsed).count() / inserts
+	                                                 << "ns per insert, " << evictions << " evictions");
+}
@@ -0,0 +1,142 @@
+#define BOOST_TEST_MODULE messagepool
+
+#include "../otpch.h"
+
+#include "../messagepool.h"
+
+#include <boost/test/unit_test.hpp>
+
+using tfs::net::allocate_message_block;
+using tfs::net::get_message_pool_stats;
+using tfs::net::MESSAGE_BLOCK_SIZE;
+using tfs::net::MessagePoolStats;
+using tfs::net::release_message_block;
+
+namespace {
+
+MessagePoolStats getStats(size_t blockSize)
+{
+	for (const MessagePoolStats& stats : get_message_pool_stats()) {
+		if (stats.blockSize == blockSize) {
+			return stats;
+		}
+	}
+	BOOST_FAIL("no size class of " << blockSize << " bytes");
+	return {};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_size_classes)
+{
+	const auto before = getStats(1024);
+
+	void* block = allocate_message_block(300);
+	std::memset(block, 0xAB, 1024);
+	BOOST_TEST(getStats(1024).inUse == before.inUse + 1);
+	BOOST_TEST(getStats(1024).misses + getStats(1024).hits == before.misses + before.hits + 1);
+
+	release_message_block(block, 300);
+	BOOST_TEST(getStats(1024).inUse == before.inUse);
+
+	// released blocks are reused by the same thread
+	void* reused = allocate_message_block(1000);
+	BOOST_TEST(reused == block);
+	BOOST_TEST(getStats(1024).hits == before.hits + 1);
+	release_message_block(reused, 1000);
+
+	// sizes above the largest class are not pooled
+	void* large = allocate_message_block(MESSAGE_BLOCK_SIZE + 1);
+	release_message_block(large, MESSAGE_BLOCK_SIZE + 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_high_water_mark)
+{
+	const auto before = getStats(MESSAGE_BLOCK_SIZE);
+
+	std::vector<void*> blocks;
+	for (int i = 0; i < 100; ++i) {
+		blocks.push_back(allocate_message_block(MESSAGE_BLOCK_SIZE));
+	}
+	for (void* block : blocks) {
+		release_message_block(block, MESSAGE_BLOCK_SIZE);
+	}
+	blocks.clear();
+
+	auto stats = getStats(MESSAGE_BLOCK_SIZE);
+	BOOST_TEST(stats.highWater >= before.inUse + 100);
+	BOOST_TEST(stats.inUse == before.inUse);
+
+	// every block is kept, so the same burst does not allocate again
+	for (int i = 0; i < 100; ++i) {
+		blocks.push_back(allocate_message_block(MESSAGE_BLOCK_SIZE));
+	}
+	BOOST_TEST(getStats(MESSAGE_BLOCK_SIZE).misses == stats.misses);
+	for (void* block : blocks) {
+		release_message_block(block, MESSAGE_BLOCK_SIZE);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_released_by_other_threads)
+{
+	constexpr size_t rounds = 50;
+	constexpr size_t blocksPerRound = 200;
+
+	// blocks allocated here are released by another thread and come back through the shared list
+	std::vector<void*> blocks;
+	for (size_t round = 0; round < rounds; ++round) {
+		for (size_t i = 0; i < blocksPerRound; ++i) {
+			blocks.push_back(allocate_message_block(4096));
+		}
+		std::thread([&blocks]() {
+			for (void* block : blocks) {
+				release_message_block(block, 4096);
+			}
+		}).join();
+		blocks.clear();
+	}
+
+	auto stats = getStats(4096);
+	BOOST_TEST(stats.inUse == 0u);
+	BOOST_TEST(stats.misses < rounds * blocksPerRound / 2);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_allocate_message_block,
+	*boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	constexpr size_t iterations = 1000000;
+	constexpr size_t burst = 16;
+
+	std::array<void*, burst> blocks;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations / burst; ++i) {
+		for (void*& block : blocks) {
+			block = allocate_message_block(MESSAGE_BLOCK_SIZE);
+			static_cast<uint8_t*>(block)[0] = 1;
+		}
+		for (void* block : blocks) {
+			release_message_block(block, MESSAGE_BLOCK_SIZE);
+		}
+	}
+	auto poolTime = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations / burst; ++i) {
+		for (void*& block : blocks) {
+			block = ::operator new(MESSAGE_BLOCK_SIZE);
+			static_cast<uint8_t*>(block)[0] = 1;
+		}
+		for (void* block : blocks) {
+			::operator delete(block);
+		}
+	}
+	auto heapTime = std::chrono::steady_clock::now() - start;
+
+	BOOST_TEST(getStats(MESSAGE_BLOCK_SIZE).inUse == 0u);
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+	BOOST_TEST_MESSAGE("message blocks of " << MESSAGE_BLOCK_SIZE << " bytes: pool "
+	                                        << duration_cast<nanoseconds>(poolTime).count() / iterations
+	                                        << "ns, operator new "
+	                                        << duration_cast<nanoseconds>(heapTime).count() / iterations << "ns");
+}
@@ -0,0 +1,94 @@
+#define BOOST_TEST_MODULE packetratelimiter
+
+#include "../otpch.h"
+
+#include "../packetratelimiter.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+constexpr uint8_t OPCODE_LOGOUT = 0x14;
+constexpr uint8_t OPCODE_WALK_NORTH = 0x65;
+constexpr uint8_t OPCODE_WALK_EAST = 0x66;
+constexpr uint8_t OPCODE_LOOK_AT = 0x8C;
+constexpr uint8_t OPCODE_SET_OUTFIT = 0xD3;
+constexpr uint8_t OPCODE_BROWSE_MARKET = 0xF5;
+constexpr uint8_t OPCODE_UNKNOWN = 0x2A;
+
+int allowed(PacketRateLimiter& limiter, uint8_t opcode, int packets, int64_t now)
+{
+	int count = 0;
+	for (int i = 0; i < packets; ++i) {
+		if (limiter.allow(opcode, now)) {
+			++count;
+		}
+	}
+	return count;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_burst_then_refill)
+{
+	PacketRateLimiter limiter;
+	const auto& rate = PacketRateLimiter::getRate(PACKET_RATE_LOOK);
+
+	BOOST_TEST(allowed(limiter, OPCODE_LOOK_AT, 100, 1000) == static_cast<int>(rate.burst));
+
+	// one token comes back every 1000 / perSecond milliseconds
+	int64_t refill = 1000 / rate.perSecond;
+	BOOST_TEST(!limiter.allow(OPCODE_LOOK_AT, 1000 + refill - 1));
+	BOOST_TEST(limiter.allow(OPCODE_LOOK_AT, 1000 + refill));
+	BOOST_TEST(!limiter.allow(OPCODE_LOOK_AT, 1000 + refill));
+
+	// a long pause refills up to the burst only
+	BOOST_TEST(allowed(limiter, OPCODE_LOOK_AT, 100, 100000) == static_cast<int>(rate.burst));
+}
+
+BOOST_AUTO_TEST_CASE(test_sustained_rate)
+{
+	PacketRateLimiter limiter;
+	const auto& rate = PacketRateLimiter::getRate(PACKET_RATE_WALK);
+
+	// a client flooding every millisecond for ten seconds gets the burst plus the rate
+	int count = 0;
+	for (int64_t now = 0; now < 10000; ++now) {
+		count += allowed(limiter, OPCODE_WALK_NORTH, 1, now);
+	}
+	BOOST_TEST(count == static_cast<int>(rate.burst + rate.perSecond * 10 - 1));
+}
+
+BOOST_AUTO_TEST_CASE(test_human_click_rates)
+{
+	PacketRateLimiter limiter;
+
+	// a player clicking through the market, outfits and looks as fast as a mouse allows is never dropped
+	for (uint8_t opcode : {OPCODE_BROWSE_MARKET, OPCODE_SET_OUTFIT, OPCODE_LOOK_AT}) {
+		int count = 0;
+		for (int64_t now = 0; now < 60000; now += 125) {
+			count += allowed(limiter, opcode, 1, now);
+		}
+		BOOST_TEST(count == 60000 / 125);
+	}
+
+	// nor is a burst of requests sent at once when a window opens
+	BOOST_TEST(allowed(limiter, OPCODE_BROWSE_MARKET, 20, 120000) == 20);
+}
+
+BOOST_AUTO_TEST_CASE(test_rate_classes)
+{
+	PacketRateLimiter limiter;
+
+	BOOST_TEST(PacketRateLimiter::getRateClass(OPCODE_LOGOUT) == PACKET_RATE_UNLIMITED);
+	BOOST_TEST(allowed(limiter, OPCODE_LOGOUT, 10000, 0) == 10000);
+
+	// walking in any direction shares one bucket, other kinds are not affected
+	const auto& walk = PacketRateLimiter::getRate(PACKET_RATE_WALK);
+	BOOST_TEST(allowed(limiter, OPCODE_WALK_NORTH, 100, 0) + allowed(limiter, OPCODE_WALK_EAST, 100, 0) ==
+	           static_cast<int>(walk.burst));
+	BOOST_TEST(limiter.allow(OPCODE_LOOK_AT, 0));
+
+	// opcodes unknown to the server are left to Lua and limited as extended opcodes
+	BOOST_TEST(PacketRateLimiter::getRateClass(OPCODE_UNKNOWN) == PACKET_RATE_EXTENDED);
+}
@@ -0,0 +1,197 @@
+#define BOOST_TEST_MODULE scheduler
+
+#include "../otpch.h"
+
+#include "../scheduler.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+struct WheelFixture
+{
+	~WheelFixture()
+	{
+		wheel.drain([](SchedulerTask* task) { delete task; });
+	}
+
+	SchedulerTask* insert(uint64_t expiryTick, int id)
+	{
+		SchedulerTask* task = createSchedulerTask(0, [this, id]() { fired.push_back(id); });
+		wheel.insert(task, expiryTick);
+		return task;
+	}
+
+	std::vector<int> advance(uint64_t tick)
+	{
+		std::vector<SchedulerTask*> expired;
+		uint64_t previousTick = wheel.getCurrentTick();
+		wheel.advance(tick, expired);
+
+		fired.clear();
+		for (SchedulerTask* task : expired) {
+			onTime = onTime && task->getExpiryTick() > previousTick && task->getExpiryTick() <= tick;
+			expiryTicks.push_back(task->getExpiryTick());
+			(*task)();
+			delete task;
+		}
+		return fired;
+	}
+
+	TimingWheel wheel;
+	std::vector<int> fired;
+	std::vector<uint64_t> expiryTicks;
+	bool onTime = true;
+};
+
+struct SchedulerFixture
+{
+	SchedulerFixture()
+	{
+		g_dispatcher.start();
+		scheduler.start();
+	}
+	~SchedulerFixture()
+	{
+		scheduler.shutdown();
+		scheduler.join();
+		g_dispatcher.shutdown();
+		g_dispatcher.join();
+	}
+
+	Scheduler scheduler;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(test_TimingWheel_expiry_order, WheelFixture)
+{
+	insert(5, 1);
+	insert(3, 2);
+	insert(5, 3);
+	insert(300, 4);
+	insert(70000, 5);
+	BOOST_TEST(wheel.size() == 5u);
+	BOOST_TEST(wheel.getNextTick() == 3u);
+
+	BOOST_TEST(advance(2).empty());
+	BOOST_TEST(advance(5) == (std::vector<int>{2, 1, 3}));
+	BOOST_TEST(advance(299).empty());
+	BOOST_TEST(advance(300) == (std::vector<int>{4}));
+	BOOST_TEST(advance(69999).empty());
+	BOOST_TEST(advance(70000) == (std::vector<int>{5}));
+	BOOST_TEST(wheel.size() == 0u);
+	BOOST_TEST(wheel.getNextTick() == std::numeric_limits<uint64_t>::max());
+	BOOST_TEST(std::is_sorted(expiryTicks.begin(), expiryTicks.end()));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_TimingWheel_remove, WheelFixture)
+{
+	SchedulerTask* a = insert(10, 1);
+	insert(10, 2);
+	SchedulerTask* c = insert(100000, 3);
+
+	wheel.remove(a);
+	delete a;
+	wheel.remove(c);
+	delete c;
+
+	BOOST_TEST(wheel.size() == 1u);
+	BOOST_TEST(advance(200000) == (std::vector<int>{2}));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_TimingWheel_past_and_far_ticks, WheelFixture)
+{
+	advance(1000);
+
+	// ticks that already passed expire on the next one
+	insert(10, 1);
+	BOOST_TEST(advance(1001) == (std::vector<int>{1}));
+
+	// the longest delay lands on the last level and is cascaded down in time
+	SchedulerTask* far = insert(uint64_t{1001} + std::numeric_limits<uint32_t>::max(), 2);
+	BOOST_TEST(far->getExpiryTick() == uint64_t{1001} + std::numeric_limits<uint32_t>::max());
+	BOOST_TEST(advance(far->getExpiryTick() - 1).empty());
+	BOOST_TEST(advance(far->getExpiryTick()) == (std::vector<int>{2}));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_TimingWheel_matches_reference, WheelFixture)
+{
+	std::mt19937 rng(1337);
+	std::uniform_int_distribution<uint64_t> delay(0, 200000);
+
+	std::multimap<uint64_t, int> reference;
+	for (int i = 0; i < 20000; ++i) {
+		uint64_t expiryTick = wheel.getCurrentTick() + 1 + delay(rng);
+		insert(expiryTick, i);
+		reference.emplace(expiryTick, i);
+		if (i % 100 == 0) {
+			advance(wheel.getCurrentTick() + delay(rng) / 10);
+		}
+	}
+	advance(wheel.getCurrentTick() + 300000);
+
+	BOOST_TEST(onTime);
+	BOOST_TEST(expiryTicks.size() == reference.size());
+	BOOST_TEST(std::is_sorted(expiryTicks.begin(), expiryTicks.end()));
+	BOOST_TEST(wheel.size() == 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_Scheduler_addEvent_stopEvent, SchedulerFixture)
+{
+	std::promise<void> firedPromise;
+	std::atomic<bool> stoppedFired{false};
+
+	uint32_t stoppedId = scheduler.addEvent(createSchedulerTask(20, [&]() { stoppedFired = true; }));
+	uint32_t firedId = scheduler.addEvent(createSchedulerTask(40, [&]() { firedPromise.set_value(); }));
+	BOOST_TEST(stoppedId != 0u);
+	BOOST_TEST(firedId != stoppedId);
+
+	scheduler.stopEvent(stoppedId);
+	BOOST_TEST((firedPromise.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready));
+	BOOST_TEST(!stoppedFired);
+
+	// ids of events that already fired or were stopped are ignored
+	std::promise<void> laterPromise;
+	scheduler.addEvent(createSchedulerTask(20, [&]() { laterPromise.set_value(); }));
+	scheduler.stopEvent(stoppedId);
+	scheduler.stopEvent(firedId);
+	BOOST_TEST((laterPromise.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready));
+}
+
+BOOST_FIXTURE_TEST_CASE(benchmark_TimingWheel_insert_remove, WheelFixture,
+	*boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	constexpr size_t events = 1000000;
+
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<uint64_t> delay(1, 60000);
+
+	std::vector<SchedulerTask*> tasks;
+	tasks.reserve(events);
+	for (size_t i = 0; i < events; ++i) {
+		tasks.push_back(createSchedulerTask(0, []() {}));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (SchedulerTask* task : tasks) {
+		wheel.insert(task, wheel.getCurrentTick() + delay(rng));
+	}
+	for (size_t i = 0; i < events; i += 2) {
+		wheel.remove(tasks[i]);
+	}
+
+	std::vector<SchedulerTask*> expired;
+	wheel.advance(wheel.getCurrentTick() + 60000, expired);
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_TEST(expired.size() == events / 2);
+	for (SchedulerTask* task : tasks) {
+		delete task;
+	}
+
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	BOOST_TEST_MESSAGE("TimingWheel: " << events << " inserts, " << events / 2 << " removals and 60000 ticks in "
+	                                   << duration_cast<microseconds>(elapsed).count() << "us");
+}
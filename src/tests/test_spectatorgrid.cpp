@@ -0,0 +1,380 @@
+#define BOOST_TEST_MODULE spectatorgrid
+
+#include "../otpch.h"
+
+#include "../spectatorgrid.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+struct Spectator
+{
+	Creature* creature;
+	Position pos;
+	bool isPlayer;
+};
+
+// the grid never dereferences creatures, so fake handles are enough
+Creature* makeCreature(uintptr_t id) { return reinterpret_cast<Creature*>(id << 4); }
+
+std::vector<Creature*> sorted(const SpectatorVec& spectators)
+{
+	std::vector<Creature*> result(spectators.begin(), spectators.end());
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// reference implementation with the semantics of the former QTreeLeafNode scan
+std::vector<Creature*> bruteForce(const std::vector<Spectator>& population, const Position& centerPos,
+                                  int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY,
+                                  int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers)
+{
+	std::vector<Creature*> result;
+	for (const Spectator& spectator : population) {
+		const Position& cpos = spectator.pos;
+		if ((onlyPlayers && !spectator.isPlayer) || minRangeZ > cpos.z || maxRangeZ < cpos.z) {
+			continue;
+		}
+
+		int32_t offsetZ = centerPos.getOffsetZ(cpos);
+		if (centerPos.x + minRangeX + offsetZ > cpos.x || centerPos.x + maxRangeX + offsetZ < cpos.x ||
+		    centerPos.y + minRangeY + offsetZ > cpos.y || centerPos.y + maxRangeY + offsetZ < cpos.y) {
+			continue;
+		}
+		result.push_back(spectator.creature);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+/**
+ * The QTree spectator index Map used before the grid, kept as the baseline of the benchmark. Leaves of 8x8 tiles are
+ * linked to their south and east neighbours and hold the creatures of all floors, whose positions are read through
+ * the creatures like Creature::getPosition did.
+ */
+class QTree
+{
+public:
+	// like Map::setTile, every tile of the map has a leaf whether a creature stands there or not
+	void createLeaf(uint16_t x, uint16_t y)
+	{
+		bool newLeaf = false;
+		Leaf* leaf = createLeaf(&root, x, y, 15, newLeaf);
+		if (!newLeaf) {
+			return;
+		}
+
+		if (Leaf* northLeaf = getLeaf(x, y - LEAF_SIZE)) {
+			northLeaf->leafS = leaf;
+		}
+		if (Leaf* westLeaf = getLeaf(x - LEAF_SIZE, y)) {
+			westLeaf->leafE = leaf;
+		}
+		leaf->leafS = getLeaf(x, y + LEAF_SIZE);
+		leaf->leafE = getLeaf(x + LEAF_SIZE, y);
+	}
+
+	void addCreature(const Spectator& spectator)
+	{
+		Leaf* leaf = getLeaf(spectator.pos.x, spectator.pos.y);
+		leaf->creatures.push_back(&spectator);
+		if (spectator.isPlayer) {
+			leaf->players.push_back(&spectator);
+		}
+	}
+
+	// Map::getSpectatorsInternal
+	void getSpectators(SpectatorVec& spectators, const Position& centerPos, int32_t minRangeX, int32_t maxRangeX,
+	                   int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ, int32_t maxRangeZ,
+	                   bool onlyPlayers) const
+	{
+		auto min_y = centerPos.y + minRangeY;
+		auto min_x = centerPos.x + minRangeX;
+		auto max_y = centerPos.y + maxRangeY;
+		auto max_x = centerPos.x + maxRangeX;
+
+		int32_t minoffset = centerPos.getZ() - maxRangeZ;
+		uint16_t x1 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (min_x + minoffset)));
+		uint16_t y1 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (min_y + minoffset)));
+
+		int32_t maxoffset = centerPos.getZ() - minRangeZ;
+		uint16_t x2 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (max_x + maxoffset)));
+		uint16_t y2 = std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (max_y + maxoffset)));
+
+		int32_t startx1 = x1 - (x1 % LEAF_SIZE);
+		int32_t starty1 = y1 - (y1 % LEAF_SIZE);
+		int32_t endx2 = x2 - (x2 % LEAF_SIZE);
+		int32_t endy2 = y2 - (y2 % LEAF_SIZE);
+
+		const Leaf* leafS = getLeaf(startx1, starty1);
+		const Leaf* leafE;
+
+		for (int_fast32_t ny = starty1; ny <= endy2; ny += LEAF_SIZE) {
+			leafE = leafS;
+			for (int_fast32_t nx = startx1; nx <= endx2; nx += LEAF_SIZE) {
+				if (leafE) {
+					const auto& node_list = (onlyPlayers ? leafE->players : leafE->creatures);
+					for (const Spectator* spectator : node_list) {
+						const Position& cpos = spectator->pos;
+						if (minRangeZ > cpos.z || maxRangeZ < cpos.z) {
+							continue;
+						}
+
+						int16_t offsetZ = centerPos.getOffsetZ(cpos);
+						if ((min_y + offsetZ) > cpos.y || (max_y + offsetZ) < cpos.y || (min_x + offsetZ) > cpos.x ||
+						    (max_x + offsetZ) < cpos.x) {
+							continue;
+						}
+
+						spectators.emplace_back(spectator->creature);
+					}
+					leafE = leafE->leafE;
+				} else {
+					leafE = getLeaf(nx + LEAF_SIZE, ny);
+				}
+			}
+
+			if (leafS) {
+				leafS = leafS->leafS;
+			} else {
+				leafS = getLeaf(startx1, ny + LEAF_SIZE);
+			}
+		}
+	}
+
+private:
+	static constexpr uint32_t LEAF_BITS = 3;
+	static constexpr int32_t LEAF_SIZE = 1 << LEAF_BITS;
+
+	struct Node
+	{
+		virtual ~Node()
+		{
+			for (Node* node : child) {
+				delete node;
+			}
+		}
+
+		Node* child[4] = {};
+		bool leaf = false;
+	};
+
+	struct Leaf final : Node
+	{
+		Leaf() { leaf = true; }
+
+		Leaf* leafS = nullptr;
+		Leaf* leafE = nullptr;
+		void* floors[16] = {}; // the tiles of each of the MAP_MAX_LAYERS floors, unused here
+		std::vector<const Spectator*> creatures;
+		std::vector<const Spectator*> players;
+	};
+
+	static Leaf* createLeaf(Node* node, uint32_t x, uint32_t y, uint32_t level, bool& newLeaf)
+	{
+		if (node->leaf) {
+			return static_cast<Leaf*>(node);
+		}
+
+		Node*& child = node->child[((x & 0x8000) >> 15) | ((y & 0x8000) >> 14)];
+		if (!child) {
+			if (level != LEAF_BITS) {
+				child = new Node();
+			} else {
+				child = new Leaf();
+				newLeaf = true;
+			}
+		}
+		return createLeaf(child, x * 2, y * 2, level - 1, newLeaf);
+	}
+
+	Leaf* getLeaf(uint32_t x, uint32_t y) const
+	{
+		const Node* node = &root;
+		do {
+			node = node->child[((x & 0x8000) >> 15) | ((y & 0x8000) >> 14)];
+			if (!node) {
+				return nullptr;
+			}
+
+			x <<= 1;
+			y <<= 1;
+		} while (!node->leaf);
+		return static_cast<Leaf*>(const_cast<Node*>(node));
+	}
+
+	Node root;
+};
+
+std::vector<Spectator> populate(SpectatorGrid& grid, size_t count, uint16_t baseX, uint16_t baseY, uint16_t extent)
+{
+	std::mt19937 rng(1337);
+	std::uniform_int_distribution<uint16_t> coord(0, extent - 1);
+	std::uniform_int_distribution<uint16_t> floor(0, 15);
+
+	std::vector<Spectator> population;
+	population.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		Position pos(baseX + coord(rng), baseY + coord(rng), static_cast<uint8_t>(floor(rng)));
+		population.push_back({makeCreature(i + 1), pos, i % 4 == 0});
+		grid.addCreature(population.back().creature, pos, population.back().isPlayer);
+	}
+	return population;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_getSpectators_single_floor)
+{
+	SpectatorGrid grid;
+	Creature* a = makeCreature(1);
+	Creature* b = makeCreature(2);
+	Creature* c = makeCreature(3);
+
+	grid.addCreature(a, Position(100, 100, 7), true);
+	grid.addCreature(b, Position(111, 89, 7), false);
+	grid.addCreature(c, Position(112, 100, 7), false);
+
+	SpectatorVec spectators;
+	grid.getSpectators(spectators, Position(100, 100, 7), -11, 11, -11, 11, 7, 7, false);
+	BOOST_TEST(sorted(spectators) == (std::vector<Creature*>{a, b}));
+
+	SpectatorVec players;
+	grid.getSpectators(players, Position(100, 100, 7), -11, 11, -11, 11, 7, 7, true);
+	BOOST_TEST(sorted(players) == (std::vector<Creature*>{a}));
+}
+
+BOOST_AUTO_TEST_CASE(test_getSpectators_map_border)
+{
+	SpectatorGrid grid;
+	Creature* a = makeCreature(1);
+	Creature* b = makeCreature(2);
+
+	grid.addCreature(a, Position(0, 0, 7), false);
+	grid.addCreature(b, Position(0xFFFF, 0xFFFF, 7), false);
+
+	SpectatorVec spectators;
+	grid.getSpectators(spectators, Position(3, 3, 7), -11, 11, -11, 11, 7, 7, false);
+	BOOST_TEST(sorted(spectators) == (std::vector<Creature*>{a}));
+
+	SpectatorVec farSpectators;
+	grid.getSpectators(farSpectators, Position(0xFFFD, 0xFFFD, 7), -11, 11, -11, 11, 7, 7, false);
+	BOOST_TEST(sorted(farSpectators) == (std::vector<Creature*>{b}));
+}
+
+BOOST_AUTO_TEST_CASE(test_moveCreature)
+{
+	SpectatorGrid grid;
+	Creature* a = makeCreature(1);
+
+	grid.addCreature(a, Position(100, 100, 7), true);
+
+	// inside the same cell
+	grid.moveCreature(a, Position(100, 100, 7), Position(101, 100, 7), true);
+	SpectatorVec spectators;
+	grid.getSpectators(spectators, Position(112, 100, 7), -11, 11, -11, 11, 7, 7, true);
+	BOOST_TEST(sorted(spectators) == (std::vector<Creature*>{a}));
+
+	// across cells and floors
+	grid.moveCreature(a, Position(101, 100, 7), Position(300, 300, 6), true);
+	BOOST_TEST(grid.getPlayerCount(7) == 0u);
+	BOOST_TEST(grid.getPlayerCount(6) == 1u);
+
+	SpectatorVec oldSpectators;
+	grid.getSpectators(oldSpectators, Position(100, 100, 7), -11, 11, -11, 11, 0, 9, false);
+	BOOST_TEST(oldSpectators.empty());
+
+	grid.removeCreature(a, Position(300, 300, 6), true);
+	BOOST_TEST(grid.getCreatureCount(6) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_isUnchangedSince)
+{
+	SpectatorGrid grid;
+	Creature* a = makeCreature(1);
+	Creature* b = makeCreature(2);
+
+	grid.addCreature(a, Position(100, 100, 7), false);
+	grid.addCreature(b, Position(1000, 1000, 7), false);
+	uint64_t version = grid.getVersion();
+	BOOST_TEST(grid.isUnchangedSince(version, 80, 120, 80, 120));
+
+	// changes far away do not affect the area
+	grid.moveCreature(b, Position(1000, 1000, 7), Position(1001, 1000, 7), false);
+	BOOST_TEST(grid.isUnchangedSince(version, 80, 120, 80, 120));
+
+	// any floor of the area counts
+	grid.moveCreature(a, Position(100, 100, 7), Position(100, 100, 8), false);
+	BOOST_TEST(!grid.isUnchangedSince(version, 80, 120, 80, 120));
+	BOOST_TEST(grid.isUnchangedSince(grid.getVersion(), 80, 120, 80, 120));
+}
+
+BOOST_AUTO_TEST_CASE(test_getSpectators_matches_reference)
+{
+	SpectatorGrid grid;
+	auto population = populate(grid, 20000, 1000, 1000, 512);
+
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<uint16_t> coord(990, 1522);
+	std::uniform_int_distribution<int32_t> floor(0, 15);
+	for (int i = 0; i < 500; ++i) {
+		Position centerPos(coord(rng), coord(rng), static_cast<uint8_t>(floor(rng)));
+		int32_t minRangeZ = std::max(centerPos.getZ() - 2, 0);
+		int32_t maxRangeZ = std::min(centerPos.getZ() + 2, 15);
+		bool onlyPlayers = i % 2 == 0;
+
+		SpectatorVec spectators;
+		grid.getSpectators(spectators, centerPos, -11, 11, -11, 11, minRangeZ, maxRangeZ, onlyPlayers);
+		BOOST_TEST(sorted(spectators) == bruteForce(population, centerPos, -11, 11, -11, 11, minRangeZ, maxRangeZ,
+		                                            onlyPlayers));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_getSpectators, *boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	SpectatorGrid grid;
+	auto population = populate(grid, 50000, 1000, 1000, 1024);
+
+	std::vector<Position> centers;
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<uint16_t> coord(1000, 2023);
+	for (int i = 0; i < 1000; ++i) {
+		centers.emplace_back(coord(rng), coord(rng), 7);
+	}
+
+	size_t gridFound = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (const Position& centerPos : centers) {
+		SpectatorVec spectators;
+		grid.getSpectators(spectators, centerPos, -11, 11, -11, 11, 0, 9, false);
+		gridFound += spectators.size();
+	}
+	auto gridTime = std::chrono::steady_clock::now() - start;
+
+	QTree qtree;
+	for (uint32_t y = 1000; y < 1000 + 1024; y += 8) {
+		for (uint32_t x = 1000; x < 1000 + 1024; x += 8) {
+			qtree.createLeaf(x, y);
+		}
+	}
+	for (const Spectator& spectator : population) {
+		qtree.addCreature(spectator);
+	}
+
+	size_t qtreeFound = 0;
+	start = std::chrono::steady_clock::now();
+	for (const Position& centerPos : centers) {
+		SpectatorVec spectators;
+		qtree.getSpectators(spectators, centerPos, -11, 11, -11, 11, 0, 9, false);
+		qtreeFound += spectators.size();
+	}
+	auto qtreeTime = std::chrono::steady_clock::now() - start;
+
+	BOOST_TEST(gridFound == qtreeFound);
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	BOOST_TEST_MESSAGE("getSpectators over " << population.size() << " creatures: grid "
+	                                         << duration_cast<microseconds>(gridTime).count() << "us, qtree "
+	                                         << duration_cast<microseconds>(qtreeTime).count() << "us");
+}
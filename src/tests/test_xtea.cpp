@@ -42,3 +42,110 @@ BOOST_AUTO_TEST_CASE(test_xtea_decrypt)
 
 	BOOST_TEST(data == expected);
 }
+
+namespace {
+
+// the original one block at a time implementation
+void referenceEncrypt(uint8_t* data, size_t length, const xtea::round_keys& k)
+{
+	for (auto i = 0u; i < k.size(); i += 2) {
+		for (auto it = data, last = data + length; it < last; it += 8) {
+			uint32_t left, right;
+			std::memcpy(&left, it, 4);
+			std::memcpy(&right, it + 4, 4);
+
+			left += ((right << 4 ^ right >> 5) + right) ^ k[i];
+			right += ((left << 4 ^ left >> 5) + left) ^ k[i + 1];
+
+			std::memcpy(it, &left, 4);
+			std::memcpy(it + 4, &right, 4);
+		}
+	}
+}
+
+std::vector<uint8_t> randomData(std::mt19937& rng, size_t length)
+{
+	std::vector<uint8_t> data(length);
+	std::uniform_int_distribution<int> byte(0, 0xFF);
+	std::generate(data.begin(), data.end(), [&]() { return static_cast<uint8_t>(byte(rng)); });
+	return data;
+}
+
+xtea::round_keys randomKey(std::mt19937& rng)
+{
+	std::uniform_int_distribution<uint32_t> word;
+	return xtea::expand_key({word(rng), word(rng), word(rng), word(rng)});
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_xtea_matches_reference)
+{
+	std::mt19937 rng(1337);
+	auto k = randomKey(rng);
+
+	// every length up to a few vector groups, so each kernel and the scalar tail are used
+	for (size_t length = 0; length <= 1024; length += 8) {
+		auto plain = randomData(rng, length);
+
+		auto expected = plain;
+		referenceEncrypt(expected.data(), expected.size(), k);
+
+		auto data = plain;
+		xtea::encrypt(data.data(), data.size(), k);
+		BOOST_TEST(data == expected);
+
+		xtea::decrypt(data.data(), data.size(), k);
+		BOOST_TEST(data == plain);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_xtea_unaligned)
+{
+	std::mt19937 rng(42);
+	auto k = randomKey(rng);
+
+	auto buffer = randomData(rng, 8 + 520);
+	auto expected = std::vector<uint8_t>(buffer.begin() + 3, buffer.begin() + 3 + 520);
+	referenceEncrypt(expected.data(), expected.size(), k);
+
+	xtea::encrypt(buffer.data() + 3, 520, k);
+	BOOST_TEST(std::vector<uint8_t>(buffer.begin() + 3, buffer.begin() + 3 + 520) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_xtea, *boost::unit_test::label("benchmark") * boost::unit_test::disabled())
+{
+	std::mt19937 rng(7);
+	auto k = randomKey(rng);
+
+	// typical packet sizes, up to a full map description
+	for (size_t length : {64, 512, 4096, 24576}) {
+		auto plain = randomData(rng, length);
+		auto data = plain;
+		size_t iterations = (64 << 20) / length;
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i) {
+			xtea::encrypt(data.data(), data.size(), k);
+		}
+		auto encryptTime = std::chrono::steady_clock::now() - start;
+
+		for (size_t i = 0; i < iterations; ++i) {
+			xtea::decrypt(data.data(), data.size(), k);
+		}
+		BOOST_TEST(data == plain);
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i) {
+			referenceEncrypt(data.data(), data.size(), k);
+		}
+		auto referenceTime = std::chrono::steady_clock::now() - start;
+
+		using std::chrono::duration_cast;
+		using std::chrono::microseconds;
+		auto encryptUs = std::max<int64_t>(duration_cast<microseconds>(encryptTime).count(), 1);
+		auto referenceUs = std::max<int64_t>(duration_cast<microseconds>(referenceTime).count(), 1);
+		BOOST_TEST_MESSAGE("xtea::encrypt " << length << " bytes: " << (64 << 20) / encryptUs << " MB/s, reference "
+		                                    << (64 << 20) / referenceUs << " MB/s");
+	}
+}
@@ -120,7 +120,7 @@ class Tile : public Cylinder
 {
 public:
 	static Tile& nullptr_tile;
-	Tile(uint16_t x, uint16_t y, uint8_t z) : tilePos(x, y, z) {}
+	Tile(uint16_t x, uint16_t y, uint8_t z) : tilePos(x, y, z) { invalidateDescription(); }
 	virtual ~Tile() { delete ground; };
 
 	// non-copyable
@@ -241,7 +241,18 @@ public:
 	Item* getUseItem(int32_t index) const;
 
 	Item* getGround() const { return ground; }
-	void setGround(Item* item) { ground = item; }
+	void setGround(Item* item)
+	{
+		ground = item;
+		invalidateDescription();
+	}
+
+	/**
+	 * Unique value that changes whenever the items of the tile change, which lets serialized copies of them be
+	 * reused until then. Creatures are not part of it as every viewer sees them differently.
+	 */
+	uint32_t getDescriptionVersion() const { return descriptionVersion; }
+	void invalidateDescription();
 
 private:
 	void onAddTileItem(Item* item);
@@ -254,6 +265,7 @@ private:
 	Item* ground = nullptr;
 	Position tilePos;
 	uint32_t flags = 0;
+	uint32_t descriptionVersion;
 };
 
 // Used for walkable tiles, where there is high likeliness of
@@ -7,24 +7,30 @@
 
 #include <cstring>
 
-namespace xtea {
+#if defined(__x86_64__) || defined(_M_X64)
+#define XTEA_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define XTEA_TARGET_AVX2
+#else
+#define XTEA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define XTEA_NEON 1
+#include <arm_neon.h>
+#endif
 
-round_keys expand_key(const key& k)
-{
-	constexpr uint32_t delta = 0x9E3779B9;
-	round_keys expanded;
+namespace xtea {
 
-	for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < expanded.size();
-	     i += 2, sum = next_sum, next_sum += delta) {
-		expanded[i] = sum + k[sum & 3];
-		expanded[i + 1] = next_sum + k[(next_sum >> 11) & 3];
-	}
+namespace {
 
-	return expanded;
-}
+// blocks are independent, so each kernel runs all the rounds on a group of blocks while it sits in registers and
+// returns how many bytes it handled, the remaining blocks are left to the scalar loop
 
-void encrypt(uint8_t* data, size_t length, const round_keys& k)
+void encryptScalar(uint8_t* data, size_t length, const round_keys& k)
 {
+	// rounds outside, so the few blocks left still overlap in the pipeline
 	for (auto i = 0u; i < k.size(); i += 2) {
 		for (auto it = data, last = data + length; it < last; it += 8) {
 			uint32_t left, right;
@@ -40,7 +46,7 @@ void encrypt(uint8_t* data, size_t length, const round_keys& k)
 	}
 }
 
-void decrypt(uint8_t* data, size_t length, const round_keys& k)
+void decryptScalar(uint8_t* data, size_t length, const round_keys& k)
 {
 	for (auto i = k.size(); i > 0; i -= 2) {
 		for (auto it = data, last = data + length; it < last; it += 8) {
@@ -57,4 +63,210 @@ void decrypt(uint8_t* data, size_t length, const round_keys& k)
 	}
 }
 
+#if defined(XTEA_X86)
+
+// SSE2 is part of x86-64, 8 blocks per step as two independent vectors of 4
+__m128i mix(__m128i v) { return _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v, 4), _mm_srli_epi32(v, 5)), v); }
+
+template <bool Encrypt>
+size_t cryptSSE2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t processed = length & ~size_t{63};
+	for (auto it = data, last = data + processed; it < last; it += 64) {
+		__m128i v[4];
+		for (int i = 0; i < 4; ++i) {
+			// L0 R0 L1 R1 -> L0 L1 R0 R1
+			v[i] = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it + i * 16)),
+			                         _MM_SHUFFLE(3, 1, 2, 0));
+		}
+
+		__m128i left0 = _mm_unpacklo_epi64(v[0], v[1]), right0 = _mm_unpackhi_epi64(v[0], v[1]);
+		__m128i left1 = _mm_unpacklo_epi64(v[2], v[3]), right1 = _mm_unpackhi_epi64(v[2], v[3]);
+
+		if constexpr (Encrypt) {
+			for (auto i = 0u; i < k.size(); i += 2) {
+				__m128i k0 = _mm_set1_epi32(k[i]), k1 = _mm_set1_epi32(k[i + 1]);
+				left0 = _mm_add_epi32(left0, _mm_xor_si128(mix(right0), k0));
+				left1 = _mm_add_epi32(left1, _mm_xor_si128(mix(right1), k0));
+				right0 = _mm_add_epi32(right0, _mm_xor_si128(mix(left0), k1));
+				right1 = _mm_add_epi32(right1, _mm_xor_si128(mix(left1), k1));
+			}
+		} else {
+			for (auto i = k.size(); i > 0; i -= 2) {
+				__m128i k0 = _mm_set1_epi32(k[i - 2]), k1 = _mm_set1_epi32(k[i - 1]);
+				right0 = _mm_sub_epi32(right0, _mm_xor_si128(mix(left0), k1));
+				right1 = _mm_sub_epi32(right1, _mm_xor_si128(mix(left1), k1));
+				left0 = _mm_sub_epi32(left0, _mm_xor_si128(mix(right0), k0));
+				left1 = _mm_sub_epi32(left1, _mm_xor_si128(mix(right1), k0));
+			}
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it), _mm_unpacklo_epi32(left0, right0));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it + 16), _mm_unpackhi_epi32(left0, right0));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it + 32), _mm_unpacklo_epi32(left1, right1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it + 48), _mm_unpackhi_epi32(left1, right1));
+	}
+	return processed;
+}
+
+// 16 blocks per step as two independent vectors of 8, the shuffles work within 128 bit lanes so the blocks are
+// reordered inside the registers but written back to where they came from
+XTEA_TARGET_AVX2 __m256i mix(__m256i v)
+{
+	return _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v, 4), _mm256_srli_epi32(v, 5)), v);
+}
+
+template <bool Encrypt>
+XTEA_TARGET_AVX2 size_t cryptAVX2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t processed = length & ~size_t{127};
+	for (auto it = data, last = data + processed; it < last; it += 128) {
+		__m256i v[4];
+		for (int i = 0; i < 4; ++i) {
+			v[i] = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + i * 32)),
+			                            _MM_SHUFFLE(3, 1, 2, 0));
+		}
+
+		__m256i left0 = _mm256_unpacklo_epi64(v[0], v[1]), right0 = _mm256_unpackhi_epi64(v[0], v[1]);
+		__m256i left1 = _mm256_unpacklo_epi64(v[2], v[3]), right1 = _mm256_unpackhi_epi64(v[2], v[3]);
+
+		if constexpr (Encrypt) {
+			for (auto i = 0u; i < k.size(); i += 2) {
+				__m256i k0 = _mm256_set1_epi32(k[i]), k1 = _mm256_set1_epi32(k[i + 1]);
+				left0 = _mm256_add_epi32(left0, _mm256_xor_si256(mix(right0), k0));
+				left1 = _mm256_add_epi32(left1, _mm256_xor_si256(mix(right1), k0));
+				right0 = _mm256_add_epi32(right0, _mm256_xor_si256(mix(left0), k1));
+				right1 = _mm256_add_epi32(right1, _mm256_xor_si256(mix(left1), k1));
+			}
+		} else {
+			for (auto i = k.size(); i > 0; i -= 2) {
+				__m256i k0 = _mm256_set1_epi32(k[i - 2]), k1 = _mm256_set1_epi32(k[i - 1]);
+				right0 = _mm256_sub_epi32(right0, _mm256_xor_si256(mix(left0), k1));
+				right1 = _mm256_sub_epi32(right1, _mm256_xor_si256(mix(left1), k1));
+				left0 = _mm256_sub_epi32(left0, _mm256_xor_si256(mix(right0), k0));
+				left1 = _mm256_sub_epi32(left1, _mm256_xor_si256(mix(right1), k0));
+			}
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it), _mm256_unpacklo_epi32(left0, right0));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it + 32), _mm256_unpackhi_epi32(left0, right0));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it + 64), _mm256_unpacklo_epi32(left1, right1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it + 96), _mm256_unpackhi_epi32(left1, right1));
+	}
+	// a remaining group of 8 blocks still fits the SSE2 kernel
+	return processed + cryptSSE2<Encrypt>(data + processed, length - processed, k);
+}
+
+bool hasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	// the OS must save the AVX registers as well
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(XTEA_NEON)
+
+// 8 blocks per step, the interleaving loads and stores split the blocks into their halves
+uint32x4_t mix(uint32x4_t v) { return vaddq_u32(veorq_u32(vshlq_n_u32(v, 4), vshrq_n_u32(v, 5)), v); }
+
+template <bool Encrypt>
+size_t cryptNEON(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t processed = length & ~size_t{63};
+	for (auto it = data, last = data + processed; it < last; it += 64) {
+		uint32x4x2_t blocks0 = vld2q_u32(reinterpret_cast<const uint32_t*>(it));
+		uint32x4x2_t blocks1 = vld2q_u32(reinterpret_cast<const uint32_t*>(it + 32));
+
+		uint32x4_t &left0 = blocks0.val[0], &right0 = blocks0.val[1];
+		uint32x4_t &left1 = blocks1.val[0], &right1 = blocks1.val[1];
+
+		if constexpr (Encrypt) {
+			for (auto i = 0u; i < k.size(); i += 2) {
+				uint32x4_t k0 = vdupq_n_u32(k[i]), k1 = vdupq_n_u32(k[i + 1]);
+				left0 = vaddq_u32(left0, veorq_u32(mix(right0), k0));
+				left1 = vaddq_u32(left1, veorq_u32(mix(right1), k0));
+				right0 = vaddq_u32(right0, veorq_u32(mix(left0), k1));
+				right1 = vaddq_u32(right1, veorq_u32(mix(left1), k1));
+			}
+		} else {
+			for (auto i = k.size(); i > 0; i -= 2) {
+				uint32x4_t k0 = vdupq_n_u32(k[i - 2]), k1 = vdupq_n_u32(k[i - 1]);
+				right0 = vsubq_u32(right0, veorq_u32(mix(left0), k1));
+				right1 = vsubq_u32(right1, veorq_u32(mix(left1), k1));
+				left0 = vsubq_u32(left0, veorq_u32(mix(right0), k0));
+				left1 = vsubq_u32(left1, veorq_u32(mix(right1), k0));
+			}
+		}
+
+		vst2q_u32(reinterpret_cast<uint32_t*>(it), blocks0);
+		vst2q_u32(reinterpret_cast<uint32_t*>(it + 32), blocks1);
+	}
+	return processed;
+}
+
+#endif
+
+using Kernel = size_t (*)(uint8_t* data, size_t length, const round_keys& k);
+
+size_t noKernel(uint8_t*, size_t, const round_keys&) { return 0; }
+
+struct Kernels
+{
+	Kernel encrypt = noKernel;
+	Kernel decrypt = noKernel;
+};
+
+Kernels selectKernels()
+{
+#if defined(XTEA_X86)
+	if (hasAVX2()) {
+		return {cryptAVX2<true>, cryptAVX2<false>};
+	}
+	return {cryptSSE2<true>, cryptSSE2<false>};
+#elif defined(XTEA_NEON)
+	return {cryptNEON<true>, cryptNEON<false>};
+#else
+	return {};
+#endif
+}
+
+const Kernels kernels = selectKernels();
+
+} // namespace
+
+round_keys expand_key(const key& k)
+{
+	constexpr uint32_t delta = 0x9E3779B9;
+	round_keys expanded;
+
+	for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < expanded.size();
+	     i += 2, sum = next_sum, next_sum += delta) {
+		expanded[i] = sum + k[sum & 3];
+		expanded[i + 1] = next_sum + k[(next_sum >> 11) & 3];
+	}
+
+	return expanded;
+}
+
+void encrypt(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t processed = kernels.encrypt(data, length, k);
+	encryptScalar(data + processed, length - processed, k);
+}
+
+void decrypt(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t processed = kernels.decrypt(data, length, k);
+	decryptScalar(data + processed, length - processed, k);
+}
+
 } // namespace xtea